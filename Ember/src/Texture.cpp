@@ -68,6 +68,8 @@ namespace Ember {
 	}
 
 	void Texture::Init(uint32_t width, uint32_t height) {
+		this->width = width;
+		this->height = height;
 		internal_format = GL_RGBA8;
 		data_format = GL_RGBA;
 
@@ -0,0 +1,118 @@
+#include "AdaptiveSampler.h"
+
+#include <cmath>
+
+namespace MatLib {
+	AdaptiveSampler::AdaptiveSampler(FunctionSolver* solver) {
+		this->solver = solver;
+	}
+
+	void AdaptiveSampler::SetFunction(size_t assignment) {
+		this->assignment = assignment;
+		Reset();
+	}
+
+	void AdaptiveSampler::SetView(const SamplerView& view) {
+		if (view.x0 != this->view.x0 || view.x1 != this->view.x1 || view.y0 != this->view.y0 || view.y1 != this->view.y1 ||
+			view.width != this->view.width || view.height != this->view.height) {
+			this->view = view;
+			Reset();
+		}
+	}
+
+	void AdaptiveSampler::Reset() {
+		points.clear();
+		pending = std::priority_queue<Pending>();
+		stats = SamplerStatistics();
+		initialized = false;
+	}
+
+	double AdaptiveSampler::Evaluate(double x) {
+		stats.evaluations++;
+		return solver->Evaluate(assignment, x);
+	}
+
+	uint32_t AdaptiveSampler::AddPoint(double x, double y, uint32_t next) {
+		SamplePoint point;
+		point.x = x;
+		point.y = y;
+		point.next = next;
+		points.push_back(point);
+		stats.points++;
+		return (uint32_t)points.size() - 1;
+	}
+
+	//Samples the midpoint of [left, left.next] and keeps it as a vertex either way so no evaluation is wasted. Splitting at the
+	//midpoint cuts the chord error of a smooth curve by about four, so only deviations above 4x the tolerance are refined further
+	void AdaptiveSampler::Probe(uint32_t left) {
+		const SamplePoint& a = points[left];
+		const SamplePoint& b = points[a.next];
+
+		Pending p;
+		p.left = left;
+		p.mx = 0.5 * (a.x + b.x);
+		p.my = Evaluate(p.mx);
+
+		double px_y = view.height / (view.y1 - view.y0);
+		if (!std::isfinite(a.y) || !std::isfinite(b.y) || !std::isfinite(p.my))
+			p.error = (std::isfinite(a.y) == std::isfinite(b.y) && std::isfinite(a.y) == std::isfinite(p.my)) ? 0.0 : HUGE_VAL;
+		else if ((a.y > view.y1 && b.y > view.y1 && p.my > view.y1) || (a.y < view.y0 && b.y < view.y0 && p.my < view.y0))
+			p.error = 0.0;
+		else
+			p.error = fabs(p.my - 0.5 * (a.y + b.y)) * px_y;
+
+		if (p.error > 4.0 * tolerance)
+			pending.push(p);
+		else {
+			uint32_t mid = AddPoint(p.mx, p.my, p.left);
+			points[mid].next = points[left].next;
+			points[left].next = mid;
+		}
+	}
+
+	//Refines the worst intervals first, a non-zero budget caps evaluations per call so a frame never stalls
+	bool AdaptiveSampler::Sample(uint32_t budget) {
+		if (!solver || !(view.x0 < view.x1) || !(view.y0 < view.y1) || view.width == 0 || view.height == 0)
+			return true;
+
+		uint32_t start = stats.evaluations;
+		if (!initialized) {
+			uint32_t n = (initial_intervals > 0) ? initial_intervals : 1;
+			points.reserve(4 * n);
+			for (uint32_t i = 0; i <= n; i++) {
+				double x = (i == n) ? view.x1 : view.x0 + (view.x1 - view.x0) * i / n;
+				AddPoint(x, Evaluate(x), (i == n) ? SAMPLER_INVALID : i + 1);
+			}
+			for (uint32_t i = 0; i < n; i++)
+				Probe(i);
+			initialized = true;
+		}
+
+		double px_x = view.width / (view.x1 - view.x0);
+		double px_y = view.height / (view.y1 - view.y0);
+		while (!pending.empty() && (budget == 0 || stats.evaluations - start < budget)) {
+			Pending p = pending.top();
+			pending.pop();
+
+			uint32_t left = p.left;
+			uint32_t right = points[left].next;
+			if ((points[right].x - points[left].x) * px_x < min_width) {
+				//Still bending below a fraction of a pixel, a jump of more than a screen is treated as a discontinuity
+				double jump = fabs(points[right].y - points[left].y) * px_y;
+				if (!(jump <= view.height)) {
+					points[left].broken = true;
+					stats.breaks++;
+				}
+				continue;
+			}
+
+			uint32_t mid = AddPoint(p.mx, p.my, right);
+			points[left].next = mid;
+			Probe(left);
+			Probe(mid);
+		}
+
+		stats.pending = (uint32_t)pending.size();
+		return pending.empty();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include "FunctionSolver.h"
+
+#include <queue>
+
+namespace MatLib {
+	struct SamplePoint {
+		double x = 0.0;
+		double y = 0.0;
+		uint32_t next = 0;
+		bool broken = false;
+	};
+
+	struct SamplerView {
+		double x0 = -10.0, x1 = 10.0;
+		double y0 = -10.0, y1 = 10.0;
+		uint32_t width = 1280, height = 720;
+
+		bool operator==(const SamplerView& other) const {
+			return x0 == other.x0 && x1 == other.x1 && y0 == other.y0 && y1 == other.y1 && width == other.width && height == other.height;
+		}
+	};
+
+	struct SamplerStatistics {
+		uint32_t evaluations = 0;
+		uint32_t points = 0;
+		uint32_t pending = 0;
+		uint32_t breaks = 0;
+	};
+
+	constexpr uint32_t SAMPLER_INVALID = 0xFFFFFFFF;
+
+	class AdaptiveSampler {
+	public:
+		AdaptiveSampler() = default;
+		AdaptiveSampler(FunctionSolver* solver);
+
+		void SetFunction(size_t assignment);
+		void SetView(const SamplerView& view);
+		void Reset();
+		bool Sample(uint32_t budget = 0);
+		bool Done() const { return initialized && pending.empty(); }
+
+		template <typename Fn>
+		void ForEachSegment(const Fn& fn) const;
+
+		const std::vector<SamplePoint>& Points() const { return points; }
+		uint32_t First() const { return (points.empty()) ? SAMPLER_INVALID : 0; }
+		const SamplerStatistics& Statistics() const { return stats; }
+
+		double tolerance = 0.5;
+		double min_width = 0.25;
+		uint32_t initial_intervals = 16;
+	private:
+		struct Pending {
+			double error;
+			uint32_t left;
+			double mx, my;
+
+			bool operator<(const Pending& other) const { return error < other.error; }
+		};
+
+		FunctionSolver* solver = nullptr;
+		size_t assignment = 0;
+		SamplerView view;
+		bool initialized = false;
+
+		std::vector<SamplePoint> points;
+		std::priority_queue<Pending> pending;
+		SamplerStatistics stats;
+	private:
+		double Evaluate(double x);
+		void Probe(uint32_t left);
+		uint32_t AddPoint(double x, double y, uint32_t next);
+	};
+
+	//Calls fn(a, b) for every connected pair of points, skipping jumps and undefined regions
+	template <typename Fn>
+	void AdaptiveSampler::ForEachSegment(const Fn& fn) const {
+		if (points.empty())
+			return;
+		for (uint32_t i = 0; points[i].next != SAMPLER_INVALID; i = points[i].next) {
+			const SamplePoint& a = points[i];
+			const SamplePoint& b = points[a.next];
+			if (!a.broken && std::isfinite(a.y) && std::isfinite(b.y))
+				fn(a, b);
+		}
+	}
+}
+
+#endif // !ADAPTIVE_SAMPLER_H
\ No newline at end of file
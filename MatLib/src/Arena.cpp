@@ -0,0 +1,86 @@
+#include "Arena.h"
+
+namespace MatLib {
+	Arena::Arena(size_t block_size) : block_size(block_size) { }
+
+	Arena::~Arena() {
+		RunCleanups();
+	}
+
+	void* Arena::Allocate(size_t size, size_t align) {
+		for (int attempt = 0; attempt < 2; attempt++) {
+			if (!blocks.empty()) {
+				uintptr_t base = (uintptr_t)blocks[current].data.get();
+				uintptr_t ptr = (base + offset + align - 1) & ~(uintptr_t)(align - 1);
+				if (ptr + size <= base + blocks[current].size) {
+					offset = (size_t)(ptr - base) + size;
+					stats.allocations++;
+					stats.bytes_used += size;
+					return (void*)ptr;
+				}
+			}
+			NextBlock(size, align);
+		}
+		return nullptr;
+	}
+
+	bool Arena::NextBlock(size_t size, size_t align) {
+		size_t needed = size + align;
+		if (!blocks.empty() && current + 1 < blocks.size() && blocks[current + 1].size >= needed) {
+			current++;
+			offset = 0;
+			return false;
+		}
+
+		Block block;
+		block.size = (needed > block_size) ? needed : block_size;
+		block.data.reset(new uint8_t[block.size]);
+		stats.bytes_reserved += block.size;
+		stats.block_allocations++;
+
+		if (blocks.empty()) {
+			blocks.push_back(std::move(block));
+			current = 0;
+		}
+		else {
+			blocks.insert(blocks.begin() + current + 1, std::move(block));
+			current++;
+		}
+		offset = 0;
+		stats.blocks = blocks.size();
+		return true;
+	}
+
+	void Arena::AddCleanup(void* object, void (*destroy)(void*)) {
+		Cleanup* cleanup = new (Allocate(sizeof(Cleanup), alignof(Cleanup))) Cleanup;
+		cleanup->object = object;
+		cleanup->destroy = destroy;
+		cleanup->next = cleanups;
+		cleanups = cleanup;
+		stats.cleanups++;
+	}
+
+	void Arena::RunCleanups() {
+		for (Cleanup* cleanup = cleanups; cleanup; cleanup = cleanup->next)
+			cleanup->destroy(cleanup->object);
+		cleanups = nullptr;
+	}
+
+	//Keeps the blocks around so the next tree is built without touching the heap
+	void Arena::Reset() {
+		RunCleanups();
+		current = 0;
+		offset = 0;
+		stats.allocations = 0;
+		stats.bytes_used = 0;
+		stats.cleanups = 0;
+		stats.resets++;
+	}
+
+	void Arena::Release() {
+		Reset();
+		blocks.clear();
+		stats.blocks = 0;
+		stats.bytes_reserved = 0;
+	}
+}
\ No newline at end of file
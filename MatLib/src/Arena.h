@@ -0,0 +1,70 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace MatLib {
+	constexpr size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+	struct ArenaStatistics {
+		size_t allocations = 0;
+		size_t bytes_used = 0;
+		size_t bytes_reserved = 0;
+		size_t blocks = 0;
+		size_t block_allocations = 0;
+		size_t cleanups = 0;
+		size_t resets = 0;
+	};
+
+	class Arena {
+	public:
+		Arena(size_t block_size = ARENA_BLOCK_SIZE);
+		~Arena();
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		void* Allocate(size_t size, size_t align = alignof(std::max_align_t));
+		void Reset();
+		void Release();
+
+		template <typename T, typename... Args>
+		T* New(Args&&... args) {
+			T* object = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+			if (!std::is_trivially_destructible<T>::value)
+				AddCleanup(object, [](void* ptr) { static_cast<T*>(ptr)->~T(); });
+			return object;
+		}
+
+		const ArenaStatistics& Statistics() const { return stats; }
+	private:
+		struct Block {
+			std::unique_ptr<uint8_t[]> data;
+			size_t size = 0;
+		};
+
+		struct Cleanup {
+			void* object = nullptr;
+			void (*destroy)(void*) = nullptr;
+			Cleanup* next = nullptr;
+		};
+
+		std::vector<Block> blocks;
+		size_t block_size = ARENA_BLOCK_SIZE;
+		size_t current = 0;
+		size_t offset = 0;
+		Cleanup* cleanups = nullptr;
+		ArenaStatistics stats;
+	private:
+		void AddCleanup(void* object, void (*destroy)(void*));
+		void RunCleanups();
+		bool NextBlock(size_t size, size_t align);
+	};
+}
+
+#endif // !ARENA_H
\ No newline at end of file
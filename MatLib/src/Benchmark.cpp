@@ -0,0 +1,1163 @@
+#include "Benchmark.h"
+#include "FunctionSolver.h"
+#include "Kernels.h"
+#include "AdaptiveSampler.h"
+#include "ImplicitSampler.h"
+#include "DomainColoring.h"
+#include "Document.h"
+#include "ProgramCache.h"
+#include "Optimizer.h"
+#include "HashCons.h"
+#include "Gemm.h"
+#include "ConjugateGradient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+namespace MatLib {
+	namespace Benchmark {
+		using Clock = std::chrono::high_resolution_clock;
+
+		static double ElapsedNs(Clock::time_point start) {
+			return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		}
+
+		std::string DeepExpression(uint32_t depth) {
+			std::string source = "a = ";
+			for (uint32_t i = 0; i < depth; i++)
+				source += "(" + std::to_string(i % 7 + 1) + ((i % 2) ? "*" : "+");
+			source += "1";
+			for (uint32_t i = 0; i < depth; i++)
+				source += ")";
+			return source;
+		}
+
+		std::string WideExpression(uint32_t width) {
+			std::string source = "a = 1";
+			for (uint32_t i = 1; i < width; i++)
+				source += ((i % 2) ? "+" : "-") + std::to_string(i % 9 + 1) + "*" + std::to_string(i % 5 + 1);
+			return source;
+		}
+
+		static void Compare(const char* name, const std::string& source, uint32_t iterations) {
+			Lexer lexer;
+			lexer.Input(source);
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			if (!parser.Root() || parser.Root()->procedures.empty()) {
+				printf("%s: failed to parse\n", name);
+				return;
+			}
+
+			FunctionSolver solver(&parser);
+			solver.Compile();
+			Ast_Expression* expr = parser.Root()->procedures[0]->expr;
+
+			volatile double sink = 0.0;
+			auto start = Clock::now();
+			for (uint32_t i = 0; i < iterations; i++)
+				sink = solver.SolveExpression(expr);
+			double tree = ElapsedNs(start) / iterations;
+
+			start = Clock::now();
+			for (uint32_t i = 0; i < iterations; i++)
+				sink = solver.Evaluate(0);
+			double vm = ElapsedNs(start) / iterations;
+
+			printf("%s: tree %.1f ns/eval, vm %.1f ns/eval, %.2fx (%zu instructions, result %f)\n", name, tree, vm, tree / vm,
+				solver.GetProgram().assignments[0].chunk.code.size(), (double)sink);
+		}
+
+		void RunEvaluator(uint32_t iterations) {
+			printf("----Evaluator Benchmark----\n");
+			Compare("deep 64", DeepExpression(64), iterations);
+			Compare("deep 256", DeepExpression(256), iterations / 4);
+			Compare("wide 64", WideExpression(64), iterations);
+			Compare("wide 1024", WideExpression(1024), iterations / 16);
+		}
+
+		void RunBatch(uint32_t samples) {
+			printf("----Batch Benchmark (%s)----\n", Kernels::InstructionSet());
+			Lexer lexer;
+			lexer.Input("y = (x*x+1)/(x*x-1) - -x*3 + x/7");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			if (!parser.Root() || parser.Root()->procedures.empty())
+				return;
+
+			FunctionSolver solver(&parser);
+			solver.Compile();
+			Ast_Expression* expr = parser.Root()->procedures[0]->expr;
+
+			std::vector<double> xs(samples), out(samples);
+			for (uint32_t i = 0; i < samples; i++)
+				xs[i] = -10.0 + 20.0 * i / samples;
+
+			auto start = Clock::now();
+			for (uint32_t i = 0; i < samples; i++) {
+				solver.SetInputValue(xs[i]);
+				out[i] = solver.SolveExpression(expr);
+			}
+			double tree = ElapsedNs(start) / samples;
+
+			start = Clock::now();
+			for (uint32_t i = 0; i < samples; i++)
+				out[i] = solver.Evaluate(0, xs[i]);
+			double vm = ElapsedNs(start) / samples;
+
+			start = Clock::now();
+			solver.EvaluateBatch(expr, xs.data(), out.data(), samples);
+			double batch = ElapsedNs(start) / samples;
+
+			printf("%u samples: tree %.2f ns/point, vm %.2f ns/point, batch %.2f ns/point\n", samples, tree, vm, batch);
+		}
+
+		void RunDual(uint32_t iterations) {
+			printf("----Forward Mode Benchmark----\n");
+			Lexer lexer;
+			lexer.Input(WideExpression(64) + "*x - x^3/(x*x+1)");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			if (!parser.Root() || parser.Root()->procedures.empty())
+				return;
+
+			Interpreter interpreter(&parser);
+			interpreter.SetInputValue(1.25);
+			Ast_Expression* expr = parser.Root()->procedures[0]->expr;
+
+			volatile double sink = 0.0;
+			auto start = Clock::now();
+			for (uint32_t i = 0; i < iterations; i++)
+				sink = interpreter.SolveExpression(expr);
+			double plain = ElapsedNs(start) / iterations;
+
+			start = Clock::now();
+			for (uint32_t i = 0; i < iterations; i++)
+				sink = interpreter.SolveDual(expr).derivative;
+			double dual = ElapsedNs(start) / iterations;
+
+			std::vector<std::string> variables = { "x" };
+			double value = 1.25, gradient = 0.0;
+			start = Clock::now();
+			for (uint32_t i = 0; i < iterations; i++)
+				sink = interpreter.SolveGradient(expr, variables, &value, &gradient);
+			double grad = ElapsedNs(start) / iterations;
+
+			printf("plain %.1f ns, dual %.1f ns (%.2fx), gradient[%zu] %.1f ns (%.2fx), result %f\n", plain, dual, dual / plain, GRADIENT_WIDTH, grad,
+				grad / plain, (double)sink);
+		}
+
+		//Not a timing: the batch, dual and interval paths on a name assigned from x, which has to move with the input
+		//rather than read whatever the last Execute left behind
+		void RunGlobals() {
+			printf("----Global Definitions Check----\n");
+			Lexer lexer;
+			lexer.Input("a = x ^ 2\nf = a + 1");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			if (!parser.Root() || parser.Root()->procedures.size() < 2)
+				return;
+
+			Interpreter interpreter(&parser);
+			Ast_Expression* expr = parser.Root()->procedures[1]->expr;
+			uint32_t failures = 0;
+
+			double xs[] = { 0.0, 1.0, 2.0, 3.0 }, out[4];
+			interpreter.EvaluateBatch(expr, xs, out, 4);
+			for (size_t i = 0; i < 4; i++)
+				failures += out[i] != xs[i] * xs[i] + 1.0;
+
+			interpreter.SetInputValue(3.0);
+			Dual d = interpreter.SolveDual(expr);
+			failures += d.value != 10.0 || d.derivative != 6.0;
+
+			std::vector<std::string> variables = { "x" };
+			double value = 3.0, gradient = 0.0;
+			failures += interpreter.SolveGradient(expr, variables, &value, &gradient) != 10.0 || gradient != 6.0;
+
+			Interval range = interpreter.SolveInterval(expr, Interval(-1.0, 1.0));
+			failures += range.lo > 1.0 || range.hi < 2.0 || range.lo < 0.0 || range.hi > 2.5;
+
+			printf("batch %g %g %g %g, f'(3) = %g, f([-1, 1]) = [%g, %g]: %s\n", out[0], out[1], out[2], out[3], d.derivative, range.lo, range.hi,
+				(failures) ? "FAILED" : "ok");
+		}
+
+		struct Polyline {
+			std::vector<double> xs, ys;
+			std::vector<char> broken;
+		};
+
+		//Largest on-screen distance in pixels from the function to the polyline, skipping gaps the sampler left open
+		static double PlotError(FunctionSolver& solver, const Polyline& line, const Polyline& gaps, const SamplerView& view) {
+			const uint32_t checks = 20000;
+			double px_x = view.width / (view.x1 - view.x0), px_y = view.height / (view.y1 - view.y0), worst = 0.0;
+			auto clip = [&](double y) { return (y < view.y0) ? view.y0 : (y > view.y1) ? view.y1 : y; };
+			size_t seg = 0, gap = 0;
+			for (uint32_t i = 0; i <= checks; i++) {
+				double x = view.x0 + (view.x1 - view.x0) * i / checks;
+				while (seg + 2 < line.xs.size() && line.xs[seg + 1] < x)
+					seg++;
+				while (gap + 2 < gaps.xs.size() && gaps.xs[gap + 1] < x)
+					gap++;
+				if (gaps.broken[gap] || !std::isfinite(gaps.ys[gap]) || !std::isfinite(gaps.ys[gap + 1]))
+					continue;
+
+				double t = (x - line.xs[seg]) / (line.xs[seg + 1] - line.xs[seg]);
+				double y = line.ys[seg] + t * (line.ys[seg + 1] - line.ys[seg]);
+				double slope = (clip(line.ys[seg + 1]) - clip(line.ys[seg])) * px_y / ((line.xs[seg + 1] - line.xs[seg]) * px_x);
+				double e = fabs(clip(y) - clip(solver.Evaluate(0, x))) * px_y / sqrt(1.0 + slope * slope);
+				if (!(e <= worst))
+					worst = e;
+			}
+			return worst;
+		}
+
+		static Polyline Uniform(FunctionSolver& solver, const SamplerView& view, uint32_t n) {
+			Polyline line;
+			for (uint32_t i = 0; i < n; i++) {
+				line.xs.push_back(view.x0 + (view.x1 - view.x0) * i / (n - 1));
+				line.ys.push_back(solver.Evaluate(0, line.xs.back()));
+				line.broken.push_back(0);
+			}
+			return line;
+		}
+
+		void RunSampler() {
+			printf("----Adaptive Sampler Benchmark----\n");
+			//The cubic is where adaptive sampling loses, by about 15% (77 evaluations against 66). Its curvature is nearly even,
+			//and every halving quarters the chord error, so finished intervals land anywhere from a quarter of the tolerance up
+			//to all of it while a uniform grid can sit right at it everywhere
+			const char* functions[] = { "y = x*x*x/20 - x", "y = 1/(x*x*100+1)*8", "y = x^7/4000000 + 1/(x*2-1)/10" };
+			for (auto source : functions) {
+				Lexer lexer;
+				lexer.Input(source);
+				lexer.Run();
+				Parser parser(&lexer);
+				parser.Run();
+				FunctionSolver solver(&parser);
+				solver.Compile();
+
+				SamplerView view;
+				AdaptiveSampler sampler(&solver);
+				sampler.SetView(view);
+				sampler.Sample();
+
+				Polyline adaptive;
+				for (uint32_t i = sampler.First(); i != SAMPLER_INVALID; i = sampler.Points()[i].next) {
+					adaptive.xs.push_back(sampler.Points()[i].x);
+					adaptive.ys.push_back(sampler.Points()[i].y);
+					adaptive.broken.push_back(sampler.Points()[i].broken);
+				}
+				double error = PlotError(solver, adaptive, adaptive, view);
+				uint32_t evaluations = sampler.Statistics().evaluations;
+
+				//Smallest uniform sample count that is at least as accurate, found by doubling and bisecting
+				double target = (error > 0.0) ? error : sampler.tolerance;
+				uint32_t low = 2, high = 2;
+				while (high < (1u << 20) && PlotError(solver, Uniform(solver, view, high), adaptive, view) > target)
+					high *= 2;
+				while (low + 1 < high) {
+					uint32_t mid = (low + high) / 2;
+					if (PlotError(solver, Uniform(solver, view, mid), adaptive, view) > target)
+						low = mid;
+					else
+						high = mid;
+				}
+
+				printf("%s: adaptive %u evaluations (%.2f px), uniform needs %u for %.2f px\n", source, evaluations, error, high, target);
+			}
+		}
+
+		void RunRoots(uint32_t samples) {
+			printf("----Root Culling Benchmark----\n");
+			Lexer lexer;
+			lexer.Input("a = x^3 - 2*x - 5");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			if (!parser.Root() || parser.Root()->procedures.empty())
+				return;
+
+			FunctionSolver solver(&parser);
+			solver.Compile();
+
+			RootOptions options;
+			options.samples = samples;
+			options.cull = false;
+			auto start = Clock::now();
+			size_t full = solver.FindRoots(0, -1000.0, 1000.0, options).size();
+			double scan = ElapsedNs(start) / 1e6;
+
+			options.cull = true;
+			start = Clock::now();
+			size_t culled = solver.FindRoots(0, -1000.0, 1000.0, options).size();
+			double pruned = ElapsedNs(start) / 1e6;
+
+			Interval bound = solver.EvaluateInterval(0, Interval(10.0, 20.0));
+			printf("full scan %.2f ms (%zu roots), culled %.2f ms (%zu roots, %.1fx), f([10, 20]) in [%g, %g]\n", scan, full, pruned, culled, scan / pruned, bound.lo, bound.hi);
+		}
+
+		void RunImplicit(uint32_t width, uint32_t height) {
+			printf("----Implicit Plot Benchmark (%ux%u)----\n", width, height);
+			const char* relations[] = { "x^2 + y^2 = 9", "y^2 = x^3 - 4*x + 1", "x^4 + y^4 - 6*x*y = 1", "y*x^2 - x*y^3 = 2" };
+			ThreadPool pool;
+
+			for (auto source : relations) {
+				Lexer lexer;
+				lexer.Input(source);
+				lexer.Run();
+				Parser parser(&lexer);
+				parser.Run();
+				FunctionSolver solver(&parser);
+				solver.Compile();
+
+				SamplerView view;
+				view.x0 = -8.0;
+				view.x1 = 8.0;
+				view.y0 = -4.5;
+				view.y1 = 4.5;
+				view.width = width;
+				view.height = height;
+
+				ImplicitSampler sampler(&solver, &pool);
+				sampler.SetView(view);
+				sampler.Sample();
+
+				//Panning by a pixel forces a full retrace, which is what an interactive frame costs
+				view.x0 += 16.0 / width;
+				view.x1 += 16.0 / width;
+				sampler.SetView(view);
+				sampler.Sample();
+
+				auto& stats = sampler.Statistics();
+				double grid = (width / sampler.resolution + 1) * (height / sampler.resolution + 1);
+				printf("%s: %.2f ms on %zu threads, %u cells (%u culled), %u segments, %u evaluations vs %.0f for a full grid\n",
+					source, stats.milliseconds, pool.Threads(), stats.cells, stats.culled, stats.segments, stats.evaluations, grid);
+			}
+		}
+
+		//The character at a time lexer that Lexer replaced, kept only as the baseline for RunLexer
+		class LegacyLexer {
+		public:
+			struct LegacyToken {
+				int type = 0;
+				uint32_t line = 0;
+				double num_const = 0.0;
+				std::string id = "";
+			};
+
+			LegacyLexer() {
+				symbols[Tok::T_LTE] = "<=";
+				symbols[Tok::T_GTE] = ">=";
+				symbols[Tok::T_DOUBLE_EQUAL] = "==";
+				symbols[Tok::T_NOT] = "!=";
+			}
+
+			void Input(const std::string& input) { this->input = input; }
+			std::vector<LegacyToken>& Tokens() { return tokens; }
+
+			void Run() {
+				current_character = 0;
+				current_line = 1;
+				while (current_character < input.size()) {
+					if (input[current_character] == '\n') {
+						current_line++;
+						current_character++;
+						CreateToken(Tok::T_NEWLINE);
+						continue;
+					}
+
+					working += input[current_character];
+
+					if (current_possible_token_type == TokenCategories::NONE) {
+						if (isdigit(working.back()))
+							current_possible_token_type = TokenCategories::NUMERIC;
+						else if (isalpha(working.back()))
+							current_possible_token_type = TokenCategories::ID;
+						else if (working.back() != ' ')
+							current_possible_token_type = TokenCategories::SYMBOL;
+					}
+
+					if (current_possible_token_type == TokenCategories::NUMERIC && (Limit() || !IsDigit(1))) {
+						CreateToken(Tok::T_NUM_CONST);
+						tokens.back().num_const = atoi(working.c_str());
+						ResetStatus();
+					}
+					else if (current_possible_token_type == TokenCategories::ID && (Limit() || !IsCharacter(1) || NextChar() == ' ')) {
+						std::string temp = SpaceLess();
+						ReadTill(temp, [&]() {
+							return (!Limit() && IsCharacter(1) && NextChar() != ' ');
+						});
+						if (Search(temp, keywords)) continue;
+						else {
+							CreateToken(Tok::T_IDENTIFIER);
+							tokens.back().id = working;
+							ResetStatus();
+						}
+					}
+					else if (current_possible_token_type == TokenCategories::SYMBOL) {
+						std::string temp = SpaceLess();
+						uint32_t offset = ReadTill(temp, [&]() {
+							return (!Limit() && IsSymbol(1) && NextChar() != ' ');
+						});
+						if (Search(temp, symbols)) continue;
+						else {
+							CreateToken(working[0]);
+							tokens.back().id = working;
+							current_character -= offset;
+							ResetStatus();
+						}
+					}
+
+					current_character++;
+				}
+
+				CreateToken(Tok::T_EOF);
+				ResetStatus();
+			}
+		private:
+			enum class TokenCategories {
+				NONE,
+				NUMERIC,
+				ID,
+				SYMBOL
+			};
+
+			std::string input;
+			std::vector<LegacyToken> tokens;
+			TokenCategories current_possible_token_type = TokenCategories::NONE;
+			std::string working;
+			std::unordered_map<int, std::string> symbols;
+			std::unordered_map<int, std::string> keywords;
+			uint32_t current_character = 0;
+			uint32_t current_line = 0;
+		private:
+			void CreateToken(int type) {
+				tokens.push_back(LegacyToken());
+				tokens.back().type = type;
+				tokens.back().line = current_line;
+			}
+
+			bool Search(const std::string& possible, std::unordered_map<int, std::string>& search) {
+				for (auto& s : search) {
+					if (s.second == possible) {
+						CreateToken(s.first);
+						current_character++;
+						ResetStatus();
+						return true;
+					}
+				}
+				return false;
+			}
+
+			char NextChar() { return input[(current_character + 1) % input.size()]; }
+			bool IsDigit(uint32_t offset = 0) { return (isdigit(input[current_character + offset])); }
+			bool IsCharacter(uint32_t offset = 0) { return (isalpha(input[current_character + offset])); }
+			bool IsSymbol(uint32_t offset = 0) { return (!IsDigit(offset) && !IsCharacter(offset)); }
+			bool Limit() { return (current_character + 1 == input.size()); }
+
+			void ResetStatus() {
+				current_possible_token_type = TokenCategories::NONE;
+				working.clear();
+			}
+
+			uint32_t ReadTill(std::string& temp, const std::function<bool(void)>& condition) {
+				uint32_t offset = 0;
+				while (condition()) {
+					temp += input[current_character + 1];
+					current_character++;
+					offset++;
+				}
+				return offset;
+			}
+
+			std::string SpaceLess() {
+				working.erase(std::remove_if(working.begin(), working.end(), isspace), working.end());
+				return working;
+			}
+		};
+
+		//Letters only and no decimals, so both lexers see the same token stream
+		static std::string LexerScript(uint32_t lines) {
+			static const char* names[] = { "alpha", "x", "beta", "y", "gamma", "delta" };
+			std::string source;
+			for (uint32_t i = 0; i < lines; i++) {
+				source += names[i % 6];
+				source += " = (x + " + std::to_string(i % 97) + ") * " + names[(i + 1) % 6] + " - " + std::to_string(i * 31 % 1000);
+				source += " / (y ^ 2 + " + std::to_string(i % 13 + 1) + ") <= x\n";
+			}
+			return source;
+		}
+
+		void RunLexer(uint32_t lines) {
+			printf("----Lexer Benchmark (%u lines)----\n", lines);
+			std::string source = LexerScript(lines);
+			double megabytes = source.size() / (1024.0 * 1024.0);
+
+			LegacyLexer legacy;
+			legacy.Input(source);
+			auto start = Clock::now();
+			legacy.Run();
+			double old_seconds = ElapsedNs(start) * 1e-9;
+
+			Lexer lexer;
+			lexer.Input(source);
+			lexer.Run();
+			const uint32_t repeats = 20;
+			start = Clock::now();
+			for (uint32_t i = 0; i < repeats; i++)
+				lexer.Run();
+			double new_seconds = ElapsedNs(start) * 1e-9 / repeats;
+
+			size_t mismatches = (legacy.Tokens().size() == lexer.Tokens().size()) ? 0 : 1;
+			for (size_t i = 0; i < legacy.Tokens().size() && i < lexer.Tokens().size(); i++)
+				if (legacy.Tokens()[i].type != lexer.Tokens()[i].type || legacy.Tokens()[i].num_const != lexer.Tokens()[i].num_const ||
+					legacy.Tokens()[i].line != lexer.Tokens()[i].line)
+					mismatches++;
+
+			printf("%.2f MB, %zu tokens: legacy %.1f MB/s, table driven %.1f MB/s (%.1fx), %zu mismatched tokens\n", megabytes, lexer.Tokens().size(),
+				megabytes / old_seconds, megabytes / new_seconds, old_seconds / new_seconds, mismatches);
+		}
+
+		void RunEditor(uint32_t lines) {
+			printf("----Editor Benchmark (%u lines)----\n", lines);
+			std::string source;
+			for (uint32_t i = 0; i < lines; i++)
+				source += "f" + std::to_string(i) + " = (x + " + std::to_string(i % 97) + ") * x - " + std::to_string(i * 31 % 1000) + " / (x ^ 2 + 1)\n";
+
+			Lexer lexer;
+			Parser parser(&lexer);
+			Document document(&lexer, &parser);
+			document.Sync(source);
+			document.Update();
+
+			//Retype one digit in the middle line, the editor only sees the new text like it would from the widget
+			size_t position = source.find(" = ", source.size() / 2) + 5;
+			const uint32_t edits = 200;
+			auto start = Clock::now();
+			for (uint32_t i = 0; i < edits; i++) {
+				source[position] = '0' + (i % 10);
+				document.Sync(source);
+				document.Update();
+			}
+			double incremental = ElapsedNs(start) * 1e-6 / edits;
+			size_t incremental_statements = parser.Root()->procedures.size();
+
+			start = Clock::now();
+			for (uint32_t i = 0; i < edits / 10; i++) {
+				source[position] = '0' + (i % 10);
+				lexer.Input(source);
+				lexer.Run();
+				parser.Run();
+			}
+			double full = ElapsedNs(start) * 1e-6 / (edits / 10);
+
+			auto& stats = document.Statistics();
+			printf("incremental %.3f ms/edit (%u lines re-lexed, %u statements reused), full re-lex and parse %.3f ms (%.1fx), %zu vs %zu statements\n",
+				incremental, stats.relexed, stats.reused, full, full / incremental, incremental_statements, parser.Root()->procedures.size());
+		}
+
+		void RunCache(uint32_t lines) {
+			printf("----Program Cache Benchmark (%u lines)----\n", lines);
+			std::string source;
+			for (uint32_t i = 0; i < lines; i++)
+				source += "f" + std::to_string(i) + " = (x + " + std::to_string(i % 97) + ") * x - " + std::to_string(i * 31 % 1000) + " / (x ^ 2 + 1)\n";
+
+			Lexer lexer;
+			Parser parser(&lexer);
+			Optimizer optimizer(&parser);
+			FunctionSolver solver(&parser);
+			ProgramCache cache;
+
+			auto start = Clock::now();
+			lexer.Input(source);
+			lexer.Run();
+			parser.Run();
+			optimizer.Run();
+			solver.Compile();
+			cache.Insert(source, 0, solver.GetProgram());
+			double miss = ElapsedNs(start) * 1e-3;
+
+			const uint32_t repeats = 1000;
+			size_t assignments = 0;
+			start = Clock::now();
+			for (uint32_t i = 0; i < repeats; i++)
+				if (const Program* cached = cache.Find(source, 0)) {
+					solver.SetProgram(*cached);
+					assignments += solver.GetProgram().assignments.size();
+				}
+			double hit = ElapsedNs(start) * 1e-3 / repeats;
+
+			printf("miss %.1f us, hit %.1f us (%.0fx), %zu bytes cached, %zu assignments per hit\n", miss, hit, miss / hit, cache.Statistics().bytes, assignments / repeats);
+
+			//A replacement too large for the budget drops the old entry and leaves the statistics empty with it
+			Program larger = solver.GetProgram();
+			larger.assignments.insert(larger.assignments.end(), solver.GetProgram().assignments.begin(), solver.GetProgram().assignments.end());
+			cache.SetBudget(cache.Statistics().bytes);
+			cache.Insert(source, 0, larger);
+			bool dropped = !cache.Find(source, 0) && cache.Statistics().entries == 0 && cache.Statistics().bytes == 0;
+			printf("oversized replacement: %s\n", (dropped) ? "ok" : "FAILED");
+		}
+
+		void RunProcedures(uint32_t samples) {
+			printf("----Procedure Benchmark (%u samples)----\n", samples);
+			Lexer lexer;
+			Parser parser(&lexer);
+			lexer.Input("k = 3\nf(x) = (x + 1) ^ 2 + k\ng(x) = f(x) + f(2 * x)\ny = g(x)\ny = (x + 1) ^ 2 + k + (2 * x + 1) ^ 2 + k\n");
+			lexer.Run();
+			parser.Run();
+			HashCons hash_cons(&parser);
+			hash_cons.Run();
+
+			Compiler compiler;
+			Program inlined = compiler.Compile(parser.Root());
+			compiler.SetInlining(false);
+			Program called = compiler.Compile(parser.Root());
+			if (inlined.assignments.size() < 3)
+				return;
+
+			VirtualMachine vm;
+			auto time = [&](const Chunk& chunk, double& sum) {
+				sum = 0.0;
+				auto start = Clock::now();
+				for (uint32_t i = 0; i < samples; i++)
+					sum += vm.Run(chunk, -4.0 + 8.0 * i / samples);
+				return ElapsedNs(start) / samples;
+			};
+
+			double written_sum, inlined_sum, called_sum;
+			double written = time(inlined.assignments[2].chunk, written_sum);
+			double inline_ns = time(inlined.assignments[1].chunk, inlined_sum);
+			double call_ns = time(called.assignments[1].chunk, called_sum);
+			printf("written out %.1f ns (%zu ops), inlined %.1f ns (%zu ops), called %.1f ns (%zu ops), sums %s\n", written, inlined.assignments[2].chunk.code.size(),
+				inline_ns, inlined.assignments[1].chunk.code.size(), call_ns, called.assignments[1].chunk.code.size(),
+				(written_sum == inlined_sum && inlined_sum == called_sum) ? "match" : "differ");
+
+			//Calls have no side effects, so hash consing shares a repeated call and the program makes it once
+			Lexer shared_lexer;
+			Parser shared_parser(&shared_lexer);
+			shared_lexer.Input("f(t) = t ^ 2 + 1\ny = (sin(x) + 1) / (sin(x) - 1)\nz = (f(x) + 1) / (f(x) - 1)\n");
+			shared_lexer.Run();
+			shared_parser.Run();
+			HashCons shared_cons(&shared_parser);
+			shared_cons.Run();
+			Program shared = compiler.Compile(shared_parser.Root());
+			uint32_t calls = 0;
+			for (auto& assignment : shared.assignments)
+				for (auto& instruction : assignment.chunk.code)
+					calls += (instruction.op == OP_CALL || instruction.op == OP_CALL_BUILTIN);
+			printf("repeated calls: %u of 4 made: %s\n", calls, (shared.assignments.size() == 2 && calls == 2) ? "ok" : "FAILED");
+
+			//Resolve reports calls with the wrong argument count or to nothing, and they evaluate to NaN everywhere
+			Lexer bad_lexer;
+			Parser bad_parser(&bad_lexer);
+			bad_lexer.Input("f(a, b) = a - b\nc = f(1)\nd = f(1, 2, 3)\ne = sine(x)\ng = sin(x, 2)\n");
+			bad_lexer.Run();
+			bad_parser.Run();
+			Program bad = compiler.Compile(bad_parser.Root());
+			FunctionSolver bad_solver(&bad_parser);
+			auto values = bad_solver.EvaluateScript("1");
+			bool nan = bad.assignments.size() == 4 && values.size() == 4;
+			for (size_t i = 0; nan && i < 4; i++) {
+				double batch = 0.0, x = 1.0;
+				bad_solver.EvaluateBatch(bad_parser.Root()->procedures[i + 1]->expr, &x, &batch, 1);
+				nan = std::isnan(values[i].value) && std::isnan(vm.Run(bad.assignments[i].chunk, x)) && std::isnan(batch);
+			}
+			printf("bad calls: %s\n", (nan) ? "ok" : "FAILED");
+		}
+
+		void RunMemo(uint32_t samples) {
+			printf("----Memo Benchmark (%u samples)----\n", samples);
+			Lexer lexer;
+			Parser parser(&lexer);
+			lexer.Input("f(t) = ((t ^ 3 - 2 * t + 1) ^ 2 / (t ^ 2 + 1) + (t ^ 5 - t) / (t ^ 4 + 3) - (t ^ 2 - 1) ^ 3 / (t ^ 6 + 2)) ^ 2\ny = f(x) + f(x / 2)\n");
+			lexer.Run();
+			parser.Run();
+			if (parser.Root()->functions.empty() || !parser.Root()->functions[0]->pure)
+				return;
+
+			Compiler compiler;
+			Program plain = compiler.Compile(parser.Root());
+			compiler.SetMemoized("f", true);
+			Program memoized = compiler.Compile(parser.Root());
+			if (plain.assignments.empty() || memoized.assignments.empty())
+				return;
+
+			//A plot redrawn while panning revisits the same few hundred abscissae over and over
+			const uint32_t distinct = 512;
+			std::vector<double> xs(samples);
+			for (uint32_t i = 0; i < samples; i++)
+				xs[i] = -4.0 + 8.0 * ((i * 7919u) % distinct) / distinct;
+
+			VirtualMachine vm;
+			auto time = [&](const Chunk& chunk, double& sum) {
+				sum = 0.0;
+				auto start = Clock::now();
+				for (uint32_t i = 0; i < samples; i++)
+					sum += vm.Run(chunk, xs[i]);
+				return ElapsedNs(start) / samples;
+			};
+
+			double plain_sum, memo_sum;
+			double plain_ns = time(plain.assignments[0].chunk, plain_sum);
+			double memo_ns = time(memoized.assignments[0].chunk, memo_sum);
+			auto& stats = vm.Memos()[0].Statistics();
+			printf("plain %.1f ns, memoized %.1f ns, %.1f%% hit rate (%llu hits, %llu misses, %u entries), sums %s\n", plain_ns, memo_ns, stats.HitRate() * 100.0,
+				(unsigned long long)stats.hits, (unsigned long long)stats.misses, stats.size, (plain_sum == memo_sum) ? "match" : "differ");
+		}
+
+		void RunBuiltins(uint32_t samples) {
+			printf("----Built-in Benchmark (%s, %u samples)----\n", Kernels::InstructionSet(), samples);
+			std::vector<double> xs(samples), ys(samples), out(samples);
+			for (uint32_t i = 0; i < samples; i++) {
+				xs[i] = 0.01 + 20.0 * i / samples;
+				ys[i] = -3.0 + 6.0 * i / samples;
+			}
+
+			auto time = [&](const char* name, const std::function<void()>& scalar, const std::function<void()>& block) {
+				auto start = Clock::now();
+				scalar();
+				double libm = ElapsedNs(start) / samples;
+				start = Clock::now();
+				block();
+				double kernel = ElapsedNs(start) / samples;
+				printf("%s: libm %.2f ns/point, kernel %.2f ns/point (%.1fx)\n", name, libm, kernel, libm / kernel);
+			};
+
+			time("sin", [&] { for (uint32_t i = 0; i < samples; i++) out[i] = sin(xs[i]); }, [&] { Kernels::Sin(xs.data(), out.data(), samples); });
+			time("cos", [&] { for (uint32_t i = 0; i < samples; i++) out[i] = cos(xs[i]); }, [&] { Kernels::Cos(xs.data(), out.data(), samples); });
+			time("exp", [&] { for (uint32_t i = 0; i < samples; i++) out[i] = exp(ys[i]); }, [&] { Kernels::Exp(ys.data(), out.data(), samples); });
+			time("log", [&] { for (uint32_t i = 0; i < samples; i++) out[i] = log(xs[i]); }, [&] { Kernels::Log(xs.data(), out.data(), samples); });
+			time("sqrt", [&] { for (uint32_t i = 0; i < samples; i++) out[i] = sqrt(xs[i]); }, [&] { Kernels::Sqrt(xs.data(), out.data(), samples); });
+			time("pow", [&] { for (uint32_t i = 0; i < samples; i++) out[i] = pow(xs[i], ys[i]); }, [&] { Kernels::Power(xs.data(), ys.data(), out.data(), samples); });
+
+			//The tree walkers use the scalar kernels and the batch evaluator the block ones, so they have to agree to
+			//the bit. Arguments run over several periods of sin and cos and both signs of every other input
+			std::vector<double> args(samples);
+			for (uint32_t i = 0; i < samples; i++)
+				args[i] = -40.0 + 80.0 * i / samples + 1e-3 * (i % 7);
+			uint32_t mismatches = 0;
+			auto compare = [&](double (*scalar)(double), void (*block)(const double*, double*, size_t), const std::vector<double>& in) {
+				block(in.data(), out.data(), samples);
+				for (uint32_t i = 0; i < samples; i++) {
+					double value = scalar(in[i]);
+					mismatches += memcmp(&out[i], &value, sizeof(double)) != 0;
+				}
+			};
+			compare(Kernels::Sin, Kernels::Sin, args);
+			compare(Kernels::Cos, Kernels::Cos, args);
+			compare(Kernels::Exp, Kernels::Exp, ys);
+			compare(Kernels::Log, Kernels::Log, xs);
+			Kernels::Power(xs.data(), ys.data(), out.data(), samples);
+			for (uint32_t i = 0; i < samples; i++) {
+				double scalar = Kernels::Power(xs[i], ys[i]);
+				mismatches += memcmp(&out[i], &scalar, sizeof(double)) != 0;
+			}
+			printf("scalar against block: %u of %u results differ: %s\n", mismatches, 5 * samples, (mismatches) ? "FAILED" : "ok");
+
+			Lexer lexer;
+			lexer.Input("y = sin(3 * x) * exp(-x * x / 8) + sqrt(x * x + 1) - log(x * x + 2) + pow(x * x + 1, 0.3)");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			if (!parser.Root() || parser.Root()->procedures.empty())
+				return;
+
+			FunctionSolver solver(&parser);
+			solver.Compile();
+			Ast_Expression* expr = parser.Root()->procedures[0]->expr;
+			for (uint32_t i = 0; i < samples; i++)
+				xs[i] = -10.0 + 20.0 * i / samples;
+
+			auto start = Clock::now();
+			for (uint32_t i = 0; i < samples; i++)
+				out[i] = solver.Evaluate(0, xs[i]);
+			double vm = ElapsedNs(start) / samples;
+
+			std::vector<double> batch_out(samples);
+			start = Clock::now();
+			solver.EvaluateBatch(expr, xs.data(), batch_out.data(), samples);
+			double batch = ElapsedNs(start) / samples;
+
+			printf("expression: vm %.2f ns/point, batch %.2f ns/point, results %s\n", vm, batch, (out == batch_out) ? "match" : "differ: FAILED");
+		}
+
+		//Products at digits, ten and a hundred times digits through each multiplication algorithm, then the
+		//big-float operations at digits and a table of a script the way a user would generate one
+		void RunBigFloat(uint32_t digits) {
+			printf("----Big-Float Benchmark (%u digits)----\n", digits);
+			uint32_t seed = 12345;
+			auto next = [&seed] {
+				seed = seed * 1664525u + 1013904223u;
+				return seed;
+			};
+
+			for (uint32_t scale = 1; scale <= 100; scale *= 10) {
+				size_t n = (size_t)BigFloat::LimbsFor(digits) * scale;
+				std::vector<uint32_t> a(n), b(n), expected(2 * n), out(2 * n);
+				for (size_t i = 0; i < n; i++) {
+					a[i] = next();
+					b[i] = next();
+				}
+				uint32_t repeats = (uint32_t)std::max<size_t>(1, 4000000 / (n * n));
+
+				bool match = true;
+				auto time = [&](void (*multiply)(const uint32_t*, size_t, const uint32_t*, size_t, uint32_t*)) {
+					multiply(a.data(), n, b.data(), n, out.data());
+					auto start = Clock::now();
+					for (uint32_t i = 0; i < repeats; i++)
+						multiply(a.data(), n, b.data(), n, out.data());
+					double us = ElapsedNs(start) / repeats / 1000.0;
+					match = match && out == expected;
+					return us;
+				};
+
+				Limbs::MultiplySchool(a.data(), n, b.data(), n, expected.data());
+				double school = time(Limbs::MultiplySchool);
+				double karatsuba = time(Limbs::MultiplyKaratsuba);
+				double fft = (4 * n <= FFT_MAX_POINTS) ? time(Limbs::MultiplyFFT) : 0.0;
+				double chosen = time(Limbs::Multiply);
+				printf("%u digits (%zu limbs): school %.2f us, karatsuba %.2f us, fft %.2f us, chosen %.2f us (%.0f products/s), results %s\n", digits * scale, n,
+					school, karatsuba, fft, chosen, 1e6 / chosen, (match) ? "match" : "differ");
+			}
+
+			BigFloat::Precision precision(digits);
+			BigFloat x = Sqrt(BigFloat(2.0)), y = BigFloat::Pi(), r;
+			auto time = [&](const char* name, uint32_t repeats, const std::function<BigFloat()>& operation) {
+				auto start = Clock::now();
+				for (uint32_t i = 0; i < repeats; i++)
+					r = operation();
+				printf("%s %.2f us, ", name, ElapsedNs(start) / repeats / 1000.0);
+			};
+			time("multiply", 1000, [&] { return x * y; });
+			time("divide", 100, [&] { return x / y; });
+			time("sqrt", 100, [&] { return Sqrt(y); });
+			time("exp", 10, [&] { return Exp(x); });
+			time("log", 10, [&] { return Log(y); });
+			time("sin", 10, [&] { return Sin(x); });
+			printf("\n");
+
+			Lexer lexer;
+			lexer.Input("y = sin(x) * exp(-x / 3) + sqrt(x) / (1 + x ^ 2)");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			if (!parser.Root() || parser.Root()->procedures.empty())
+				return;
+
+			Interpreter interpreter(&parser);
+			interpreter.SetDigits(digits);
+			const uint32_t ROWS = 20;
+			auto start = Clock::now();
+			for (uint32_t i = 1; i <= ROWS; i++)
+				r = interpreter.SolveBigFloat(parser.Root()->procedures[0]->expr, BigFloat(i).DivideSmall(10));
+			printf("table: %u rows in %.2f ms, y(2) = %s\n", ROWS, ElapsedNs(start) / 1e6, r.ToString(40).c_str());
+
+			//Literals past a double's digits or range have to reach the big floats as written, decimal fractions round
+			//differently in the last binary digit depending on the order of operations so the check reads 40 digits
+			Lexer literal_lexer;
+			literal_lexer.Input("a = 123456789012345678901234567890 * 987654321098765432109876543210\n"
+				"b = 3.14159265358979323846264338327950288 - 3.14159265358979\nc = 1e400 / 1e399");
+			literal_lexer.Run();
+			Parser literal_parser(&literal_lexer);
+			literal_parser.Run();
+			Optimizer optimizer(&literal_parser);
+			optimizer.SetExact(true);
+			optimizer.Run();
+			Interpreter literal_interpreter(&literal_parser);
+			literal_interpreter.SetDigits(digits);
+			const BigFloat expected[] = { BigFloat::Parse("121932631137021795226185032733622923332237463801111263526900"),
+				BigFloat::Parse("0.00000000000000323846264338327950288"), BigFloat(10.0) };
+			bool literals = literal_parser.Root() && literal_parser.Root()->procedures.size() == 3;
+			for (size_t i = 0; literals && i < 3; i++)
+				literals = literal_interpreter.SolveBigFloat(literal_parser.Root()->procedures[i]->expr, BigFloat()).ToString(40) == expected[i].ToString(40);
+			printf("literals: %s\n", (literals) ? "ok" : "FAILED");
+		}
+
+		//Harmonic sums are the worst case for naive normalization, the denominator grows to about n / ln 10 digits
+		void RunRational(uint32_t terms) {
+			printf("----Rational Benchmark (%u terms)----\n", terms);
+			Rational h, ten;
+			for (uint32_t k = 1; k <= 10; k++)
+				ten = ten + Rational(1.0) / Rational(k);
+
+			auto start = Clock::now();
+			for (uint32_t k = 1; k <= terms; k++)
+				h = h + Rational(1.0) / Rational(k);
+			double ms = ElapsedNs(start) / 1e6;
+			double expected = log((double)terms) + 0.57721566490153286061 + 0.5 / terms - 1.0 / (12.0 * terms * terms);
+			printf("H(%u): %.2f ms (%.2f us per term), %zu digit denominator, %.15f vs %.15f, H(10) = %s (%s)\n", terms, ms, ms * 1000.0 / terms,
+				Limbs::ToDecimal(h.Denominator()).size(), h.ToDouble(), expected, ten.ToString().c_str(), (ten.ToString() == "7381/2520") ? "match" : "differ");
+
+			const Natural& a = h.Numerator();
+			const Natural& b = h.Denominator();
+			const uint32_t REPEATS = 10;
+			Natural g;
+			start = Clock::now();
+			for (uint32_t i = 0; i < REPEATS; i++)
+				g = Limbs::Gcd(a, b);
+			printf("gcd of %zu and %zu limbs: %.2f ms, %s\n", a.size(), b.size(), ElapsedNs(start) / REPEATS / 1e6, (g == Natural{ 1 }) ? "coprime" : "not reduced");
+
+			Lexer lexer;
+			lexer.Input("a = 1/3 + 1/6\ny = a * x ^ 3 - x / 7 + sqrt(x ^ 2)");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			FunctionSolver solver(&parser);
+			solver.SetMode(NUMERIC_RATIONAL);
+			start = Clock::now();
+			auto values = solver.EvaluateScript("2/5");
+			printf("script at x = 2/5 in %.2f us:", ElapsedNs(start) / 1000.0);
+			for (auto& value : values)
+				printf(" %s = %s", value.id.c_str(), value.text.c_str());
+			printf("\n");
+
+			//Literals past a double's digits have to reach the rationals as written
+			Lexer literal_lexer;
+			literal_lexer.Input("a = 12345678901234567891 - 12345678901234567890\nb = 0.12345678901234567891");
+			literal_lexer.Run();
+			Parser literal_parser(&literal_lexer);
+			literal_parser.Run();
+			Optimizer optimizer(&literal_parser);
+			optimizer.SetExact(true);
+			optimizer.Run();
+			FunctionSolver literal_solver(&literal_parser);
+			literal_solver.SetMode(NUMERIC_RATIONAL);
+			auto literals = literal_solver.EvaluateScript("0");
+			bool exact = literals.size() == 2 && literals[0].text == "1" && literals[1].text == "12345678901234567891/100000000000000000000";
+			printf("literals: %s\n", (exact) ? "ok" : "FAILED");
+		}
+
+		//Scalar Complex tree walk against the split array batch on the same points, then whole domain coloring frames
+		void RunComplex(uint32_t width, uint32_t height) {
+			printf("----Complex Benchmark (%s)----\n", Kernels::InstructionSet());
+			Lexer lexer;
+			lexer.Input("y = (x^3 - 1) / (x^2 + i) + exp(i * x) * x / 3");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			if (!parser.Root() || parser.Root()->procedures.empty())
+				return;
+
+			FunctionSolver solver(&parser);
+			solver.Compile();
+			Ast_Expression* expr = parser.Root()->procedures[0]->expr;
+
+			const uint32_t SAMPLES = 1 << 16;
+			std::vector<double> re(SAMPLES), im(SAMPLES), out_re(SAMPLES), out_im(SAMPLES);
+			for (uint32_t i = 0; i < SAMPLES; i++) {
+				re[i] = -4.0 + 8.0 * (i % 256) / 256.0;
+				im[i] = -4.0 + 8.0 * (i / 256) / 256.0;
+			}
+
+			auto start = Clock::now();
+			double differ = 0.0;
+			for (uint32_t i = 0; i < SAMPLES; i++) {
+				Complex value = solver.SolveComplex(expr, Complex(re[i], im[i]));
+				out_re[i] = value.re;
+				out_im[i] = value.im;
+			}
+			double tree = ElapsedNs(start) / SAMPLES;
+			std::vector<double> tree_re = out_re, tree_im = out_im;
+
+			start = Clock::now();
+			solver.EvaluateComplexBatch(expr, re.data(), im.data(), out_re.data(), out_im.data(), SAMPLES);
+			double batch = ElapsedNs(start) / SAMPLES;
+			for (uint32_t i = 0; i < SAMPLES; i++)
+				if (out_re[i] != tree_re[i] || out_im[i] != tree_im[i])
+					differ++;
+			printf("%u points: tree %.2f ns/point, batch %.2f ns/point (%.1fx), %.0f results differ\n", SAMPLES, tree, batch, tree / batch, differ);
+
+			ThreadPool pool;
+			const char* functions[] = { "y = (x^3 - 1) / (x^2 + i)", "y = sin(x) * exp(-x / 4)", "y = sqrt(x^2 - 4) / (x - i)" };
+			for (auto source : functions) {
+				Lexer domain_lexer;
+				domain_lexer.Input(source);
+				domain_lexer.Run();
+				Parser domain_parser(&domain_lexer);
+				domain_parser.Run();
+				FunctionSolver domain_solver(&domain_parser);
+				domain_solver.Compile();
+
+				SamplerView view;
+				view.x0 = -8.0;
+				view.x1 = 8.0;
+				view.y0 = -4.5;
+				view.y1 = 4.5;
+				view.width = width;
+				view.height = height;
+				DomainColoring domain(&domain_solver, &pool);
+				domain.SetView(view);
+				domain.Sample();
+
+				//A one pixel pan recolors the whole view, which is what an interactive frame costs
+				view.x0 += 16.0 / width;
+				view.x1 += 16.0 / width;
+				domain.SetView(view);
+				domain.Sample();
+				auto& stats = domain.Statistics();
+				printf("%s: %ux%u in %.2f ms on %zu threads (%.1f Mpixels/s)\n", source, stats.width, stats.height, stats.milliseconds, pool.Threads(),
+					stats.evaluations / stats.milliseconds / 1000.0);
+			}
+		}
+
+		//Packed multiply against the naive loop at every doubling of n, the in-cache rate is one MC by KC block of A
+		//times a KC by NC panel of B on a single thread, which is as close to the micro-kernel alone as a full call gets
+		void RunGemm(uint32_t max_n) {
+			ThreadPool& pool = ThreadPool::Shared();
+			printf("----GEMM Benchmark (%s kernel, %zu threads)----\n", Gemm::MicroKernel(), pool.Threads());
+
+			//The micro-kernel alone on one A and one B panel that stay in L1 is the ceiling for every size below, a
+			//packed multiply also pays for packing and for streaming B from L2
+			size_t mr = Gemm::KernelRows(), nr = Gemm::KernelCols();
+			std::vector<double> a(mr * GEMM_KC, 0.5), b(GEMM_KC * nr, 0.25), c(mr * nr);
+			const uint32_t REPEATS = 50, CALLS = 1000;
+			double best = INFINITY;
+			for (uint32_t i = 0; i < REPEATS; i++) {
+				auto start = Clock::now();
+				for (uint32_t j = 0; j < CALLS; j++)
+					Gemm::RunKernel(GEMM_KC, a.data(), b.data(), c.data(), nr);
+				best = fmin(best, ElapsedNs(start));
+			}
+			double peak = 2.0 * mr * nr * GEMM_KC * CALLS / best;
+			printf("micro-kernel in L1: %.2f GFLOP/s per thread, result %g\n", peak, c[0]);
+
+			for (uint32_t n = 64; n <= max_n; n *= 2) {
+				std::vector<double> x((size_t)n * n), y((size_t)n * n), z((size_t)n * n), reference;
+				for (size_t i = 0; i < x.size(); i++) {
+					x[i] = (double)(i % 17) / 17.0 - 0.5;
+					y[i] = (double)(i % 13) / 13.0 - 0.5;
+				}
+
+				double flops = 2.0 * n * n * n;
+				uint32_t repeats = (uint32_t)std::max(1.0, 2e9 / flops);
+				auto start = Clock::now();
+				for (uint32_t i = 0; i < repeats; i++)
+					Gemm::Multiply(x.data(), n, y.data(), n, z.data(), n, n, n, n);
+				double gflops = flops * repeats / ElapsedNs(start);
+				printf("n = %u: %.2f GFLOP/s (%.0f%% of the micro-kernel on %zu threads)", n, gflops, 100.0 * gflops / (peak * pool.Threads()), pool.Threads());
+
+				//The naive loop is only timed while it takes under a second or so
+				if (n <= 512) {
+					reference.resize(z.size());
+					start = Clock::now();
+					Gemm::MultiplyNaive(x.data(), n, y.data(), n, reference.data(), n, n, n, n);
+					double naive = flops / ElapsedNs(start);
+					double error = 0.0;
+					for (size_t i = 0; i < z.size(); i++)
+						error = fmax(error, fabs(z[i] - reference[i]));
+					printf(", naive %.2f GFLOP/s (%.1fx), max difference %.3g", naive, gflops / naive, error);
+				}
+				printf("\n");
+			}
+
+			Lexer lexer;
+			lexer.Input("a = [2, 1; 1, 3]\nb = a * x - x * a\nc = [a, a / a; a ^ -1, 0 * a] * 2");
+			lexer.Run();
+			Parser parser(&lexer);
+			parser.Run();
+			FunctionSolver solver(&parser);
+			solver.SetMode(NUMERIC_MATRIX);
+			auto start = Clock::now();
+			auto values = solver.EvaluateScript("[1, 2; 0, 1]");
+			printf("script at x = [1, 2; 0, 1] in %.2f us:", ElapsedNs(start) / 1000.0);
+			for (auto& value : values)
+				printf(" %s = %s", value.id.c_str(), value.text.c_str());
+			printf("\n");
+		}
+
+		//Variable coefficient diffusion on a grid by grid mesh with zero boundary values, the five point stencil a finite
+		//difference script produces. The coefficient jumps by 100x on a checkerboard of 16 by 16 cells, which is where
+		//Jacobi and ILU(0) start paying for themselves
+		void RunSparse(uint32_t grid) {
+			ThreadPool& pool = ThreadPool::Shared();
+			printf("----Sparse Benchmark (%ux%u grid, %zu threads)----\n", grid, grid, pool.Threads());
+			uint32_t n = grid * grid;
+			auto coefficient = [&](uint32_t i, uint32_t j) { return (((i / 16) + (j / 16)) % 2) ? 100.0 : 1.0; };
+
+			auto start = Clock::now();
+			SparseBuilder builder(n, n);
+			builder.Reserve((size_t)n * 9);
+			for (uint32_t i = 0; i < grid; i++) {
+				for (uint32_t j = 0; j < grid; j++) {
+					uint32_t p = i * grid + j;
+					int neighbors[4][2] = { { (int)i - 1, (int)j }, { (int)i + 1, (int)j }, { (int)i, (int)j - 1 }, { (int)i, (int)j + 1 } };
+					for (auto& q : neighbors) {
+						bool inside = q[0] >= 0 && q[1] >= 0 && q[0] < (int)grid && q[1] < (int)grid;
+						double w = 0.5 * (coefficient(i, j) + ((inside) ? coefficient(q[0], q[1]) : coefficient(i, j)));
+						//Every face adds to the diagonal separately, the builder sums the duplicates
+						builder.Add(p, p, w);
+						if (inside)
+							builder.Add(p, q[0] * grid + q[1], -w);
+					}
+				}
+			}
+			SparseMatrix a = builder.Build();
+			printf("built from %zu triplets in %.2f ms: %zu non-zeros, %.1f MB (dense would be %.1f GB)\n", builder.Size(), ElapsedNs(start) / 1e6, a.NonZeros(),
+				a.Bytes() / 1e6, (double)n * n * sizeof(double) / 1e9);
+
+			std::vector<double> x(n, 1.0), y(n), b(n);
+			ThreadPool single(1);
+			const uint32_t REPEATS = 20;
+			double bytes = (double)a.Bytes() + 2.0 * n * sizeof(double);
+			start = Clock::now();
+			for (uint32_t r = 0; r < REPEATS; r++)
+				a.Multiply(x.data(), y.data(), &single);
+			double serial = ElapsedNs(start) / REPEATS;
+			start = Clock::now();
+			for (uint32_t r = 0; r < REPEATS; r++)
+				a.Multiply(x.data(), y.data(), &pool);
+			double parallel = ElapsedNs(start) / REPEATS;
+			printf("SpMV: %.2f ms on one thread, %.2f ms on %zu (%.1fx, %.1f GB/s, %.2f GFLOP/s)\n", serial / 1e6, parallel / 1e6, pool.Threads(), serial / parallel,
+				bytes / parallel, 2.0 * a.NonZeros() / parallel);
+
+			for (uint32_t i = 0; i < n; i++)
+				x[i] = sin(0.001 * i);
+			a.Multiply(x.data(), b.data());
+			const char* names[] = { "none", "Jacobi", "ILU(0)" };
+			for (int preconditioner : { PRECONDITIONER_NONE, PRECONDITIONER_JACOBI, PRECONDITIONER_ILU0 }) {
+				CgOptions options;
+				options.preconditioner = preconditioner;
+				options.tolerance = 1e-8;
+				options.max_iterations = 20000;
+				std::fill(y.begin(), y.end(), 0.0);
+				CgResult result = ConjugateGradient(a, b.data(), y.data(), options);
+
+				double error = 0.0;
+				for (uint32_t i = 0; i < n; i++)
+					error = fmax(error, fabs(y[i] - x[i]));
+				printf("CG %s: %u iterations, residual %.2e, %s, setup %.2f ms, solve %.2f ms (%.3f ms/iteration), max error %.2e\n", names[result.preconditioner],
+					result.iterations, result.residual, (result.converged) ? "converged" : "not converged", result.setup_milliseconds, result.solve_milliseconds,
+					result.solve_milliseconds / fmax(result.iterations, 1), error);
+			}
+		}
+
+		void RunAll() {
+			RunEvaluator();
+			RunBatch();
+			RunDual();
+			RunGlobals();
+			RunSampler();
+			RunRoots();
+			RunImplicit();
+			RunLexer();
+			RunEditor();
+			RunCache();
+			RunProcedures();
+			RunMemo();
+			RunBuiltins();
+			RunBigFloat();
+			RunRational();
+			RunComplex();
+			RunGemm();
+			RunSparse();
+		}
+	}
+}
\ No newline at end of file
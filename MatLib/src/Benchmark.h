@@ -0,0 +1,34 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <string>
+
+namespace MatLib {
+	namespace Benchmark {
+		std::string DeepExpression(uint32_t depth);
+		std::string WideExpression(uint32_t width);
+
+		void RunEvaluator(uint32_t iterations = 100000);
+		void RunBatch(uint32_t samples = 1 << 16);
+		void RunDual(uint32_t iterations = 100000);
+		void RunGlobals();
+		void RunSampler();
+		void RunRoots(uint32_t samples = 1 << 20);
+		void RunImplicit(uint32_t width = 3840, uint32_t height = 2160);
+		void RunLexer(uint32_t lines = 20000);
+		void RunEditor(uint32_t lines = 5000);
+		void RunCache(uint32_t lines = 100);
+		void RunProcedures(uint32_t samples = 1 << 20);
+		void RunMemo(uint32_t samples = 1 << 20);
+		void RunBuiltins(uint32_t samples = 1 << 16);
+		void RunBigFloat(uint32_t digits = 1000);
+		void RunRational(uint32_t terms = 10000);
+		void RunComplex(uint32_t width = 1280, uint32_t height = 720);
+		void RunGemm(uint32_t max_n = 4096);
+		void RunSparse(uint32_t grid = 512);
+		void RunAll();
+	}
+}
+
+#endif // !BENCHMARK_H
\ No newline at end of file
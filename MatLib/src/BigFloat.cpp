@@ -0,0 +1,674 @@
+#include "BigFloat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace MatLib {
+	thread_local uint32_t BigFloat::limbs = BigFloat::LimbsFor(BIG_FLOAT_DEFAULT_DIGITS);
+
+	//Doubles are read back through their shortest round trip decimal, so the literal 0.1 is one tenth and not the
+	//binary fraction nearest to it. Integers are exact either way and skip the formatting
+	BigFloat::BigFloat(double value) {
+		if (value == floor(value) || std::isnan(value) || std::isinf(value)) {
+			*this = Exact(value);
+			return;
+		}
+
+		char text[32];
+		for (int precision = 15; precision <= 17; precision++) {
+			snprintf(text, sizeof(text), "%.*g", precision, value);
+			if (strtod(text, nullptr) == value)
+				break;
+		}
+		*this = Parse(text);
+	}
+
+	BigFloat BigFloat::NaN() {
+		BigFloat r;
+		r.nan = true;
+		return r;
+	}
+
+	BigFloat BigFloat::Exact(double value) {
+		BigFloat r;
+		if (std::isnan(value) || std::isinf(value))
+			return NaN();
+		if (value == 0.0)
+			return r;
+
+		int e = 0;
+		uint64_t bits = (uint64_t)ldexp(frexp(fabs(value), &e), 53);
+		e -= 53;
+		int64_t q = (e >= 0) ? e / 32 : -((-e + 31) / 32);
+		r.mantissa = Limbs::ShiftLeft(Natural{ (uint32_t)bits, (uint32_t)(bits >> 32) }, (size_t)(e - 32 * q));
+		r.exponent = q;
+		r.negative = value < 0.0;
+		r.Strip();
+		return r;
+	}
+
+	//Leading zero limbs are dropped and trailing ones folded into the exponent, the value is unchanged
+	void BigFloat::Strip() {
+		Limbs::Trim(mantissa);
+		if (nan || mantissa.empty()) {
+			mantissa.clear();
+			exponent = 0;
+			negative = false;
+			return;
+		}
+		size_t zeros = 0;
+		while (zeros < mantissa.size() && mantissa[zeros] == 0)
+			zeros++;
+		if (zeros) {
+			mantissa.erase(mantissa.begin(), mantissa.begin() + zeros);
+			exponent += (int64_t)zeros;
+		}
+	}
+
+	//Round half up on the magnitude to the working precision
+	void BigFloat::Round() {
+		Limbs::Trim(mantissa);
+		if (mantissa.size() > limbs) {
+			size_t drop = mantissa.size() - limbs;
+			bool up = (mantissa[drop - 1] & 0x80000000u) != 0;
+			mantissa.erase(mantissa.begin(), mantissa.begin() + drop);
+			exponent += (int64_t)drop;
+			if (up) {
+				size_t i = 0;
+				while (i < mantissa.size() && ++mantissa[i] == 0)
+					i++;
+				if (i == mantissa.size())
+					mantissa.push_back(1);
+			}
+		}
+		Strip();
+	}
+
+	BigFloat BigFloat::Rounded() const {
+		BigFloat r = *this;
+		r.Round();
+		return r;
+	}
+
+	//|x| is about d * 2^(32 * scale) with d in [1, 2^32)
+	double BigFloat::Leading(int64_t& scale) const {
+		size_t n = mantissa.size();
+		scale = exponent + (int64_t)n - 1;
+		double d = (double)mantissa[n - 1];
+		if (n > 1)
+			d += (double)mantissa[n - 2] * (1.0 / 4294967296.0);
+		return d;
+	}
+
+	//Low 32 bits of an integer's magnitude
+	uint32_t BigFloat::Residue() const {
+		if (mantissa.empty() || exponent > 0)
+			return 0;
+		return (exponent == 0) ? mantissa[0] : 0;
+	}
+
+	int64_t BigFloat::Magnitude() const {
+		if (mantissa.empty())
+			return INT64_MIN / 4;
+		return exponent + (int64_t)mantissa.size();
+	}
+
+	double BigFloat::ToDouble() const {
+		if (nan)
+			return NAN;
+		if (mantissa.empty())
+			return 0.0;
+		size_t n = mantissa.size(), top = std::min(n, (size_t)3);
+		double v = 0.0;
+		for (size_t i = n; i-- > n - top;)
+			v = v * 4294967296.0 + (double)mantissa[i];
+		int64_t e = 32 * (exponent + (int64_t)(n - top));
+		e = std::max<int64_t>(std::min<int64_t>(e, 4096), -4096);
+		v = ldexp(v, (int)e);
+		return (negative) ? -v : v;
+	}
+
+	BigFloat BigFloat::Ldexp(int64_t bits) const {
+		if (nan || mantissa.empty())
+			return *this;
+		int64_t q = (bits >= 0) ? bits / 32 : -((-bits + 31) / 32);
+		BigFloat r;
+		r.mantissa = Limbs::ShiftLeft(mantissa, (size_t)(bits - 32 * q));
+		r.exponent = exponent + q;
+		r.negative = negative;
+		r.Strip();
+		return r;
+	}
+
+	BigFloat BigFloat::Truncate() const {
+		if (nan || mantissa.empty() || exponent >= 0)
+			return *this;
+		if ((uint64_t)-exponent >= mantissa.size())
+			return BigFloat();
+		BigFloat r;
+		r.mantissa.assign(mantissa.begin() + (size_t)-exponent, mantissa.end());
+		r.negative = negative;
+		r.Strip();
+		return r;
+	}
+
+	BigFloat BigFloat::MultiplySmall(uint32_t m) const {
+		if (nan)
+			return *this;
+		BigFloat r = *this;
+		Limbs::MultiplySmall(r.mantissa, m);
+		r.Round();
+		return r;
+	}
+
+	//The dividend is widened to the working precision first, so the quotient keeps every limb
+	BigFloat BigFloat::DivideSmall(uint32_t d) const {
+		if (nan || d == 0)
+			return NaN();
+		if (mantissa.empty())
+			return *this;
+		BigFloat r = *this;
+		if (r.mantissa.size() < (size_t)limbs + 1) {
+			size_t pad = limbs + 1 - r.mantissa.size();
+			r.mantissa.insert(r.mantissa.begin(), pad, 0);
+			r.exponent -= (int64_t)pad;
+		}
+		Limbs::DivideSmall(r.mantissa, d);
+		r.Round();
+		return r;
+	}
+
+	BigFloat operator-(const BigFloat& a) {
+		BigFloat r = a;
+		if (!r.nan && !r.mantissa.empty())
+			r.negative = !r.negative;
+		return r;
+	}
+
+	//Limbs more than two below the working precision of the larger operand cannot reach the result and are cut
+	//before aligning, so a sum never costs more than the precision however far apart the exponents are
+	static Natural Align(const Natural& mantissa, int64_t exponent, int64_t base) {
+		if (exponent >= base) {
+			Natural aligned((size_t)(exponent - base), 0);
+			aligned.insert(aligned.end(), mantissa.begin(), mantissa.end());
+			return aligned;
+		}
+		if ((uint64_t)(base - exponent) >= mantissa.size())
+			return Natural();
+		return Natural(mantissa.begin() + (size_t)(base - exponent), mantissa.end());
+	}
+
+	BigFloat operator+(const BigFloat& a, const BigFloat& b) {
+		if (a.nan || b.nan)
+			return BigFloat::NaN();
+		if (b.mantissa.empty())
+			return a.Rounded();
+		if (a.mantissa.empty())
+			return b.Rounded();
+
+		bool same = a.negative == b.negative;
+		int64_t top = std::max(a.Magnitude(), b.Magnitude());
+		int64_t base = std::max(top - (int64_t)BigFloat::limbs - 2, std::min(a.exponent, b.exponent));
+		Natural x = Align(a.mantissa, a.exponent, base), y = Align(b.mantissa, b.exponent, base);
+
+		BigFloat r;
+		r.exponent = base;
+		if (same) {
+			r.mantissa = Limbs::Add(x, y);
+			r.negative = a.negative;
+		}
+		else if (Limbs::Compare(x, y) >= 0) {
+			r.mantissa = Limbs::Sub(x, y);
+			r.negative = a.negative;
+		}
+		else {
+			r.mantissa = Limbs::Sub(y, x);
+			r.negative = b.negative;
+		}
+		r.Round();
+		return r;
+	}
+
+	BigFloat operator-(const BigFloat& a, const BigFloat& b) {
+		return a + (-b);
+	}
+
+	//Only the top limbs + 1 limbs of each operand can reach the rounded product
+	BigFloat operator*(const BigFloat& a, const BigFloat& b) {
+		if (a.nan || b.nan)
+			return BigFloat::NaN();
+		if (a.mantissa.empty() || b.mantissa.empty())
+			return BigFloat();
+
+		size_t ka = std::min(a.mantissa.size(), (size_t)BigFloat::limbs + 1);
+		size_t kb = std::min(b.mantissa.size(), (size_t)BigFloat::limbs + 1);
+		size_t sa = a.mantissa.size() - ka, sb = b.mantissa.size() - kb;
+		BigFloat r;
+		r.mantissa.resize(ka + kb);
+		Limbs::Multiply(a.mantissa.data() + sa, ka, b.mantissa.data() + sb, kb, r.mantissa.data());
+		r.exponent = a.exponent + b.exponent + (int64_t)(sa + sb);
+		r.negative = a.negative != b.negative;
+		r.Round();
+		return r;
+	}
+
+	//Newton's y = y + y (1 - b y) doubles the correct limbs each step, so every step but the last runs at a
+	//fraction of the final precision and the whole reciprocal costs a few full multiplications
+	BigFloat BigFloat::Reciprocal(const BigFloat& b) {
+		uint32_t target = limbs;
+		int64_t scale = 0;
+		BigFloat y = Exact(1.0 / b.Leading(scale));
+		y.exponent -= scale;
+		y.negative = b.negative;
+
+		BigFloat one = Exact(1.0);
+		for (uint32_t working = 1; working < target;) {
+			working = std::min(2 * working, target);
+			Working precision(working + 1);
+			y = y + y * (one - b * y);
+		}
+		return y;
+	}
+
+	BigFloat operator/(const BigFloat& a, const BigFloat& b) {
+		if (a.nan || b.nan || b.mantissa.empty())
+			return BigFloat::NaN();
+		if (a.mantissa.empty())
+			return BigFloat();
+
+		BigFloat q;
+		{
+			BigFloat::Working precision(BigFloat::limbs + 1);
+			q = a * BigFloat::Reciprocal(b);
+		}
+		return q.Rounded();
+	}
+
+	int Compare(const BigFloat& a, const BigFloat& b) {
+		BigFloat d = a - b;
+		return (d.IsZero() || d.nan) ? 0 : ((d.negative) ? -1 : 1);
+	}
+
+	BigFloat BigFloat::IntegerPower(const BigFloat& base, uint64_t n) {
+		BigFloat result = Exact(1.0), square = base;
+		for (; n; n >>= 1) {
+			if (n & 1)
+				result = result * square;
+			if (n > 1)
+				square = square * square;
+		}
+		return result;
+	}
+
+	//Reads sign, digits, an optional fraction and an optional exponent. The digits are gathered exactly and scaled
+	//by a power of ten once, so only that last step rounds
+	BigFloat BigFloat::Parse(std::string_view text) {
+		size_t i = 0;
+		while (i < text.size() && (text[i] == ' ' || text[i] == '\t'))
+			i++;
+		bool minus = false;
+		if (i < text.size() && (text[i] == '-' || text[i] == '+'))
+			minus = text[i++] == '-';
+
+		Natural digits;
+		uint32_t chunk = 0, chunk_digits = 0;
+		int64_t scale = 0;
+		bool any = false, fraction = false;
+		static const uint32_t POWERS[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+		for (; i < text.size(); i++) {
+			char c = text[i];
+			if (c == '.' && !fraction) {
+				fraction = true;
+				continue;
+			}
+			if (c < '0' || c > '9')
+				break;
+			any = true;
+			chunk = chunk * 10 + (uint32_t)(c - '0');
+			if (++chunk_digits == 9) {
+				Limbs::MultiplySmall(digits, POWERS[9], chunk);
+				chunk = chunk_digits = 0;
+			}
+			if (fraction)
+				scale--;
+		}
+		if (!any)
+			return NaN();
+		Limbs::MultiplySmall(digits, POWERS[chunk_digits], chunk);
+
+		if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+			bool negative_exponent = false;
+			if (++i < text.size() && (text[i] == '-' || text[i] == '+'))
+				negative_exponent = text[i++] == '-';
+			int64_t e = 0;
+			for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++)
+				e = std::min<int64_t>(e * 10 + (text[i] - '0'), 1000000000);
+			scale += (negative_exponent) ? -e : e;
+		}
+
+		BigFloat r;
+		{
+			uint64_t n = (uint64_t)((scale < 0) ? -scale : scale);
+			uint32_t guard = 2;
+			for (uint64_t m = n; m; m >>= 32)
+				guard++;
+			Working precision(limbs + guard);
+			r.mantissa = digits;
+			r.Strip();
+			if (n) {
+				BigFloat p = IntegerPower(Exact(10.0), n);
+				r = (scale < 0) ? r / p : r * p;
+			}
+		}
+		r = r.Rounded();
+		if (minus)
+			r = -r;
+		return r;
+	}
+
+	//Scientific notation with digits significant digits, rounded half up
+	std::string BigFloat::ToString(uint32_t digits) const {
+		if (nan)
+			return "nan";
+		if (mantissa.empty())
+			return "0";
+		digits = std::min(std::max(digits, 1u), BIG_FLOAT_MAX_DIGITS);
+
+		int64_t scale = 0;
+		double d = Leading(scale);
+		int64_t e10 = (int64_t)floor(log10(d) + 32.0 * (double)scale * 0.30102999566398119521);
+		std::string text;
+		{
+			uint32_t guard = 2;
+			for (uint64_t m = (uint64_t)((e10 < 0) ? -e10 : e10); m; m >>= 8)
+				guard++;
+			Working precision(LimbsFor(digits + 10) + guard);
+			BigFloat y = *this;
+			y.negative = false;
+			BigFloat p = IntegerPower(Exact(10.0), (uint64_t)((e10 < 0) ? -e10 : e10));
+			y = (e10 >= 0) ? y / p : y * p;
+			if (Compare(y, Exact(10.0)) >= 0) {
+				y = y.DivideSmall(10);
+				e10++;
+			}
+			else if (Compare(y, Exact(1.0)) < 0) {
+				y = y.MultiplySmall(10);
+				e10--;
+			}
+
+			uint32_t lead = y.Truncate().Residue();
+			text.push_back((char)('0' + lead));
+			y = y - Exact((double)lead);
+			while (text.size() < (size_t)digits + 1) {
+				y = y.MultiplySmall(1000000000);
+				BigFloat whole = y.Truncate();
+				char chunk[16];
+				snprintf(chunk, sizeof(chunk), "%09u", whole.Residue());
+				text += chunk;
+				y = y - whole;
+			}
+		}
+
+		bool up = text[digits] >= '5';
+		text.resize(digits);
+		for (size_t i = digits; up && i-- > 0;) {
+			up = text[i] == '9';
+			text[i] = (up) ? '0' : (char)(text[i] + 1);
+		}
+		if (up) {
+			text.insert(text.begin(), '1');
+			text.pop_back();
+			e10++;
+		}
+
+		char suffix[32];
+		snprintf(suffix, sizeof(suffix), "e%c%02lld", (e10 < 0) ? '-' : '+', (long long)((e10 < 0) ? -e10 : e10));
+		std::string out = (negative) ? "-" : "";
+		out += text[0];
+		if (digits > 1) {
+			out += '.';
+			out.append(text, 1, std::string::npos);
+		}
+		return out + suffix;
+	}
+
+	//Sum of 1 / ((2n + 1) k^(2n + 1)), with alternating signs this is atan(1 / k), without it atanh(1 / k).
+	//Every term is two short divisions, so constants cost no full multiplications at all
+	BigFloat BigFloat::ArctanhInverse(uint32_t k, bool alternating) {
+		BigFloat power = Exact(1.0).DivideSmall(k), sum = power;
+		uint32_t square = k * k;
+		for (uint32_t n = 1; n < 0x7FFFFFFF; n++) {
+			power = power.DivideSmall(square);
+			if (power.IsZero() || power.Magnitude() < sum.Magnitude() - (int64_t)limbs - 1)
+				break;
+			BigFloat term = power.DivideSmall(2 * n + 1);
+			sum = (alternating && (n & 1)) ? sum - term : sum + term;
+		}
+		return sum;
+	}
+
+	//Machin's formula, computed once per thread at the widest precision asked for so far
+	BigFloat BigFloat::Pi() {
+		thread_local BigFloat cached;
+		thread_local uint32_t cached_limbs = 0;
+		if (cached_limbs < limbs) {
+			Working precision(limbs + 1);
+			cached = ArctanhInverse(5, true).MultiplySmall(16) - ArctanhInverse(239, true).MultiplySmall(4);
+			cached_limbs = limbs;
+		}
+		return cached.Rounded();
+	}
+
+	//ln 2 = 2 atanh(1 / 3)
+	BigFloat BigFloat::Ln2() {
+		thread_local BigFloat cached;
+		thread_local uint32_t cached_limbs = 0;
+		if (cached_limbs < limbs) {
+			Working precision(limbs + 1);
+			cached = ArctanhInverse(3, false).Ldexp(1);
+			cached_limbs = limbs;
+		}
+		return cached.Rounded();
+	}
+
+	//Newton on 1 / sqrt(x), which needs no division, then one Karatsuba style correction of x / sqrt(x)
+	BigFloat Sqrt(const BigFloat& x) {
+		if (x.nan || x.negative)
+			return BigFloat::NaN();
+		if (x.mantissa.empty())
+			return BigFloat();
+
+		uint32_t target = BigFloat::limbs + 1;
+		int64_t scale = 0;
+		double d = x.Leading(scale);
+		if (scale & 1) {
+			d *= 4294967296.0;
+			scale--;
+		}
+		BigFloat y = BigFloat::Exact(1.0 / sqrt(d));
+		y.exponent -= scale / 2;
+
+		BigFloat one = BigFloat::Exact(1.0), s;
+		for (uint32_t working = 1; working < target;) {
+			working = std::min(2 * working, target);
+			BigFloat::Working precision(working + 1);
+			y = y + (y * (one - x * y * y)).Ldexp(-1);
+		}
+		{
+			BigFloat::Working precision(target + 1);
+			s = x * y;
+			s = s + (y * (x - s * s)).Ldexp(-1);
+		}
+		return s.Rounded();
+	}
+
+	//x = k ln 2 + r, then e^r from the Taylor series of e^(r / 2^s) - 1 squared back up s times as
+	//u = 2u + u^2, which keeps full relative precision even when e^r is close to one
+	BigFloat Exp(const BigFloat& x) {
+		if (x.nan)
+			return x;
+		if (x.mantissa.empty())
+			return BigFloat::Exact(1.0);
+		double approx = x.ToDouble();
+		if (fabs(approx) > 1e15)
+			return (x.negative) ? BigFloat() : BigFloat::NaN();
+
+		uint32_t target = BigFloat::limbs;
+		double k = nearbyint(approx / 0.69314718055994530942);
+		uint32_t halvings = (uint32_t)(sqrt(32.0 * target) / 2.0);
+		BigFloat result;
+		{
+			uint32_t guard = 2 + (uint32_t)(log2(fabs(k) + 1.0) / 32.0);
+			BigFloat::Working precision(target + guard);
+			BigFloat r = (x - BigFloat::Ln2() * BigFloat::Exact(k)).Ldexp(-(int64_t)halvings);
+			BigFloat sum = r, term = r;
+			if (!r.IsZero()) {
+				for (uint32_t n = 2; n < 0x7FFFFFFF; n++) {
+					term = (term * r).DivideSmall(n);
+					if (term.IsZero() || term.Magnitude() < sum.Magnitude() - (int64_t)BigFloat::limbs - 1)
+						break;
+					sum = sum + term;
+				}
+				for (uint32_t i = 0; i < halvings; i++)
+					sum = sum.Ldexp(1) + sum * sum;
+			}
+			result = (sum + BigFloat::Exact(1.0)).Ldexp((int64_t)k);
+		}
+		return result.Rounded();
+	}
+
+	//Halley's y = y + 2 (x - e^y) / (x + e^y) triples the correct digits per step, so only the last exponential runs at
+	//full precision. Arguments near one get extra limbs, since there the logarithm is small and needs them to stay relative
+	BigFloat Log(const BigFloat& x) {
+		if (x.nan || x.negative || x.mantissa.empty())
+			return BigFloat::NaN();
+
+		BigFloat one = BigFloat::Exact(1.0);
+		BigFloat delta = x - one;
+		if (delta.IsZero())
+			return BigFloat();
+		uint32_t target = BigFloat::limbs;
+		uint32_t guard = (delta.Magnitude() < 0) ? (uint32_t)std::min<int64_t>(-delta.Magnitude(), target) : 0;
+
+		int64_t scale = 0;
+		double d = x.Leading(scale);
+		BigFloat y = BigFloat::Exact(log(d) + 32.0 * (double)scale * 0.69314718055994530942);
+		if (guard)
+			y = delta;
+		for (uint32_t working = 1; working < target + guard;) {
+			working = std::min(3 * working, target + guard);
+			BigFloat::Working precision(working + 1);
+			BigFloat e = Exp(y);
+			y = y + ((x - e) / (x + e)).Ldexp(1);
+		}
+		return y.Rounded();
+	}
+
+	//x = k pi / 2 + r with |r| <= pi / 4, then 1 - cos(r / 2^s) from its series doubled back up s times as
+	//v = 2v (2 - v). Both sin and cos come from v, sin through sqrt(v (2 - v)), and k mod 4 picks between them
+	BigFloat BigFloat::Trig(const BigFloat& x, bool cosine) {
+		if (x.nan)
+			return x;
+		if (x.mantissa.empty())
+			return Exact((cosine) ? 1.0 : 0.0);
+		int64_t top = std::max<int64_t>(x.Magnitude(), 0);
+		if (top > 4096)
+			return NaN();
+
+		uint32_t target = limbs;
+		uint32_t halvings = (uint32_t)(sqrt(32.0 * target) / 2.0);
+		BigFloat result;
+		{
+			Working precision(target + 2 + (uint32_t)top);
+			BigFloat half_pi = Pi().Ldexp(-1), one = Exact(1.0), two = Exact(2.0);
+			BigFloat k = (x / half_pi + Exact((x.negative) ? -0.5 : 0.5)).Truncate();
+			uint32_t quadrant = k.Residue() & 3;
+			if (k.negative)
+				quadrant = (4 - quadrant) & 3;
+			BigFloat r = x - k * half_pi;
+
+			BigFloat v;
+			if (!r.IsZero()) {
+				BigFloat t = r.Ldexp(-(int64_t)halvings);
+				BigFloat t2 = t * t, term = t2.Ldexp(-1);
+				v = term;
+				for (uint32_t n = 2; n < 30000; n++) {
+					term = (term * t2).DivideSmall((2 * n - 1) * (2 * n));
+					if (term.IsZero() || term.Magnitude() < v.Magnitude() - (int64_t)limbs - 1)
+						break;
+					v = (n & 1) ? v + term : v - term;
+				}
+				for (uint32_t i = 0; i < halvings; i++)
+					v = (v * (two - v)).Ldexp(1);
+			}
+			BigFloat c = one - v;
+			BigFloat s = Sqrt(v * (two - v));
+			if (r.negative)
+				s = -s;
+
+			switch ((cosine) ? (quadrant + 1) & 3 : quadrant) {
+			case 0:
+				result = s;
+				break;
+			case 1:
+				result = c;
+				break;
+			case 2:
+				result = -s;
+				break;
+			default:
+				result = -c;
+				break;
+			}
+		}
+		return result.Rounded();
+	}
+
+	BigFloat Sin(const BigFloat& x) {
+		return BigFloat::Trig(x, false);
+	}
+
+	BigFloat Cos(const BigFloat& x) {
+		return BigFloat::Trig(x, true);
+	}
+
+	//Integer exponents below 2^32 go by repeated squaring and keep negative bases, anything else is e^(b ln a)
+	//with the logarithm carried wide enough that its absolute error stays below the result's precision
+	BigFloat Power(const BigFloat& a, const BigFloat& b) {
+		if (a.nan || b.nan)
+			return BigFloat::NaN();
+		if (b.mantissa.empty())
+			return BigFloat::Exact(1.0);
+
+		uint32_t target = BigFloat::limbs;
+		BigFloat result;
+		if (b.IsInteger() && b.Magnitude() <= 1) {
+			uint64_t n = b.Residue();
+			if (a.mantissa.empty())
+				return (b.negative) ? BigFloat::NaN() : BigFloat();
+			{
+				BigFloat::Working precision(target + 2);
+				result = BigFloat::IntegerPower(a, n);
+				if (b.negative)
+					result = BigFloat::Exact(1.0) / result;
+			}
+			return result.Rounded();
+		}
+		if (a.mantissa.empty())
+			return (b.negative) ? BigFloat::NaN() : BigFloat();
+		if (a.negative)
+			return BigFloat::NaN();
+
+		int64_t scale = 0;
+		double d = a.Leading(scale);
+		double reach = fabs(b.ToDouble() * (log(d) + 32.0 * (double)scale * 0.69314718055994530942));
+		{
+			uint32_t guard = 2 + (uint32_t)(log2(reach + 1.0) / 32.0);
+			BigFloat::Working precision(target + guard);
+			result = Exp(b * Log(a));
+		}
+		return result.Rounded();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef BIG_FLOAT_H
+#define BIG_FLOAT_H
+
+#include "Limbs.h"
+
+#include <string>
+#include <string_view>
+
+namespace MatLib {
+	constexpr uint32_t BIG_FLOAT_DEFAULT_DIGITS = 50;
+	constexpr uint32_t BIG_FLOAT_MAX_DIGITS = 100000;
+
+	//sign * mantissa * 2^(32 * exponent), rounded to the calling thread's working precision after every operation.
+	//There are no infinities, overflow and undefined results such as log(-1) are NaN
+	class BigFloat {
+	public:
+		BigFloat() = default;
+		BigFloat(double value);
+
+		static BigFloat Parse(std::string_view text);
+		static BigFloat NaN();
+		static BigFloat Pi();
+		static BigFloat Ln2();
+
+		bool IsZero() const { return !nan && mantissa.empty(); }
+		bool IsNaN() const { return nan; }
+		bool IsNegative() const { return negative; }
+		bool IsInteger() const { return !nan && (mantissa.empty() || exponent >= 0); }
+		double ToDouble() const;
+		std::string ToString(uint32_t digits) const;
+
+		//|x| < 2^(32 * Magnitude())
+		int64_t Magnitude() const;
+		BigFloat Ldexp(int64_t bits) const;
+		BigFloat Truncate() const;
+		BigFloat Rounded() const;
+		BigFloat MultiplySmall(uint32_t m) const;
+		BigFloat DivideSmall(uint32_t d) const;
+
+		friend BigFloat operator-(const BigFloat& a);
+		friend BigFloat operator+(const BigFloat& a, const BigFloat& b);
+		friend BigFloat operator-(const BigFloat& a, const BigFloat& b);
+		friend BigFloat operator*(const BigFloat& a, const BigFloat& b);
+		friend BigFloat operator/(const BigFloat& a, const BigFloat& b);
+		friend int Compare(const BigFloat& a, const BigFloat& b);
+
+		friend BigFloat Sqrt(const BigFloat& x);
+		friend BigFloat Exp(const BigFloat& x);
+		friend BigFloat Log(const BigFloat& x);
+		friend BigFloat Power(const BigFloat& a, const BigFloat& b);
+
+		//Digits are decimal, two guard limbs sit below them
+		static constexpr uint32_t LimbsFor(uint32_t digits) {
+			return (uint32_t)(((uint64_t)((digits < 1) ? 1 : (digits > BIG_FLOAT_MAX_DIGITS) ? BIG_FLOAT_MAX_DIGITS : digits) * 108853) >> 20) + 2;
+		}
+		static uint32_t Limbs() { return limbs; }
+
+		//Sets the working precision of the calling thread until the scope ends
+		class Precision {
+		public:
+			explicit Precision(uint32_t digits) : saved(limbs) { limbs = LimbsFor(digits); }
+			~Precision() { limbs = saved; }
+		private:
+			uint32_t saved = 0;
+		};
+	private:
+		Natural mantissa;
+		int64_t exponent = 0;
+		bool negative = false;
+		bool nan = false;
+
+		static thread_local uint32_t limbs;
+
+		//Same as Precision but counted in limbs, for the guard limbs inside an operation
+		struct Working {
+			explicit Working(uint32_t working) : saved(limbs) { limbs = working; }
+			~Working() { limbs = saved; }
+			uint32_t saved = 0;
+		};
+	private:
+		void Strip();
+		void Round();
+		double Leading(int64_t& scale) const;
+		uint32_t Residue() const;
+
+		static BigFloat Exact(double value);
+		static BigFloat Reciprocal(const BigFloat& b);
+		static BigFloat IntegerPower(const BigFloat& base, uint64_t n);
+		static BigFloat ArctanhInverse(uint32_t k, bool alternating);
+		static BigFloat Trig(const BigFloat& x, bool cosine);
+
+		friend BigFloat Sin(const BigFloat& x);
+		friend BigFloat Cos(const BigFloat& x);
+	};
+
+	BigFloat Sqrt(const BigFloat& x);
+	BigFloat Exp(const BigFloat& x);
+	BigFloat Log(const BigFloat& x);
+	BigFloat Sin(const BigFloat& x);
+	BigFloat Cos(const BigFloat& x);
+	BigFloat Power(const BigFloat& a, const BigFloat& b);
+	inline BigFloat Pow(const BigFloat& a, const BigFloat& b) { return Power(a, b); }
+}
+
+#endif // !BIG_FLOAT_H
\ No newline at end of file
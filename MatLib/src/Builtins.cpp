@@ -0,0 +1,34 @@
+#include "Builtins.h"
+#include "Interner.h"
+
+#include <vector>
+
+namespace MatLib {
+	namespace Builtins {
+		static const Builtin table[BUILTIN_COUNT] = {
+			{ "sin", 1, [](const double* args) { return Kernels::Sin(args[0]); }, [](double* const* args, double* out, size_t count) { Kernels::Sin(args[0], out, count); } },
+			{ "cos", 1, [](const double* args) { return Kernels::Cos(args[0]); }, [](double* const* args, double* out, size_t count) { Kernels::Cos(args[0], out, count); } },
+			{ "exp", 1, [](const double* args) { return Kernels::Exp(args[0]); }, [](double* const* args, double* out, size_t count) { Kernels::Exp(args[0], out, count); } },
+			{ "log", 1, [](const double* args) { return Kernels::Log(args[0]); }, [](double* const* args, double* out, size_t count) { Kernels::Log(args[0], out, count); } },
+			{ "sqrt", 1, [](const double* args) { return Kernels::Sqrt(args[0]); }, [](double* const* args, double* out, size_t count) { Kernels::Sqrt(args[0], out, count); } },
+			{ "pow", 2, [](const double* args) { return Kernels::Power(args[0], args[1]); }, [](double* const* args, double* out, size_t count) { Kernels::Power(args[0], args[1], out, count); } }
+		};
+
+		const Builtin& Get(int32_t id) {
+			return table[(id >= 0 && id < BUILTIN_COUNT) ? id : 0];
+		}
+
+		//Names are interned on first use, from the parser's thread like every other intern
+		int32_t Find(uint32_t symbol) {
+			static std::vector<uint32_t> symbols;
+			if (symbols.empty())
+				for (auto& builtin : table)
+					symbols.push_back(Interner::Global().Intern(builtin.name));
+
+			for (size_t i = 0; i < symbols.size(); i++)
+				if (symbols[i] == symbol)
+					return (int32_t)i;
+			return BUILTIN_NONE;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include "Dual.h"
+#include "Interval.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace MatLib {
+	enum {
+		BUILTIN_SIN,
+		BUILTIN_COS,
+		BUILTIN_EXP,
+		BUILTIN_LOG,
+		BUILTIN_SQRT,
+		BUILTIN_POW,
+		BUILTIN_COUNT
+	};
+
+	constexpr int32_t BUILTIN_NONE = -1;
+
+	//A function every script can call, a procedure of the same name shadows it. scalar and block run the same kernels
+	//(see Kernels.h for their error), so the VM, the tree walker and the batch evaluator agree to the last bit
+	struct Builtin {
+		const char* name = "";
+		uint32_t args = 0;
+		double (*scalar)(const double* args) = nullptr;
+		void (*block)(double* const* args, double* out, size_t count) = nullptr;
+	};
+
+	namespace Builtins {
+		const Builtin& Get(int32_t id);
+		int32_t Find(uint32_t symbol);
+
+		//Every numeric mode needs Sin, Cos, Exp, Log, Sqrt and Power overloads, missing arguments arrive as zero
+		template <typename T>
+		T Apply(int32_t id, const T* args) {
+			switch (id) {
+			case BUILTIN_SIN:
+				return Sin(args[0]);
+			case BUILTIN_COS:
+				return Cos(args[0]);
+			case BUILTIN_EXP:
+				return Exp(args[0]);
+			case BUILTIN_LOG:
+				return Log(args[0]);
+			case BUILTIN_SQRT:
+				return Sqrt(args[0]);
+			case BUILTIN_POW:
+				return Power(args[0], args[1]);
+			}
+			return T(0.0);
+		}
+	}
+
+	//Builds the value of a matrix literal from its elements in row order. Modes without matrices only give a 1x1
+	//literal a value, matrix mode overloads this to assemble the elements as blocks
+	template <typename T>
+	T Assemble(uint32_t rows, uint32_t cols, const std::vector<T>& elements) {
+		return (rows == 1 && cols == 1 && elements.size() == 1) ? elements[0] : T(NAN);
+	}
+}
+
+#endif // !BUILTINS_H
\ No newline at end of file
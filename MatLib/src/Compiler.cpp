@@ -0,0 +1,509 @@
+#include "Compiler.h"
+#include "Builtins.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace MatLib {
+	static std::atomic<uint64_t> program_counter{ 0 };
+
+	Program Compiler::Compile(Ast_Script* script) {
+		Program program;
+		this->script = script;
+		stats = CompilerStatistics();
+		inlinable.clear();
+		program.id = program_id = ++program_counter;
+		if (script) {
+			for (auto procedure : script->functions)
+				program.procedures.push_back(std::string(procedure->id->Name()));
+			for (auto& proc : script->procedures) {
+				if (proc->type != AST_ASSIGNMENT && proc->type != AST_RELATION)
+					continue;
+
+				CompiledAssignment compiled;
+				compiled.id = (proc->id) ? std::string(proc->id->Name()) : "";
+				compiled.line = proc->line;
+				compiled.chunk = CompileExpression(proc->expr);
+				if (proc->type == AST_RELATION)
+					program.relations.push_back(compiled);
+				else
+					program.assignments.push_back(compiled);
+			}
+		}
+		this->script = nullptr;
+		return program;
+	}
+
+	Chunk Compiler::CompileExpression(Ast_Expression* expr) {
+		Chunk chunk;
+		depth = 0;
+		uses.clear();
+		temps.clear();
+		inline_args = nullptr;
+		subroutine = false;
+		subroutines.clear();
+		patches.clear();
+		needed.assign((script) ? script->definitions.size() : 0, 0);
+		collected.clear();
+		Collect(expr);
+
+		//Definitions always precede their uses, so ascending slots is already an evaluation order
+		for (uint32_t slot = 0; slot < needed.size(); slot++)
+			if (needed[slot])
+				CountUses(script->definitions[slot]->expr);
+		CountUses(expr);
+		for (uint32_t slot = 0; slot < needed.size(); slot++) {
+			if (!needed[slot])
+				continue;
+			CompileNode(script->definitions[slot]->expr, chunk);
+			Emit(chunk, OP_STORE_VAR, slot);
+			chunk.slots = slot + 1;
+		}
+		CompileNode(expr, chunk);
+		if (chunk.code.empty())
+			EmitConstant(chunk, 0.0);
+		Emit(chunk, OP_RETURN);
+		CompileSubroutines(chunk);
+		chunk.program = program_id;
+		return chunk;
+	}
+
+	//Nodes reached from more than one parent (after hash consing) are computed once and kept in a temp
+	void Compiler::CountUses(Ast_Expression* expr) {
+		if (!expr || uses[expr]++ > 0)
+			return;
+
+		switch (expr->type) {
+		case AST_UNARY:
+			CountUses(AST_CAST(Ast_UnaryExpression, expr)->next);
+			break;
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			CountUses(p->nested);
+			if (p->call)
+				for (auto arg : p->call->args)
+					CountUses(arg);
+			break;
+		}
+		case AST_BINARY:
+			CountUses(AST_CAST(Ast_BinaryExpression, expr)->left);
+			CountUses(AST_CAST(Ast_BinaryExpression, expr)->right);
+			break;
+		case AST_MATRIX:
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				CountUses(element);
+			break;
+		}
+	}
+
+	//Marks every variable the chunk reads, including those read inside the procedures it calls
+	void Compiler::Collect(Ast_Expression* expr) {
+		if (!expr || !collected.insert(expr).second)
+			return;
+
+		switch (expr->type) {
+		case AST_UNARY:
+			Collect(AST_CAST(Ast_UnaryExpression, expr)->next);
+			break;
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			Collect(p->nested);
+			if (p->ident && !p->ident->local && p->ident->slot >= 0 && (size_t)p->ident->slot < needed.size() && !needed[p->ident->slot]) {
+				needed[p->ident->slot] = 1;
+				Collect(script->definitions[p->ident->slot]->expr);
+			}
+			if (p->call) {
+				for (auto arg : p->call->args)
+					Collect(arg);
+				if (Ast_Procedure* callee = script->Callee(p->call))
+					Collect(callee->expr);
+			}
+			break;
+		}
+		case AST_BINARY:
+			Collect(AST_CAST(Ast_BinaryExpression, expr)->left);
+			Collect(AST_CAST(Ast_BinaryExpression, expr)->right);
+			break;
+		case AST_MATRIX:
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				Collect(element);
+			break;
+		}
+	}
+
+	void Compiler::CompileCall(Ast_ProcedureCall* call, Chunk& chunk) {
+		if (call->builtin >= 0) {
+			for (auto arg : call->args)
+				CompileNode(arg, chunk);
+			Emit(chunk, OP_CALL_BUILTIN, (uint32_t)call->builtin, (uint16_t)call->args.size());
+			return;
+		}
+
+		//Resolve reported the call, it has nothing to run with these arguments
+		Ast_Procedure* callee = (script) ? script->Callee(call) : nullptr;
+		if (!callee) {
+			EmitConstant(chunk, NAN);
+			return;
+		}
+
+		size_t count = callee->args.size();
+		if (Memoized(callee)) {
+			for (auto arg : call->args)
+				CompileNode(arg, chunk);
+			if (std::find(subroutines.begin(), subroutines.end(), callee) == subroutines.end())
+				subroutines.push_back(callee);
+			MemoSite site;
+			site.memo = (uint32_t)call->procedure;
+			chunk.memo_sites.push_back(site);
+			chunk.memos = (site.memo + 1 > chunk.memos) ? site.memo + 1 : chunk.memos;
+			patches.push_back({ chunk.code.size(), callee });
+			Emit(chunk, OP_CALL_MEMO, (uint32_t)chunk.memo_sites.size() - 1, (uint16_t)count);
+			stats.memo_calls++;
+			return;
+		}
+
+		if (Inlinable(callee)) {
+			//Constants, free names, the caller's own inlined parameters and any argument the body reads at most once
+			//are substituted directly, anything else is evaluated once into a temp. A substituted argument keeps the
+			//caller's parameters so it compiles as if it were still in place
+			InlineArg args[PROCEDURE_MAX_ARGS];
+			for (size_t i = 0; i < count; i++) {
+				Ast_Expression* arg = call->args[i];
+				while (arg && arg->type == AST_PRIMARY && AST_CAST(Ast_PrimaryExpression, arg)->nested)
+					arg = AST_CAST(Ast_PrimaryExpression, arg)->nested;
+				auto p = (arg && arg->type == AST_PRIMARY) ? AST_CAST(Ast_PrimaryExpression, arg) : nullptr;
+				if ((p && !p->call && !(p->ident && p->ident->local)) || LocalUses(callee->expr, (int32_t)i) <= 1) {
+					args[i].leaf = arg;
+					args[i].scope = inline_args;
+					continue;
+				}
+				if (p && p->ident && p->ident->local && inline_args) {
+					args[i] = inline_args[p->ident->slot];
+					continue;
+				}
+				CompileNode(arg, chunk);
+				args[i].temp = chunk.temps++;
+				Emit(chunk, OP_POP_TEMP, args[i].temp);
+			}
+			CompileBody(callee->expr, chunk, args, subroutine);
+			stats.inlined++;
+			return;
+		}
+
+		for (auto arg : call->args)
+			CompileNode(arg, chunk);
+		if (std::find(subroutines.begin(), subroutines.end(), callee) == subroutines.end())
+			subroutines.push_back(callee);
+		patches.push_back({ chunk.code.size(), callee });
+		Emit(chunk, OP_CALL, 0, (uint16_t)count);
+		stats.calls++;
+	}
+
+	//A body gets its own use counts and temps since its nodes take different values at every call
+	void Compiler::CompileBody(Ast_Expression* body, Chunk& chunk, const InlineArg* args, bool subroutine) {
+		std::unordered_map<Ast_Expression*, uint32_t> outer_uses, outer_temps;
+		std::swap(uses, outer_uses);
+		std::swap(temps, outer_temps);
+		const InlineArg* outer_args = inline_args;
+		bool outer_subroutine = this->subroutine;
+		inline_args = args;
+		this->subroutine = subroutine;
+
+		CountUses(body);
+		CompileNode(body, chunk);
+
+		std::swap(uses, outer_uses);
+		std::swap(temps, outer_temps);
+		inline_args = outer_args;
+		this->subroutine = outer_subroutine;
+	}
+
+	//Calls cannot recurse, so every subroutine appears at most once on the call stack and the stack bound is a sum
+	void Compiler::CompileSubroutines(Chunk& chunk) {
+		std::unordered_map<Ast_Procedure*, uint32_t> entries;
+		uint32_t frame_stack = 0;
+		for (size_t i = 0; i < subroutines.size(); i++) {
+			Ast_Procedure* procedure = subroutines[i];
+			entries[procedure] = (uint32_t)chunk.code.size();
+
+			uint32_t max_stack = chunk.max_stack;
+			chunk.max_stack = 0;
+			depth = 0;
+			CompileBody(procedure->expr, chunk, nullptr, true);
+			Emit(chunk, OP_RET);
+			frame_stack += chunk.max_stack;
+			chunk.max_stack = max_stack;
+		}
+
+		for (auto& patch : patches) {
+			Instruction& call = chunk.code[patch.first];
+			if (call.op == OP_CALL_MEMO)
+				chunk.memo_sites[call.operand].entry = entries[patch.second];
+			else
+				call.operand = entries[patch.second];
+		}
+		chunk.max_stack += frame_stack;
+		chunk.frames = (uint32_t)subroutines.size();
+		stats.subroutines += (uint32_t)subroutines.size();
+	}
+
+	void Compiler::SetMemoized(std::string_view name, bool enabled) {
+		uint32_t symbol = Interner::Global().Intern(name);
+		auto it = std::find(memoized.begin(), memoized.end(), symbol);
+		if (enabled && it == memoized.end())
+			memoized.push_back(symbol);
+		else if (!enabled && it != memoized.end())
+			memoized.erase(it);
+	}
+
+	bool Compiler::IsMemoized(std::string_view name) const {
+		return std::find(memoized.begin(), memoized.end(), Interner::Global().Find(name)) != memoized.end();
+	}
+
+	//Only pure procedures qualify, a memo keyed on the arguments alone would be wrong for anything reading x or a variable
+	bool Compiler::Memoized(Ast_Procedure* procedure) const {
+		return procedure->pure && std::find(memoized.begin(), memoized.end(), procedure->id->symbol) != memoized.end();
+	}
+
+	bool Compiler::Inlinable(Ast_Procedure* procedure) {
+		if (!inlining || Memoized(procedure))
+			return false;
+		auto it = inlinable.find(procedure);
+		if (it != inlinable.end())
+			return it->second;
+
+		uint32_t cost = 0;
+		InlineCost(procedure->expr, cost);
+		return inlinable[procedure] = (cost <= INLINE_MAX_NODES);
+	}
+
+	//Size of the fully expanded body, stops counting once it is over the limit
+	void Compiler::InlineCost(Ast_Expression* expr, uint32_t& cost) {
+		if (!expr || cost > INLINE_MAX_NODES)
+			return;
+
+		cost++;
+		switch (expr->type) {
+		case AST_UNARY:
+			InlineCost(AST_CAST(Ast_UnaryExpression, expr)->next, cost);
+			break;
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			InlineCost(p->nested, cost);
+			if (p->call) {
+				for (auto arg : p->call->args)
+					InlineCost(arg, cost);
+				Ast_Procedure* callee = script->Callee(p->call);
+				if (callee && Inlinable(callee))
+					InlineCost(callee->expr, cost);
+			}
+			break;
+		}
+		case AST_BINARY:
+			InlineCost(AST_CAST(Ast_BinaryExpression, expr)->left, cost);
+			InlineCost(AST_CAST(Ast_BinaryExpression, expr)->right, cost);
+			break;
+		case AST_MATRIX:
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				InlineCost(element, cost);
+			break;
+		}
+	}
+
+	//Reads of parameter slot in the tree under expr. Calls count their arguments but not the callee, whose parameters
+	//are its own
+	uint32_t Compiler::LocalUses(Ast_Expression* expr, int32_t slot) {
+		if (!expr)
+			return 0;
+
+		uint32_t count = 0;
+		switch (expr->type) {
+		case AST_UNARY:
+			return LocalUses(AST_CAST(Ast_UnaryExpression, expr)->next, slot);
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			if (p->nested)
+				return LocalUses(p->nested, slot);
+			if (p->call)
+				for (auto arg : p->call->args)
+					count += LocalUses(arg, slot);
+			else if (p->ident && p->ident->local && p->ident->slot == slot)
+				count++;
+			return count;
+		}
+		case AST_BINARY:
+			return LocalUses(AST_CAST(Ast_BinaryExpression, expr)->left, slot) + LocalUses(AST_CAST(Ast_BinaryExpression, expr)->right, slot);
+		case AST_MATRIX:
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				count += LocalUses(element, slot);
+			return count;
+		}
+		return 0;
+	}
+
+	void Compiler::CompileNode(Ast_Expression* expr, Chunk& chunk) {
+		if (!expr) {
+			EmitConstant(chunk, 0.0);
+			return;
+		}
+
+		//Leaves are cheaper to reload than to keep, but a call hash consing shared is computed once
+		bool shared = (expr->type != AST_PRIMARY || AST_CAST(Ast_PrimaryExpression, expr)->call) && uses[expr] > 1;
+		if (shared) {
+			auto it = temps.find(expr);
+			if (it != temps.end()) {
+				Emit(chunk, OP_LOAD_TEMP, it->second);
+				return;
+			}
+		}
+
+		switch (expr->type) {
+		case AST_UNARY: {
+			auto u = AST_CAST(Ast_UnaryExpression, expr);
+			CompileNode(u->next, chunk);
+			if (u->op == AST_UNARY_MINUS)
+				Emit(chunk, OP_NEGATE);
+			break;
+		}
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			if (p->nested)
+				CompileNode(p->nested, chunk);
+			else if (p->call)
+				CompileCall(p->call, chunk);
+			else if (p->ident && p->ident->local) {
+				if (inline_args && inline_args[p->ident->slot].leaf) {
+					const InlineArg* outer_args = inline_args;
+					inline_args = outer_args[p->ident->slot].scope;
+					CompileNode(outer_args[p->ident->slot].leaf, chunk);
+					inline_args = outer_args;
+				}
+				else if (inline_args)
+					Emit(chunk, OP_LOAD_TEMP, inline_args[p->ident->slot].temp);
+				else if (subroutine)
+					Emit(chunk, OP_LOAD_ARG, p->ident->slot);
+				else
+					EmitConstant(chunk, 0.0);
+			}
+			else if (p->ident && p->ident->slot >= 0 && (size_t)p->ident->slot < needed.size())
+				Emit(chunk, OP_LOAD_VAR, p->ident->slot);
+			else if (p->ident) {
+				uint32_t slot = 0;
+				while (slot < COMPILER_INPUTS && p->ident->symbol != inputs[slot])
+					slot++;
+				if (slot < COMPILER_INPUTS)
+					Emit(chunk, OP_INPUT, slot);
+				else
+					EmitConstant(chunk, 0.0);
+			}
+			else
+				EmitConstant(chunk, p->num_const);
+			break;
+		}
+		case AST_BINARY: {
+			auto b = AST_CAST(Ast_BinaryExpression, expr);
+			switch (b->op) {
+			case AST_OPERATOR_ADD:
+			case AST_OPERATOR_SUB:
+			case AST_OPERATOR_MULTIPLICATIVE:
+			case AST_OPERATOR_DIVISION:
+			case AST_OPERATOR_POWER:
+				break;
+			default:
+				//Matches the tree walker, unsupported operators evaluate to zero
+				EmitConstant(chunk, 0.0);
+				return;
+			}
+
+			CompileNode(b->left, chunk);
+			CompileNode(b->right, chunk);
+
+			switch (b->op) {
+			case AST_OPERATOR_ADD:
+				Emit(chunk, OP_ADD);
+				break;
+			case AST_OPERATOR_SUB:
+				Emit(chunk, OP_SUB);
+				break;
+			case AST_OPERATOR_MULTIPLICATIVE:
+				Emit(chunk, OP_MUL);
+				break;
+			case AST_OPERATOR_DIVISION:
+				Emit(chunk, OP_DIV);
+				break;
+			case AST_OPERATOR_POWER:
+				Emit(chunk, OP_POW);
+				break;
+			}
+			break;
+		}
+		case AST_MATRIX: {
+			//Programs run in doubles, where a 1x1 matrix is its element and anything larger has no value
+			auto m = AST_CAST(Ast_MatrixExpression, expr);
+			if (m->elements.size() == 1)
+				CompileNode(m->elements[0], chunk);
+			else
+				EmitConstant(chunk, NAN);
+			break;
+		}
+		default:
+			EmitConstant(chunk, 0.0);
+			break;
+		}
+
+		if (shared) {
+			temps[expr] = chunk.temps;
+			Emit(chunk, OP_STORE_TEMP, chunk.temps++);
+		}
+	}
+
+	void Compiler::EmitConstant(Chunk& chunk, double value) {
+		for (uint32_t i = 0; i < chunk.constants.size(); i++) {
+			if (std::memcmp(&chunk.constants[i], &value, sizeof(double)) == 0) {
+				Emit(chunk, OP_CONST, i);
+				return;
+			}
+		}
+		chunk.constants.push_back(value);
+		Emit(chunk, OP_CONST, (uint32_t)chunk.constants.size() - 1);
+	}
+
+	void Compiler::Emit(Chunk& chunk, uint8_t op, uint32_t operand, uint16_t count) {
+		Instruction instruction;
+		instruction.op = op;
+		instruction.count = count;
+		instruction.operand = operand;
+		chunk.code.push_back(instruction);
+
+		switch (op) {
+		case OP_CONST:
+		case OP_INPUT:
+		case OP_LOAD_TEMP:
+		case OP_LOAD_VAR:
+		case OP_LOAD_ARG:
+			depth++;
+			break;
+		case OP_CALL:
+		case OP_CALL_MEMO:
+		case OP_CALL_BUILTIN:
+			depth = depth + 1 - count;
+			break;
+		case OP_STORE_VAR:
+		case OP_POP_TEMP:
+		case OP_RET:
+		case OP_ADD:
+		case OP_SUB:
+		case OP_MUL:
+		case OP_DIV:
+		case OP_POW:
+		case OP_RETURN:
+			depth--;
+			break;
+		}
+
+		if (depth > chunk.max_stack)
+			chunk.max_stack = depth;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "Parser.h"
+
+#include <unordered_set>
+
+namespace MatLib {
+	enum : uint8_t {
+		OP_CONST,
+		OP_INPUT,
+		OP_NEGATE,
+		OP_ADD,
+		OP_SUB,
+		OP_MUL,
+		OP_DIV,
+		OP_POW,
+		OP_LOAD_TEMP,
+		OP_STORE_TEMP,
+		OP_LOAD_VAR,
+		OP_STORE_VAR,
+		OP_POP_TEMP,
+		OP_LOAD_ARG,
+		OP_CALL,
+		OP_CALL_MEMO,
+		OP_CALL_BUILTIN,
+		OP_RET,
+		OP_RETURN
+	};
+
+	constexpr uint32_t COMPILER_INPUTS = 2;
+	constexpr uint32_t INLINE_MAX_NODES = 64;
+
+	//count is the argument count of the call ops and fits in the padding after op
+	struct Instruction {
+		uint8_t op = OP_RETURN;
+		uint16_t count = 0;
+		uint32_t operand = 0;
+	};
+
+	//A memoized call site, memo is the callee's procedure index and names its table in the VM
+	struct MemoSite {
+		uint32_t entry = 0;
+		uint32_t memo = 0;
+	};
+
+	//program identifies the compile the chunk came from, memo tables filled by another program are dropped
+	struct Chunk {
+		std::vector<Instruction> code;
+		std::vector<double> constants;
+		std::vector<MemoSite> memo_sites;
+		uint32_t max_stack = 0;
+		uint32_t temps = 0;
+		uint32_t slots = 0;
+		uint32_t frames = 0;
+		uint32_t memos = 0;
+		uint64_t program = 0;
+	};
+
+	struct CompiledAssignment {
+		std::string id = "";
+		uint32_t line = 0;
+		Chunk chunk;
+	};
+
+	//Relations are compiled as lhs - rhs, so the curve is where the chunk evaluates to zero.
+	//Every chunk first stores the variables it reads into their environment slots, so any chunk runs on its own
+	struct Program {
+		std::vector<CompiledAssignment> assignments;
+		std::vector<CompiledAssignment> relations;
+		std::vector<std::string> procedures;
+		uint64_t id = 0;
+	};
+
+	struct CompilerStatistics {
+		uint32_t inlined = 0;
+		uint32_t calls = 0;
+		uint32_t memo_calls = 0;
+		uint32_t subroutines = 0;
+	};
+
+	//Small procedures are expanded in place with their arguments in temps, the rest become subroutines placed after the
+	//chunk's OP_RETURN and entered with OP_CALL. Arguments stay on the value stack as the callee's frame, so a call
+	//only pushes a return address onto the VM's preallocated frame stack
+	class Compiler {
+	public:
+		Program Compile(Ast_Script* script);
+		Chunk CompileExpression(Ast_Expression* expr);
+
+		void SetInput(std::string_view id, uint32_t slot = 0) { if (slot < COMPILER_INPUTS) inputs[slot] = Interner::Global().Intern(id); }
+		void SetInlining(bool enabled) { inlining = enabled; }
+		void SetMemoized(std::string_view name, bool enabled);
+		bool IsMemoized(std::string_view name) const;
+		const CompilerStatistics& Statistics() const { return stats; }
+	private:
+		struct InlineArg {
+			Ast_Expression* leaf = nullptr;
+			const InlineArg* scope = nullptr;
+			uint32_t temp = 0;
+		};
+
+		uint32_t inputs[COMPILER_INPUTS] = { Interner::Global().Intern("x"), Interner::Global().Intern("y") };
+		uint32_t depth = 0;
+		std::unordered_map<Ast_Expression*, uint32_t> uses;
+		std::unordered_map<Ast_Expression*, uint32_t> temps;
+		Ast_Script* script = nullptr;
+		std::vector<uint8_t> needed;
+		std::unordered_set<Ast_Expression*> collected;
+		std::unordered_map<Ast_Procedure*, bool> inlinable;
+		const InlineArg* inline_args = nullptr;
+		bool subroutine = false;
+		bool inlining = true;
+		std::vector<Ast_Procedure*> subroutines;
+		std::vector<std::pair<size_t, Ast_Procedure*>> patches;
+		std::vector<uint32_t> memoized;
+		uint64_t program_id = 0;
+		CompilerStatistics stats;
+	private:
+		void CountUses(Ast_Expression* expr);
+		void Collect(Ast_Expression* expr);
+		void CompileCall(Ast_ProcedureCall* call, Chunk& chunk);
+		void CompileBody(Ast_Expression* body, Chunk& chunk, const InlineArg* args, bool subroutine);
+		void CompileSubroutines(Chunk& chunk);
+		bool Inlinable(Ast_Procedure* procedure);
+		bool Memoized(Ast_Procedure* procedure) const;
+		void InlineCost(Ast_Expression* expr, uint32_t& cost);
+		uint32_t LocalUses(Ast_Expression* expr, int32_t slot);
+		void CompileNode(Ast_Expression* expr, Chunk& chunk);
+		void Emit(Chunk& chunk, uint8_t op, uint32_t operand = 0, uint16_t count = 0);
+		void EmitConstant(Chunk& chunk, double value);
+	};
+}
+
+#endif // !COMPILER_H
\ No newline at end of file
@@ -0,0 +1,124 @@
+#ifndef COMPLEX_H
+#define COMPLEX_H
+
+#include "Dual.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+namespace MatLib {
+	//Integer exponents up to this size go by repeated squaring, so polynomials stay exact on the real axis
+	constexpr double COMPLEX_MAX_SQUARING = 64.0;
+
+	//re + i im, the branch cuts of log, sqrt and non-integer powers lie along the negative real axis
+	struct Complex {
+		double re = 0.0;
+		double im = 0.0;
+
+		Complex() = default;
+		Complex(double re) : re(re) { }
+		Complex(double re, double im) : re(re), im(im) { }
+
+		bool IsFinite() const { return std::isfinite(re) && std::isfinite(im); }
+
+		//Reads "a", "bi", "a+bi" or "a-bi", a bare i is the imaginary unit
+		static Complex Parse(std::string_view text) {
+			std::string s;
+			for (char c : text)
+				if (c != ' ')
+					s += c;
+			const char* p = s.c_str();
+			Complex c;
+			for (int term = 0; term < 2; term++) {
+				if (!*p)
+					break;
+				char* end = nullptr;
+				double value = strtod(p, &end);
+				if (end == p) {
+					//A bare or signed i has a coefficient of one
+					const char* unit = (*p == '+' || *p == '-') ? p + 1 : p;
+					if (*unit != 'i')
+						return Complex(NAN, NAN);
+					value = (*p == '-') ? -1.0 : 1.0;
+					end = (char*)unit;
+				}
+				if (*end == 'i') {
+					c.im += value;
+					end++;
+				}
+				else
+					c.re += value;
+				p = end;
+			}
+			return c;
+		}
+
+		std::string ToString() const {
+			char text[64];
+			snprintf(text, sizeof(text), "%.17g%+.17gi", re, im);
+			return text;
+		}
+	};
+
+	//Subtracting from zero never makes a -0, which would put -4 on the far side of the branch cut and give sqrt(-4) = -2i
+	inline Complex operator-(const Complex& a) { return Complex(0.0 - a.re, 0.0 - a.im); }
+	inline Complex operator+(const Complex& a, const Complex& b) { return Complex(a.re + b.re, a.im + b.im); }
+	inline Complex operator-(const Complex& a, const Complex& b) { return Complex(a.re - b.re, a.im - b.im); }
+	inline Complex operator*(const Complex& a, const Complex& b) { return Complex(a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re); }
+
+	//The divisor is scaled by its larger component first so |b|^2 can not overflow or underflow, Kernels::ComplexDiv
+	//runs the same steps
+	inline Complex operator/(const Complex& a, const Complex& b) {
+		double s = 1.0 / fmax(fabs(b.re), fabs(b.im));
+		double c = b.re * s, d = b.im * s;
+		double r = s / (c * c + d * d);
+		return Complex((a.re * c + a.im * d) * r, (a.im * c - a.re * d) * r);
+	}
+
+	inline double Abs(const Complex& a) { return hypot(a.re, a.im); }
+	inline double Arg(const Complex& a) { return atan2(a.im, a.re); }
+
+	inline Complex Exp(const Complex& a) {
+		double e = Exp(a.re);
+		return Complex(e * Cos(a.im), e * Sin(a.im));
+	}
+
+	inline Complex Log(const Complex& a) { return Complex(Log(Abs(a)), Arg(a)); }
+
+	inline Complex Sin(const Complex& a) { return Complex(Sin(a.re) * cosh(a.im), Cos(a.re) * sinh(a.im)); }
+	inline Complex Cos(const Complex& a) { return Complex(Cos(a.re) * cosh(a.im), -Sin(a.re) * sinh(a.im)); }
+
+	//Principal root, the half angle form avoids cancellation on either side of the imaginary axis
+	inline Complex Sqrt(const Complex& a) {
+		if (a.re == 0.0 && a.im == 0.0)
+			return Complex();
+		double t = Sqrt(0.5 * (Abs(a) + fabs(a.re)));
+		if (a.re >= 0.0)
+			return Complex(t, a.im / (2.0 * t));
+		return Complex(fabs(a.im) / (2.0 * t), copysign(t, a.im));
+	}
+
+	inline Complex Power(const Complex& a, const Complex& b) {
+		if (b.im == 0.0 && b.re == floor(b.re) && fabs(b.re) <= COMPLEX_MAX_SQUARING) {
+			Complex result(1.0), square = a;
+			for (uint32_t n = (uint32_t)fabs(b.re); n; n >>= 1) {
+				if (n & 1)
+					result = result * square;
+				if (n > 1)
+					square = square * square;
+			}
+			return (b.re < 0.0) ? Complex(1.0) / result : result;
+		}
+		if (a.re == 0.0 && a.im == 0.0)
+			return (b.re > 0.0) ? Complex() : Complex(NAN, NAN);
+		return Exp(b * Log(a));
+	}
+
+	inline Complex Pow(const Complex& a, const Complex& b) { return Power(a, b); }
+}
+
+#endif // !COMPLEX_H
\ No newline at end of file
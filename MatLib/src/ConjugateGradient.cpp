@@ -0,0 +1,205 @@
+#include "ConjugateGradient.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+namespace MatLib {
+	//Elements per vector job, also the granularity of the partial sums
+	static const size_t CG_CHUNK = 8192;
+
+	Preconditioner::Preconditioner(const SparseMatrix& a, int type) {
+		this->type = type;
+		rows = a.Rows();
+		if (type == PRECONDITIONER_ILU0 && FactorIlu0(a))
+			return;
+		if (type == PRECONDITIONER_NONE)
+			return;
+
+		this->type = PRECONDITIONER_JACOBI;
+		factor = SparseMatrix();
+		diagonal.clear();
+		inverse_diagonal.resize(a.Rows());
+		a.Diagonal(inverse_diagonal.data());
+		for (auto& d : inverse_diagonal)
+			d = (d != 0.0) ? 1.0 / d : 1.0;
+	}
+
+	//Row by row Gaussian elimination that drops every fill-in outside A's pattern. position maps a column of the row
+	//being eliminated to its entry, so an update from row k finds its target in one load
+	bool Preconditioner::FactorIlu0(const SparseMatrix& a) {
+		if (a.Rows() != a.Cols())
+			return false;
+		factor = a;
+		uint32_t n = factor.Rows();
+		const auto& offsets = factor.Offsets();
+		const auto& columns = factor.Columns();
+		auto& values = factor.Values();
+		diagonal.assign(n, 0);
+		std::vector<size_t> position(n, SIZE_MAX);
+
+		for (uint32_t i = 0; i < n; i++) {
+			for (size_t p = offsets[i]; p < offsets[i + 1]; p++)
+				position[columns[p]] = p;
+			if (position[i] == SIZE_MAX)
+				return false;
+			diagonal[i] = position[i];
+
+			for (size_t p = offsets[i]; p < diagonal[i]; p++) {
+				uint32_t k = columns[p];
+				values[p] /= values[diagonal[k]];
+				for (size_t q = diagonal[k] + 1; q < offsets[k + 1]; q++)
+					if (position[columns[q]] != SIZE_MAX)
+						values[position[columns[q]]] -= values[p] * values[q];
+			}
+			if (values[diagonal[i]] == 0.0 || !std::isfinite(values[diagonal[i]]))
+				return false;
+
+			for (size_t p = offsets[i]; p < offsets[i + 1]; p++)
+				position[columns[p]] = SIZE_MAX;
+		}
+		return true;
+	}
+
+	void Preconditioner::Apply(const double* r, double* z) const {
+		switch (type) {
+		case PRECONDITIONER_JACOBI:
+			for (size_t i = 0; i < inverse_diagonal.size(); i++)
+				z[i] = r[i] * inverse_diagonal[i];
+			return;
+		case PRECONDITIONER_ILU0: {
+			const auto& offsets = factor.Offsets();
+			const auto& columns = factor.Columns();
+			const auto& values = factor.Values();
+			uint32_t n = factor.Rows();
+			//L has a unit diagonal, U keeps the pivots
+			for (uint32_t i = 0; i < n; i++) {
+				double sum = r[i];
+				for (size_t p = offsets[i]; p < diagonal[i]; p++)
+					sum -= values[p] * z[columns[p]];
+				z[i] = sum;
+			}
+			for (uint32_t i = n; i-- > 0;) {
+				double sum = z[i];
+				for (size_t p = diagonal[i] + 1; p < offsets[i + 1]; p++)
+					sum -= values[p] * z[columns[p]];
+				z[i] = sum / values[diagonal[i]];
+			}
+			return;
+		}
+		}
+		for (size_t i = 0; i < rows; i++)
+			z[i] = r[i];
+	}
+
+	//Runs fn(begin, end) over CG_CHUNK sized pieces of [0, n) and returns the sum of what the pieces return, added in
+	//chunk order whatever thread computed them
+	template <typename Fn>
+	static double Chunked(size_t n, ThreadPool* pool, std::vector<double>& partial, const Fn& fn) {
+		size_t chunks = (n + CG_CHUNK - 1) / CG_CHUNK;
+		partial.assign(chunks, 0.0);
+		auto job = [&](size_t chunk, size_t /*thread*/) {
+			partial[chunk] = fn(chunk * CG_CHUNK, std::min(n, (chunk + 1) * CG_CHUNK));
+		};
+		if (chunks <= 1 || pool->Threads() == 1) {
+			for (size_t i = 0; i < chunks; i++)
+				job(i, 0);
+		}
+		else
+			pool->Run(chunks, job);
+
+		double sum = 0.0;
+		for (double s : partial)
+			sum += s;
+		return sum;
+	}
+
+	CgResult ConjugateGradient(const SparseMatrix& a, const double* b, double* x, const CgOptions& options) {
+		CgResult result;
+		if (a.Rows() != a.Cols())
+			return result;
+
+		ThreadPool* pool = (options.pool) ? options.pool : &ThreadPool::Shared();
+		size_t n = a.Rows();
+		auto start = std::chrono::high_resolution_clock::now();
+		Preconditioner m(a, options.preconditioner);
+		result.preconditioner = m.Type();
+		auto setup = std::chrono::high_resolution_clock::now();
+		result.setup_milliseconds = std::chrono::duration<double, std::milli>(setup - start).count();
+
+		std::vector<double> r(n), z(n), p(n), q(n), partial;
+		a.Multiply(x, q.data(), pool);
+		double bb = Chunked(n, pool, partial, [&](size_t begin, size_t end) {
+			double sum = 0.0;
+			for (size_t i = begin; i < end; i++) {
+				r[i] = b[i] - q[i];
+				sum += b[i] * b[i];
+			}
+			return sum;
+		});
+		double norm = (bb > 0.0) ? sqrt(bb) : 1.0;
+
+		result.residual = sqrt(Chunked(n, pool, partial, [&](size_t begin, size_t end) {
+			double sum = 0.0;
+			for (size_t i = begin; i < end; i++)
+				sum += r[i] * r[i];
+			return sum;
+		})) / norm;
+
+		m.Apply(r.data(), z.data());
+		p = z;
+		double rz = Chunked(n, pool, partial, [&](size_t begin, size_t end) {
+			double sum = 0.0;
+			for (size_t i = begin; i < end; i++)
+				sum += r[i] * z[i];
+			return sum;
+		});
+
+		while (result.residual > options.tolerance && result.iterations < options.max_iterations) {
+			a.Multiply(p.data(), q.data(), pool);
+			double pq = Chunked(n, pool, partial, [&](size_t begin, size_t end) {
+				double sum = 0.0;
+				for (size_t i = begin; i < end; i++)
+					sum += p[i] * q[i];
+				return sum;
+			});
+			//Only a matrix that is not positive definite (or a breakdown from rounding) gives a non-positive curvature
+			if (!(pq > 0.0))
+				break;
+
+			double alpha = rz / pq;
+			result.residual = sqrt(Chunked(n, pool, partial, [&](size_t begin, size_t end) {
+				double sum = 0.0;
+				for (size_t i = begin; i < end; i++) {
+					x[i] += alpha * p[i];
+					r[i] -= alpha * q[i];
+					sum += r[i] * r[i];
+				}
+				return sum;
+			})) / norm;
+			result.iterations++;
+			if (result.residual <= options.tolerance)
+				break;
+
+			m.Apply(r.data(), z.data());
+			double rz_next = Chunked(n, pool, partial, [&](size_t begin, size_t end) {
+				double sum = 0.0;
+				for (size_t i = begin; i < end; i++)
+					sum += r[i] * z[i];
+				return sum;
+			});
+			double beta = rz_next / rz;
+			rz = rz_next;
+			Chunked(n, pool, partial, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					p[i] = z[i] + beta * p[i];
+				return 0.0;
+			});
+		}
+
+		result.converged = (result.residual <= options.tolerance);
+		result.solve_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - setup).count();
+		return result;
+	}
+}
\ No newline at end of file
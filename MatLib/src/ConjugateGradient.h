@@ -0,0 +1,56 @@
+#ifndef CONJUGATE_GRADIENT_H
+#define CONJUGATE_GRADIENT_H
+
+#include "SparseMatrix.h"
+
+namespace MatLib {
+	enum {
+		PRECONDITIONER_NONE,
+		PRECONDITIONER_JACOBI,
+		PRECONDITIONER_ILU0
+	};
+
+	struct CgOptions {
+		uint32_t max_iterations = 1000;
+		//Stops once |b - A x| <= tolerance * |b|
+		double tolerance = 1e-10;
+		int preconditioner = PRECONDITIONER_JACOBI;
+		ThreadPool* pool = nullptr;
+	};
+
+	struct CgResult {
+		uint32_t iterations = 0;
+		double residual = 0.0;
+		bool converged = false;
+		int preconditioner = PRECONDITIONER_NONE;
+		double setup_milliseconds = 0.0;
+		double solve_milliseconds = 0.0;
+	};
+
+	//M with M^-1 close to A^-1 for a symmetric positive definite A. Jacobi divides by the diagonal, ILU(0) factors A into
+	//L U on A's own pattern so it costs one more copy of the values. A zero pivot falls back to Jacobi, and a zero on
+	//the diagonal is read as one
+	class Preconditioner {
+	public:
+		Preconditioner() = default;
+		Preconditioner(const SparseMatrix& a, int type);
+
+		//z = M^-1 r, the ILU(0) triangular solves run in row order on one thread
+		void Apply(const double* r, double* z) const;
+		int Type() const { return type; }
+	private:
+		int type = PRECONDITIONER_NONE;
+		size_t rows = 0;
+		std::vector<double> inverse_diagonal;
+		SparseMatrix factor;
+		std::vector<size_t> diagonal;
+	private:
+		bool FactorIlu0(const SparseMatrix& a);
+	};
+
+	//Solves A x = b for a symmetric positive definite A starting from the x passed in. Products and vector updates run
+	//on the pool, and the sums are taken over fixed chunks so the result does not depend on the thread count
+	CgResult ConjugateGradient(const SparseMatrix& a, const double* b, double* x, const CgOptions& options = CgOptions());
+}
+
+#endif // !CONJUGATE_GRADIENT_H
\ No newline at end of file
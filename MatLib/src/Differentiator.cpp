@@ -0,0 +1,428 @@
+#include "Differentiator.h"
+#include "Builtins.h"
+#include "Optimizer.h"
+#include "Logger.h"
+
+#include <cmath>
+
+namespace MatLib {
+	Differentiator::Differentiator(Parser* parser) {
+		this->parser = parser;
+	}
+
+	//Appends f' for every assignment f in the script
+	void Differentiator::Run(std::string_view name) {
+		if (!parser || !parser->Root())
+			return;
+
+		uint32_t variable = Interner::Global().Intern(name);
+		auto& procedures = parser->Root()->procedures;
+		size_t count = procedures.size();
+		for (size_t i = 0; i < count; i++) {
+			if (procedures[i]->type == AST_ASSIGNMENT) {
+				auto derivative = DifferentiateAssignment(AST_CAST(Ast_Assignment, procedures[i]), variable);
+				if (derivative)
+					procedures.push_back(derivative);
+			}
+		}
+	}
+
+	Ast_Assignment* Differentiator::DifferentiateAssignment(Ast_Assignment* assign, uint32_t variable) {
+		auto expr = Differentiate(assign->expr, variable);
+		if (!expr)
+			return nullptr;
+
+		auto derivative = parser->AstArena().New<Ast_Assignment>();
+		derivative->line = assign->line;
+		derivative->id = parser->AstArena().New<Ast_Identifier>();
+		derivative->id->line = assign->line;
+		derivative->id->symbol = Interner::Global().Intern(std::string((assign->id) ? assign->id->Name() : std::string_view()) + "'");
+		derivative->expr = expr;
+		return derivative;
+	}
+
+	//The result shares untouched subtrees of expr, which is safe because both live in the parser's arena
+	Ast_Expression* Differentiator::Differentiate(Ast_Expression* expr, uint32_t variable) {
+		if (!parser || !expr)
+			return nullptr;
+		line = expr->line;
+		return Derive(expr, variable);
+	}
+
+	Ast_Expression* Differentiator::Derive(Ast_Expression* expr, uint32_t variable) {
+		if (!expr)
+			return nullptr;
+
+		switch (expr->type) {
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			if (p->nested)
+				return Derive(p->nested, variable);
+			if (p->call && p->call->builtin >= 0)
+				return DeriveBuiltin(p, variable);
+			if (p->call) {
+				//Differentiated through the callee's body with the arguments in place of its parameters. Calls Resolve
+				//reported evaluate to NaN, and so does their derivative
+				Ast_Procedure* callee = parser->Root()->Callee(p->call);
+				if (!callee)
+					return Constant(NAN);
+				return Derive(Substitute(callee->expr, p->call->args), variable);
+			}
+			if (p->ident && p->ident->slot < 0 && p->ident->symbol == variable)
+				return Constant(1.0);
+			//A variable is differentiated through its definition, the chain rule by substitution
+			if (Ast_Statement* definition = Definition(p->ident))
+				return Derive(definition->expr, variable);
+			return Constant(0.0);
+		}
+		case AST_UNARY: {
+			auto u = AST_CAST(Ast_UnaryExpression, expr);
+			auto du = Derive(u->next, variable);
+			if (!du)
+				return nullptr;
+			return (u->op == AST_UNARY_MINUS) ? Negate(du) : du;
+		}
+		case AST_BINARY: {
+			auto b = AST_CAST(Ast_BinaryExpression, expr);
+			if (b->op == AST_OPERATOR_POWER)
+				return DerivePower(b, variable);
+
+			auto du = Derive(b->left, variable);
+			auto dv = Derive(b->right, variable);
+			if (!du || !dv)
+				return nullptr;
+
+			switch (b->op) {
+			case AST_OPERATOR_ADD:
+				return Add(du, dv);
+			case AST_OPERATOR_SUB:
+				return Sub(du, dv);
+			case AST_OPERATOR_MULTIPLICATIVE:
+				return Add(Mul(du, b->right), Mul(b->left, dv));
+			case AST_OPERATOR_DIVISION:
+				return Div(Sub(Mul(du, b->right), Mul(b->left, dv)), Mul(b->right, b->right));
+			}
+			EMBER_LOG_ERROR("Cannot differentiate operator %d on line %d.", b->op, b->line);
+			return nullptr;
+		}
+		case AST_MATRIX: {
+			auto m = AST_CAST(Ast_MatrixExpression, expr);
+			auto derivative = parser->AstArena().New<Ast_MatrixExpression>();
+			derivative->line = line;
+			derivative->rows = m->rows;
+			derivative->cols = m->cols;
+			for (auto element : m->elements) {
+				auto de = Derive(element, variable);
+				if (!de)
+					return nullptr;
+				derivative->elements.push_back(de);
+			}
+			return derivative;
+		}
+		}
+		return nullptr;
+	}
+
+	Ast_Expression* Differentiator::DerivePower(Ast_BinaryExpression* b, uint32_t variable) {
+		bool base_varies = DependsOn(b->left, variable);
+		bool exponent_varies = DependsOn(b->right, variable);
+
+		if (!base_varies && !exponent_varies)
+			return Constant(0.0);
+
+		//d(u^c) = c * u^(c - 1) * du
+		if (!exponent_varies) {
+			auto du = Derive(b->left, variable);
+			if (!du)
+				return nullptr;
+			return Mul(Mul(b->right, Pow(b->left, Sub(b->right, Constant(1.0)))), du);
+		}
+
+		//d(a^v) = a^v * ln(a) * dv, with ln(a) folded to a number when a is one
+		auto dv = Derive(b->right, variable);
+		if (!dv)
+			return nullptr;
+		double base = 0.0;
+		if (!base_varies && Optimizer::IsConstant(b->left, &base))
+			return Mul(Mul(b, Constant(log(base))), dv);
+		if (!base_varies)
+			return Mul(Mul(b, Call(BUILTIN_LOG, b->left)), dv);
+
+		//d(u^v) = u^v * (dv * ln(u) + v * du / u)
+		auto du = Derive(b->left, variable);
+		if (!du)
+			return nullptr;
+		return Mul(b, Add(Mul(dv, Call(BUILTIN_LOG, b->left)), Div(Mul(b->right, du), b->left)));
+	}
+
+	//The call node itself is reused wherever the derivative contains the function's own value
+	Ast_Expression* Differentiator::DeriveBuiltin(Ast_PrimaryExpression* p, uint32_t variable) {
+		auto call = p->call;
+		Ast_Expression* u = (call->args.size() > 0) ? call->args[0] : Constant(0.0);
+		Ast_Expression* v = (call->args.size() > 1) ? call->args[1] : Constant(0.0);
+		if (!DependsOn(p, variable))
+			return Constant(0.0);
+
+		if (call->builtin == BUILTIN_POW) {
+			bool exponent_varies = DependsOn(v, variable);
+			auto du = Derive(u, variable);
+			auto dv = (exponent_varies) ? Derive(v, variable) : Constant(0.0);
+			if (!du || !dv)
+				return nullptr;
+			//d(u^c) = c * u^(c - 1) * du
+			if (!exponent_varies)
+				return Mul(Mul(v, Call(BUILTIN_POW, u, Sub(v, Constant(1.0)))), du);
+			return Mul(p, Add(Mul(dv, Call(BUILTIN_LOG, u)), Div(Mul(v, du), u)));
+		}
+
+		auto du = Derive(u, variable);
+		if (!du)
+			return nullptr;
+		switch (call->builtin) {
+		case BUILTIN_SIN:
+			return Mul(Call(BUILTIN_COS, u), du);
+		case BUILTIN_COS:
+			return Mul(Negate(Call(BUILTIN_SIN, u)), du);
+		case BUILTIN_EXP:
+			return Mul(p, du);
+		case BUILTIN_LOG:
+			return Div(du, u);
+		case BUILTIN_SQRT:
+			return Div(du, Mul(Constant(2.0), p));
+		}
+		EMBER_LOG_ERROR("Cannot differentiate the call to '%.*s' on line %d.", (int)call->id->Name().size(), call->id->Name().data(), p->line);
+		return nullptr;
+	}
+
+	Ast_Statement* Differentiator::Definition(Ast_Identifier* ident) {
+		if (!ident || ident->local || ident->slot < 0 || !parser->Root() || (size_t)ident->slot >= parser->Root()->definitions.size())
+			return nullptr;
+		return parser->Root()->definitions[ident->slot];
+	}
+
+	bool Differentiator::DependsOn(Ast_Expression* expr, uint32_t variable) {
+		if (!expr)
+			return false;
+
+		switch (expr->type) {
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			if (p->nested)
+				return DependsOn(p->nested, variable);
+			if (p->call) {
+				for (auto arg : p->call->args)
+					if (DependsOn(arg, variable))
+						return true;
+				Ast_Procedure* callee = (p->call->builtin < 0) ? parser->Root()->Callee(p->call) : nullptr;
+				return callee && DependsOn(callee->expr, variable);
+			}
+			//A parameter stands for its argument, which was already checked at the call
+			if (p->ident && p->ident->local)
+				return false;
+			if (Ast_Statement* definition = Definition(p->ident))
+				return DependsOn(definition->expr, variable);
+			return (p->ident && p->ident->symbol == variable);
+		}
+		case AST_UNARY:
+			return DependsOn(AST_CAST(Ast_UnaryExpression, expr)->next, variable);
+		case AST_BINARY: {
+			auto b = AST_CAST(Ast_BinaryExpression, expr);
+			return DependsOn(b->left, variable) || DependsOn(b->right, variable);
+		}
+		case AST_MATRIX:
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				if (DependsOn(element, variable))
+					return true;
+			return false;
+		}
+		return false;
+	}
+
+	//Copy of a procedure body with every parameter replaced by its argument, missing arguments are zero. Subtrees that
+	//read no parameter are shared rather than copied
+	Ast_Expression* Differentiator::Substitute(Ast_Expression* expr, const std::vector<Ast_Expression*>& args) {
+		if (!expr)
+			return nullptr;
+
+		switch (expr->type) {
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			if (p->ident && p->ident->local)
+				return ((size_t)p->ident->slot < args.size()) ? args[p->ident->slot] : Constant(0.0);
+			if (p->nested) {
+				auto nested = Substitute(p->nested, args);
+				if (nested == p->nested)
+					return expr;
+				auto prime = parser->AstArena().New<Ast_PrimaryExpression>();
+				prime->line = line;
+				prime->nested = nested;
+				return prime;
+			}
+			if (!p->call)
+				return expr;
+
+			std::vector<Ast_Expression*> call_args(p->call->args.size());
+			bool changed = false;
+			for (size_t i = 0; i < call_args.size(); i++) {
+				call_args[i] = Substitute(p->call->args[i], args);
+				changed = changed || call_args[i] != p->call->args[i];
+			}
+			if (!changed)
+				return expr;
+			auto call = parser->AstArena().New<Ast_ProcedureCall>();
+			call->line = line;
+			call->id = p->call->id;
+			call->procedure = p->call->procedure;
+			call->builtin = p->call->builtin;
+			call->args = std::move(call_args);
+			auto prime = parser->AstArena().New<Ast_PrimaryExpression>();
+			prime->line = line;
+			prime->call = call;
+			return prime;
+		}
+		case AST_UNARY: {
+			auto u = AST_CAST(Ast_UnaryExpression, expr);
+			auto next = Substitute(u->next, args);
+			if (next == u->next)
+				return expr;
+			auto copy = parser->AstArena().New<Ast_UnaryExpression>(next, u->op);
+			copy->line = line;
+			return copy;
+		}
+		case AST_BINARY: {
+			auto b = AST_CAST(Ast_BinaryExpression, expr);
+			auto left = Substitute(b->left, args);
+			auto right = Substitute(b->right, args);
+			if (left == b->left && right == b->right)
+				return expr;
+			return Binary(left, b->op, right);
+		}
+		case AST_MATRIX: {
+			auto m = AST_CAST(Ast_MatrixExpression, expr);
+			auto copy = parser->AstArena().New<Ast_MatrixExpression>();
+			copy->line = line;
+			copy->rows = m->rows;
+			copy->cols = m->cols;
+			bool changed = false;
+			for (auto element : m->elements) {
+				copy->elements.push_back(Substitute(element, args));
+				changed = changed || copy->elements.back() != element;
+			}
+			return (changed) ? copy : expr;
+		}
+		}
+		return expr;
+	}
+
+	Ast_Expression* Differentiator::Constant(double value) {
+		auto prime = parser->AstArena().New<Ast_PrimaryExpression>();
+		prime->line = line;
+		prime->num_const = value;
+		return prime;
+	}
+
+	Ast_Expression* Differentiator::Negate(Ast_Expression* expr) {
+		double value = 0.0;
+		if (Optimizer::IsConstant(expr, &value))
+			return Constant(-value);
+		if (expr->type == AST_UNARY && AST_CAST(Ast_UnaryExpression, expr)->op == AST_UNARY_MINUS)
+			return AST_CAST(Ast_UnaryExpression, expr)->next;
+
+		auto u = parser->AstArena().New<Ast_UnaryExpression>(expr, AST_UNARY_MINUS);
+		u->line = line;
+		return u;
+	}
+
+	//The builders below fold the zeros and ones produced by the rules, treating 0*u as 0
+	Ast_Expression* Differentiator::Add(Ast_Expression* left, Ast_Expression* right) {
+		double l = 0.0, r = 0.0;
+		bool lc = Optimizer::IsConstant(left, &l), rc = Optimizer::IsConstant(right, &r);
+		if (lc && rc)
+			return Constant(l + r);
+		if (lc && l == 0.0)
+			return right;
+		if (rc && r == 0.0)
+			return left;
+		return Binary(left, AST_OPERATOR_ADD, right);
+	}
+
+	Ast_Expression* Differentiator::Sub(Ast_Expression* left, Ast_Expression* right) {
+		double l = 0.0, r = 0.0;
+		bool lc = Optimizer::IsConstant(left, &l), rc = Optimizer::IsConstant(right, &r);
+		if (lc && rc)
+			return Constant(l - r);
+		if (lc && l == 0.0)
+			return Negate(right);
+		if (rc && r == 0.0)
+			return left;
+		return Binary(left, AST_OPERATOR_SUB, right);
+	}
+
+	Ast_Expression* Differentiator::Mul(Ast_Expression* left, Ast_Expression* right) {
+		double l = 0.0, r = 0.0;
+		bool lc = Optimizer::IsConstant(left, &l), rc = Optimizer::IsConstant(right, &r);
+		if (lc && rc)
+			return Constant(l * r);
+		if ((lc && l == 0.0) || (rc && r == 0.0))
+			return Constant(0.0);
+		if (lc && l == 1.0)
+			return right;
+		if (rc && r == 1.0)
+			return left;
+		if (lc && l == -1.0)
+			return Negate(right);
+		if (rc && r == -1.0)
+			return Negate(left);
+		return Binary(left, AST_OPERATOR_MULTIPLICATIVE, right);
+	}
+
+	Ast_Expression* Differentiator::Div(Ast_Expression* left, Ast_Expression* right) {
+		double l = 0.0, r = 0.0;
+		bool lc = Optimizer::IsConstant(left, &l), rc = Optimizer::IsConstant(right, &r);
+		if (lc && rc)
+			return Constant(l / r);
+		if (lc && l == 0.0)
+			return Constant(0.0);
+		if (rc && r == 1.0)
+			return left;
+		return Binary(left, AST_OPERATOR_DIVISION, right);
+	}
+
+	Ast_Expression* Differentiator::Pow(Ast_Expression* left, Ast_Expression* right) {
+		double l = 0.0, r = 0.0;
+		bool lc = Optimizer::IsConstant(left, &l), rc = Optimizer::IsConstant(right, &r);
+		if (lc && rc)
+			return Constant(pow(l, r));
+		if (rc && r == 0.0)
+			return Constant(1.0);
+		if (rc && r == 1.0)
+			return left;
+		return Binary(left, AST_OPERATOR_POWER, right);
+	}
+
+	Ast_Expression* Differentiator::Binary(Ast_Expression* left, int op, Ast_Expression* right) {
+		auto b = parser->AstArena().New<Ast_BinaryExpression>(left, op, right);
+		b->line = line;
+		return b;
+	}
+
+	//Built for the built-in directly, so a procedure of the same name cannot capture it
+	Ast_Expression* Differentiator::Call(int32_t builtin, Ast_Expression* first, Ast_Expression* second) {
+		auto call = parser->AstArena().New<Ast_ProcedureCall>();
+		call->line = line;
+		call->id = parser->AstArena().New<Ast_Identifier>();
+		call->id->line = line;
+		call->id->symbol = Interner::Global().Intern(Builtins::Get(builtin).name);
+		call->id->slot = SLOT_NONE;
+		call->procedure = SLOT_NONE;
+		call->builtin = builtin;
+		call->args.push_back(first);
+		if (second)
+			call->args.push_back(second);
+
+		auto prime = parser->AstArena().New<Ast_PrimaryExpression>();
+		prime->line = line;
+		prime->call = call;
+		return prime;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef DIFFERENTIATOR_H
+#define DIFFERENTIATOR_H
+
+#include "Parser.h"
+
+namespace MatLib {
+	class Differentiator {
+	public:
+		Differentiator() = default;
+		Differentiator(Parser* parser);
+
+		void Run(std::string_view name);
+		Ast_Expression* Differentiate(Ast_Expression* expr, uint32_t variable);
+		Ast_Assignment* DifferentiateAssignment(Ast_Assignment* assign, uint32_t variable);
+
+		bool DependsOn(Ast_Expression* expr, uint32_t variable);
+	private:
+		Parser* parser = nullptr;
+		uint32_t line = 0;
+	private:
+		Ast_Expression* Derive(Ast_Expression* expr, uint32_t variable);
+		Ast_Expression* DerivePower(Ast_BinaryExpression* b, uint32_t variable);
+		Ast_Expression* DeriveBuiltin(Ast_PrimaryExpression* p, uint32_t variable);
+		Ast_Statement* Definition(Ast_Identifier* ident);
+		Ast_Expression* Substitute(Ast_Expression* expr, const std::vector<Ast_Expression*>& args);
+
+		Ast_Expression* Constant(double value);
+		Ast_Expression* Negate(Ast_Expression* expr);
+		Ast_Expression* Add(Ast_Expression* left, Ast_Expression* right);
+		Ast_Expression* Sub(Ast_Expression* left, Ast_Expression* right);
+		Ast_Expression* Mul(Ast_Expression* left, Ast_Expression* right);
+		Ast_Expression* Div(Ast_Expression* left, Ast_Expression* right);
+		Ast_Expression* Pow(Ast_Expression* left, Ast_Expression* right);
+		Ast_Expression* Binary(Ast_Expression* left, int op, Ast_Expression* right);
+		Ast_Expression* Call(int32_t builtin, Ast_Expression* first, Ast_Expression* second = nullptr);
+	};
+}
+
+#endif // !DIFFERENTIATOR_H
\ No newline at end of file
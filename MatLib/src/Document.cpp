@@ -0,0 +1,153 @@
+#include "Document.h"
+
+#include <algorithm>
+
+namespace MatLib {
+	Document::Document(Lexer* lexer, Parser* parser) {
+		this->lexer = lexer;
+		this->parser = parser;
+	}
+
+	//The editor widget hands over the whole text, the common prefix and suffix reduce it to the one range that changed
+	bool Document::Sync(std::string_view text) {
+		size_t size = buffer.Size();
+		size_t prefix = 0;
+		while (prefix < size && prefix < text.size() && buffer.At(prefix) == text[prefix])
+			prefix++;
+		if (prefix == size && prefix == text.size())
+			return false;
+
+		size_t suffix = 0;
+		while (suffix < size - prefix && suffix < text.size() - prefix && buffer.At(size - 1 - suffix) == text[text.size() - 1 - suffix])
+			suffix++;
+
+		Edit(prefix, size - prefix - suffix, text.substr(prefix, text.size() - prefix - suffix));
+		return true;
+	}
+
+	void Document::Edit(size_t position, size_t count, std::string_view text) {
+		if (!pending) {
+			edit_start = Clock::now();
+			pending = true;
+		}
+
+		size_t first_start = 0, last_start = 0;
+		size_t first = FindLine(position, first_start);
+		size_t last = FindLine(position + count, last_start);
+		size_t region = last_start + lines[last].length - first_start;
+
+		buffer.Replace(position, count, text);
+
+		//Re-split only the lines the edit overlapped, everything after them keeps its statements
+		size_t new_region = region - count + text.size();
+		std::vector<Line> replaced(1);
+		for (size_t i = first_start; i < first_start + new_region; i++) {
+			if (buffer.At(i) == '\n')
+				replaced.emplace_back();
+			else
+				replaced.back().length++;
+		}
+
+		lines.erase(lines.begin() + first, lines.begin() + last + 1);
+		lines.insert(lines.begin() + first, replaced.begin(), replaced.end());
+	}
+
+	//Returns the line holding position and its first character, a position on a newline belongs to the line it ends
+	size_t Document::FindLine(size_t position, size_t& start) const {
+		start = 0;
+		for (size_t i = 0; i < lines.size(); i++) {
+			if (position <= start + lines[i].length)
+				return i;
+			start += lines[i].length + 1;
+		}
+		start -= lines.back().length + 1;
+		return lines.size() - 1;
+	}
+
+	void Document::Rebuild() {
+		rebuild = true;
+	}
+
+	//Statements dropped by edits stay in the arena until the next rebuild, which happens once the arena has doubled
+	void Document::Update() {
+		if (!lexer || !parser)
+			return;
+
+		auto start = Clock::now();
+		if (!rebuild && parser->AllocationStatistics().bytes_used > 2 * rebuild_bytes + ARENA_BLOCK_SIZE)
+			rebuild = true;
+		if (rebuild || !parser->Root()) {
+			parser->Begin();
+			for (auto& line : lines)
+				line.dirty = true;
+			stats.rebuilds++;
+		}
+
+		stats.lines = (uint32_t)lines.size();
+		stats.relexed = 0;
+		stats.reparsed = 0;
+		stats.first_changed = (uint32_t)lines.size();
+		stats.last_changed = 0;
+
+		//Resolving can show reused lines whose names now bind differently, those are parsed again from fresh nodes
+		ParseLines();
+		stale.clear();
+		parser->Resolve(&stale);
+		while (!stale.empty()) {
+			std::sort(stale.begin(), stale.end());
+			for (auto& line : lines)
+				for (auto statement : line.statements)
+					if (std::binary_search(stale.begin(), stale.end(), statement))
+						line.dirty = true;
+			ParseLines();
+			stale.clear();
+			parser->Resolve(&stale);
+		}
+
+		if (rebuild) {
+			rebuild_bytes = parser->AllocationStatistics().bytes_used;
+			rebuild = false;
+		}
+		stats.update_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	void Document::ParseLines() {
+		stats.reused = 0;
+		auto& procedures = parser->Root()->procedures;
+		procedures.clear();
+		size_t offset = 0;
+		for (size_t i = 0; i < lines.size(); i++) {
+			Line& line = lines[i];
+			if (line.dirty) {
+				line.statements.clear();
+				buffer.Copy(offset, line.length, line_text);
+				line_tokens.clear();
+				lexer->Scan(line_text, (uint32_t)i + 1, line_tokens);
+				parser->ParseTokens(line_tokens.data(), line_tokens.size(), line.statements);
+				line.dirty = false;
+
+				stats.relexed++;
+				stats.reparsed += (uint32_t)line.statements.size();
+				stats.first_changed = (i < stats.first_changed) ? (uint32_t)i : stats.first_changed;
+				stats.last_changed = (uint32_t)i;
+			}
+			else {
+				for (auto statement : line.statements)
+					statement->line = (uint32_t)i + 1;
+				stats.reused += (uint32_t)line.statements.size();
+			}
+
+			procedures.insert(procedures.end(), line.statements.begin(), line.statements.end());
+			offset += line.length + 1;
+		}
+	}
+
+	//Call once the results of the latest edit are on screen, closes the keystroke to result measurement
+	void Document::Finish() {
+		if (!pending)
+			return;
+		pending = false;
+		stats.latency_ms = std::chrono::duration<double, std::milli>(Clock::now() - edit_start).count();
+		stats.max_latency_ms = (stats.latency_ms > stats.max_latency_ms) ? stats.latency_ms : stats.max_latency_ms;
+	}
+}
\ No newline at end of file
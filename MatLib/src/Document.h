@@ -0,0 +1,67 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include "GapBuffer.h"
+#include "Parser.h"
+
+#include <chrono>
+
+namespace MatLib {
+	struct DocumentStatistics {
+		uint32_t lines = 0;
+		uint32_t first_changed = 0;
+		uint32_t last_changed = 0;
+		uint32_t relexed = 0;
+		uint32_t reparsed = 0;
+		uint32_t reused = 0;
+		uint32_t rebuilds = 0;
+		double update_ms = 0.0;
+		double latency_ms = 0.0;
+		double max_latency_ms = 0.0;
+	};
+
+	//Editor model for compile as you type. Text lives in a gap buffer split into lines, an edit marks only the lines it
+	//touches and Update re-lexes and re-parses just those, keeping the statements of every other line. The parser's root
+	//is rebuilt from the lines after each update, so the later stages see an ordinary script
+	class Document {
+	public:
+		Document() = default;
+		Document(Lexer* lexer, Parser* parser);
+
+		bool Sync(std::string_view text);
+		void Edit(size_t position, size_t count, std::string_view text);
+		void Update();
+		void Rebuild();
+		void Finish();
+
+		const GapBuffer& Buffer() const { return buffer; }
+		const DocumentStatistics& Statistics() const { return stats; }
+	private:
+		using Clock = std::chrono::high_resolution_clock;
+
+		struct Line {
+			size_t length = 0;
+			bool dirty = true;
+			std::vector<Ast_Statement*> statements;
+		};
+
+		Lexer* lexer = nullptr;
+		Parser* parser = nullptr;
+		GapBuffer buffer;
+		std::vector<Line> lines = std::vector<Line>(1);
+		bool rebuild = true;
+		size_t rebuild_bytes = 0;
+
+		Clock::time_point edit_start;
+		bool pending = false;
+		std::string line_text;
+		std::vector<Token> line_tokens;
+		std::vector<Ast_Statement*> stale;
+		DocumentStatistics stats;
+	private:
+		size_t FindLine(size_t position, size_t& start) const;
+		void ParseLines();
+	};
+}
+
+#endif // !DOCUMENT_H
\ No newline at end of file
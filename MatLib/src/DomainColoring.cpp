@@ -0,0 +1,117 @@
+#include "DomainColoring.h"
+
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace MatLib {
+	DomainColoring::DomainColoring(FunctionSolver* solver, ThreadPool* pool) {
+		this->solver = solver;
+		this->pool = pool;
+	}
+
+	void DomainColoring::SetFunction(size_t assignment) {
+		this->assignment = assignment;
+		Reset();
+	}
+
+	void DomainColoring::SetView(const SamplerView& view) {
+		if (view.x0 != this->view.x0 || view.x1 != this->view.x1 || view.y0 != this->view.y0 || view.y1 != this->view.y1 ||
+			view.width != this->view.width || view.height != this->view.height) {
+			this->view = view;
+			dirty = true;
+		}
+	}
+
+	//Also drops the per thread interpreters, call it after every compile so they copy the new script state
+	void DomainColoring::Reset() {
+		workers.clear();
+		dirty = true;
+	}
+
+	//Recolors the whole view in one go, returns false when nothing changed since the last call
+	bool DomainColoring::Sample() {
+		if (!dirty)
+			return false;
+		dirty = false;
+		stats = DomainStatistics();
+		Ast_Expression* expr = (solver) ? solver->AssignmentExpression(assignment) : nullptr;
+		if (!expr || !pool || !(view.x0 < view.x1) || !(view.y0 < view.y1)) {
+			pixels.clear();
+			return true;
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		uint32_t step = (scale) ? scale : 1;
+		uint32_t width = (view.width + step - 1) / step, height = (view.height + step - 1) / step;
+		if (width == 0 || height == 0) {
+			pixels.clear();
+			return true;
+		}
+		if (workers.size() != pool->Threads())
+			workers.assign(pool->Threads(), *solver);
+		rows.resize(pool->Threads());
+		pixels.resize((size_t)width * height);
+
+		double dx = (view.x1 - view.x0) / width, dy = (view.y1 - view.y0) / height;
+		pool->Run(height, [&](size_t y, size_t thread) {
+			Row& row = rows[thread];
+			row.re.resize(width);
+			row.im.assign(width, view.y1 - dy * (y + 0.5));
+			row.out_re.resize(width);
+			row.out_im.resize(width);
+			for (uint32_t x = 0; x < width; x++)
+				row.re[x] = view.x0 + dx * (x + 0.5);
+
+			workers[thread].EvaluateComplexBatch(expr, row.re.data(), row.im.data(), row.out_re.data(), row.out_im.data(), width);
+			uint32_t* line = pixels.data() + y * width;
+			for (uint32_t x = 0; x < width; x++)
+				line[x] = Color(row.out_re[x], row.out_im[x]);
+		});
+
+		stats.width = width;
+		stats.height = height;
+		stats.evaluations = width * height;
+		stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return true;
+	}
+
+	//Hue from the argument with red on the positive real axis, value from the fractional part of log2 |f|. Both only
+	//feed 8-bit channels, so atan2 is a minimax polynomial on one octant (1e-5 rad) and log2 reads the exponent bits
+	//with a cubic for the mantissa. |f|^2 past the double range counts as a pole and below it as a zero
+	uint32_t DomainColoring::Color(double re, double im) {
+		double square = re * re + im * im;
+		if (!std::isfinite(square))
+			return 0xFFFFFFFF;
+		if (square < DBL_MIN)
+			return 0xFF000000;
+
+		double x = fabs(re), y = fabs(im);
+		double a = fmin(x, y) / fmax(x, y), s = a * a;
+		double angle = ((-0.0464964749 * s + 0.15931422) * s - 0.327622764) * s * a + a;
+		if (y > x)
+			angle = 1.57079632679489662 - angle;
+		if (re < 0.0)
+			angle = 3.14159265358979324 - angle;
+		double hue = angle * (3.0 / 3.14159265358979324);
+		if (im < 0.0)
+			hue = 6.0 - hue;
+
+		uint64_t bits;
+		memcpy(&bits, &square, sizeof(bits));
+		int64_t exponent = (int64_t)((bits >> 52) & 0x7FF) - 1023;
+		bits = (bits & 0x000FFFFFFFFFFFFFull) | 0x3FF0000000000000ull;
+		double t;
+		memcpy(&t, &bits, sizeof(t));
+		t -= 1.0;
+		double level = 0.5 * ((double)exponent + t * (1.4425449 + t * (-0.7181452 + t * 0.2755684)));
+		double value = 0.6 + 0.4 * (level - floor(level));
+
+		double rgb[3] = { fabs(hue - 3.0) - 1.0, 2.0 - fabs(hue - 2.0), 2.0 - fabs(hue - 4.0) };
+		uint32_t color = 0xFF000000;
+		for (int i = 0; i < 3; i++)
+			color |= (uint32_t)(fmin(fmax(rgb[i], 0.0), 1.0) * value * 255.0 + 0.5) << (8 * i);
+		return color;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef DOMAIN_COLORING_H
+#define DOMAIN_COLORING_H
+
+#include "AdaptiveSampler.h"
+#include "ThreadPool.h"
+
+namespace MatLib {
+	struct DomainStatistics {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t evaluations = 0;
+		double milliseconds = 0.0;
+	};
+
+	//Colors the view by f(z) with z = x + iy: the hue is the argument of f and the brightness repeats with every doubling
+	//of |f|, so zeros are points where every hue meets and poles or undefined values are white. Each row is one complex
+	//batch on the thread pool, every thread has its own interpreter for the scratch blocks
+	class DomainColoring {
+	public:
+		DomainColoring() = default;
+		DomainColoring(FunctionSolver* solver, ThreadPool* pool);
+
+		void SetFunction(size_t assignment);
+		void SetView(const SamplerView& view);
+		void Reset();
+		bool Sample();
+		bool Done() const { return !dirty; }
+
+		//RGBA8 from the top row of the view down, Width() by Height() pixels
+		const std::vector<uint32_t>& Pixels() const { return pixels; }
+		uint32_t Width() const { return stats.width; }
+		uint32_t Height() const { return stats.height; }
+		const DomainStatistics& Statistics() const { return stats; }
+
+		static uint32_t Color(double re, double im);
+
+		//Screen pixels per evaluated point along each axis
+		uint32_t scale = 1;
+	private:
+		struct Row {
+			std::vector<double> re, im;
+			std::vector<double> out_re, out_im;
+		};
+
+		FunctionSolver* solver = nullptr;
+		ThreadPool* pool = nullptr;
+		size_t assignment = 0;
+		SamplerView view;
+		bool dirty = true;
+
+		std::vector<Interpreter> workers;
+		std::vector<Row> rows;
+		std::vector<uint32_t> pixels;
+		DomainStatistics stats;
+	};
+}
+
+#endif // !DOMAIN_COLORING_H
\ No newline at end of file
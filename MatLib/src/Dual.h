@@ -0,0 +1,172 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include "Kernels.h"
+
+#include <cmath>
+#include <cstddef>
+
+namespace MatLib {
+	inline double Pow(double a, double b) { return pow(a, b); }
+	inline double Sin(double x) { return Kernels::Sin(x); }
+	inline double Cos(double x) { return Kernels::Cos(x); }
+	inline double Exp(double x) { return Kernels::Exp(x); }
+	inline double Log(double x) { return Kernels::Log(x); }
+	inline double Sqrt(double x) { return Kernels::Sqrt(x); }
+	inline double Power(double a, double b) { return Kernels::Power(a, b); }
+
+	struct Dual {
+		double value = 0.0;
+		double derivative = 0.0;
+
+		Dual() = default;
+		Dual(double value) : value(value) { }
+		Dual(double value, double derivative) : value(value), derivative(derivative) { }
+	};
+
+	inline Dual operator-(const Dual& a) { return Dual(-a.value, -a.derivative); }
+	inline Dual operator+(const Dual& a, const Dual& b) { return Dual(a.value + b.value, a.derivative + b.derivative); }
+	inline Dual operator-(const Dual& a, const Dual& b) { return Dual(a.value - b.value, a.derivative - b.derivative); }
+	inline Dual operator*(const Dual& a, const Dual& b) { return Dual(a.value * b.value, a.derivative * b.value + a.value * b.derivative); }
+	inline Dual operator/(const Dual& a, const Dual& b) {
+		double q = a.value / b.value;
+		return Dual(q, (a.derivative - q * b.derivative) / b.value);
+	}
+
+	//Slope of u^b for a constant b. u^0 is one everywhere, so its slope is zero even at u = 0 where b u^(b - 1) would be
+	//0 * inf
+	inline double PowSlope(double u, double b) { return (b == 0.0) ? 0.0 : b * pow(u, b - 1.0); }
+	inline double PowerSlope(double u, double b) { return (b == 0.0) ? 0.0 : b * Power(u, b - 1.0); }
+
+	//A constant exponent avoids ln(u), which keeps negative bases differentiable
+	inline Dual Pow(const Dual& a, const Dual& b) {
+		double p = pow(a.value, b.value);
+		if (b.derivative == 0.0)
+			return Dual(p, PowSlope(a.value, b.value) * a.derivative);
+		return Dual(p, p * (b.derivative * log(a.value) + b.value * a.derivative / a.value));
+	}
+
+	inline Dual Sin(const Dual& a) { return Dual(Sin(a.value), Cos(a.value) * a.derivative); }
+	inline Dual Cos(const Dual& a) { return Dual(Cos(a.value), -Sin(a.value) * a.derivative); }
+	inline Dual Log(const Dual& a) { return Dual(Log(a.value), a.derivative / a.value); }
+
+	inline Dual Exp(const Dual& a) {
+		double e = Exp(a.value);
+		return Dual(e, e * a.derivative);
+	}
+
+	inline Dual Sqrt(const Dual& a) {
+		double r = Sqrt(a.value);
+		return Dual(r, a.derivative / (2.0 * r));
+	}
+
+	inline Dual Power(const Dual& a, const Dual& b) {
+		double p = Power(a.value, b.value);
+		if (b.derivative == 0.0)
+			return Dual(p, PowerSlope(a.value, b.value) * a.derivative);
+		return Dual(p, p * (b.derivative * Log(a.value) + b.value * a.derivative / a.value));
+	}
+
+	constexpr size_t GRADIENT_WIDTH = 8;
+
+	//Carries up to GRADIENT_WIDTH partial derivatives, wider gradients are done in several passes
+	struct Gradient {
+		double value = 0.0;
+		double d[GRADIENT_WIDTH] = { 0 };
+
+		Gradient() = default;
+		Gradient(double value) : value(value) { }
+	};
+
+	inline Gradient operator-(const Gradient& a) {
+		Gradient r(-a.value);
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			r.d[i] = -a.d[i];
+		return r;
+	}
+
+	inline Gradient operator+(const Gradient& a, const Gradient& b) {
+		Gradient r(a.value + b.value);
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			r.d[i] = a.d[i] + b.d[i];
+		return r;
+	}
+
+	inline Gradient operator-(const Gradient& a, const Gradient& b) {
+		Gradient r(a.value - b.value);
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			r.d[i] = a.d[i] - b.d[i];
+		return r;
+	}
+
+	inline Gradient operator*(const Gradient& a, const Gradient& b) {
+		Gradient r(a.value * b.value);
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			r.d[i] = a.d[i] * b.value + a.value * b.d[i];
+		return r;
+	}
+
+	inline Gradient operator/(const Gradient& a, const Gradient& b) {
+		Gradient r(a.value / b.value);
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			r.d[i] = (a.d[i] - r.value * b.d[i]) / b.value;
+		return r;
+	}
+
+	inline Gradient Pow(const Gradient& a, const Gradient& b) {
+		Gradient r(pow(a.value, b.value));
+		bool constant_exponent = true;
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			constant_exponent = constant_exponent && b.d[i] == 0.0;
+
+		if (constant_exponent) {
+			double scale = PowSlope(a.value, b.value);
+			for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+				r.d[i] = scale * a.d[i];
+		}
+		else {
+			double ln = log(a.value);
+			for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+				r.d[i] = r.value * (b.d[i] * ln + b.value * a.d[i] / a.value);
+		}
+		return r;
+	}
+
+	//f(a) for a function of one argument, given f and f' at a's value
+	inline Gradient Chain(const Gradient& a, double value, double slope) {
+		Gradient r(value);
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			r.d[i] = slope * a.d[i];
+		return r;
+	}
+
+	inline Gradient Sin(const Gradient& a) { return Chain(a, Sin(a.value), Cos(a.value)); }
+	inline Gradient Cos(const Gradient& a) { return Chain(a, Cos(a.value), -Sin(a.value)); }
+	inline Gradient Log(const Gradient& a) { return Chain(a, Log(a.value), 1.0 / a.value); }
+
+	inline Gradient Exp(const Gradient& a) {
+		double e = Exp(a.value);
+		return Chain(a, e, e);
+	}
+
+	inline Gradient Sqrt(const Gradient& a) {
+		double r = Sqrt(a.value);
+		return Chain(a, r, 0.5 / r);
+	}
+
+	inline Gradient Power(const Gradient& a, const Gradient& b) {
+		Gradient r(Power(a.value, b.value));
+		bool constant_exponent = true;
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			constant_exponent = constant_exponent && b.d[i] == 0.0;
+
+		if (constant_exponent)
+			return Chain(a, r.value, PowerSlope(a.value, b.value));
+		double ln = Log(a.value);
+		for (size_t i = 0; i < GRADIENT_WIDTH; i++)
+			r.d[i] = r.value * (b.d[i] * ln + b.value * a.d[i] / a.value);
+		return r;
+	}
+}
+
+#endif // !DUAL_H
\ No newline at end of file
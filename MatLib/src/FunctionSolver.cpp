@@ -1,22 +1,295 @@
 #include "FunctionSolver.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
 
 namespace MatLib {
 	FunctionSolver::FunctionSolver(Parser* parser) : Interpreter(parser) { }
 
+	void FunctionSolver::Compile() {
+		compiler.SetInput(InputId());
+		program = compiler.Compile(parser->Root());
+	}
+
 	void FunctionSolver::Solve() {
-		if (parser->Root()) {
-			auto root = parser->Root();
-			for (auto& proc : root->procedures) {
-				switch (proc->type) {
-				case AST_ASSIGNMENT:
-					auto assign = static_cast<Ast_Assignment*>(proc);
-					printf("Assignment: %s\n", assign->id->id.c_str());
-					if (assign->expr) {
-						printf("Answer: %f\n", SolveExpression(assign->expr));
+		Compile();
+		Report();
+	}
+
+	void FunctionSolver::Report() {
+		for (size_t i = 0; i < program.assignments.size(); i++) {
+			printf("Assignment: %s\n", program.assignments[i].id.c_str());
+			printf("Answer: %f\n", Evaluate(i));
+		}
+	}
+
+	double FunctionSolver::Evaluate(size_t assignment) {
+		return Evaluate(assignment, input);
+	}
+
+	double FunctionSolver::Evaluate(size_t assignment, double x) {
+		return (assignment < program.assignments.size()) ? vm.Run(program.assignments[assignment].chunk, x) : 0.0;
+	}
+
+	Interval FunctionSolver::EvaluateInterval(size_t assignment, const Interval& x) {
+		return (assignment < program.assignments.size()) ? vm.RunInterval(program.assignments[assignment].chunk, x) : Interval::Entire();
+	}
+
+	//Runs every assignment in order at x, read in the current mode. Names nothing reads back, like y and the
+	//derivatives, have no slot and are solved on their own
+	std::vector<ScriptValue> FunctionSolver::EvaluateScript(std::string_view x) {
+		std::vector<ScriptValue> values;
+		Ast_Script* script = (parser) ? parser->Root() : nullptr;
+		if (!script)
+			return values;
+
+		std::string text(x);
+		double saved = input;
+		BigFloat::Precision precision((digits) ? digits : BIG_FLOAT_DEFAULT_DIGITS);
+		BigFloat big_x;
+		Rational rational_x;
+		Complex complex_x;
+		Matrix matrix_x;
+		switch (mode) {
+		case NUMERIC_RATIONAL:
+			rational_x = Rational::Parse(text);
+			ExecuteRational(script, rational_x);
+			break;
+		case NUMERIC_BIG_FLOAT:
+			big_x = BigFloat::Parse(text);
+			ExecuteBigFloat(script, big_x);
+			break;
+		case NUMERIC_COMPLEX:
+			complex_x = Complex::Parse(text);
+			ExecuteComplex(script, complex_x);
+			break;
+		case NUMERIC_MATRIX:
+			matrix_x = Matrix::Parse(text);
+			ExecuteMatrix(script, matrix_x);
+			break;
+		default:
+			input = strtod(text.c_str(), nullptr);
+			Execute(script);
+			break;
+		}
+
+		for (auto proc : script->procedures) {
+			if (proc->type != AST_ASSIGNMENT || !proc->id)
+				continue;
+			ScriptValue v;
+			v.id = proc->id->Name();
+			int32_t slot = proc->id->slot;
+			if (mode == NUMERIC_RATIONAL) {
+				Rational r = (slot >= 0) ? rational_environment[slot] : SolveRational(proc->expr, rational_x);
+				v.text = r.ToString();
+				v.value = r.ToDouble();
+			}
+			else if (mode == NUMERIC_BIG_FLOAT) {
+				BigFloat b = (slot >= 0) ? big_environment[slot] : SolveBigFloat(proc->expr, big_x);
+				v.text = b.ToString((digits) ? digits : BIG_FLOAT_DEFAULT_DIGITS);
+				v.value = b.ToDouble();
+			}
+			else if (mode == NUMERIC_COMPLEX) {
+				Complex c = (slot >= 0) ? complex_environment[slot] : SolveComplex(proc->expr, complex_x);
+				v.text = c.ToString();
+				v.value = c.re;
+			}
+			else if (mode == NUMERIC_MATRIX) {
+				Matrix m = (slot >= 0) ? matrix_environment[slot] : SolveMatrix(proc->expr, matrix_x);
+				v.text = m.ToString();
+				v.value = m.Data()[0];
+			}
+			else {
+				v.value = (slot >= 0) ? environment[slot] : SolveExpression(proc->expr);
+				char number[32];
+				snprintf(number, sizeof(number), "%.17g", v.value);
+				v.text = number;
+			}
+			values.push_back(v);
+		}
+		input = saved;
+		return values;
+	}
+
+	Ast_Expression* FunctionSolver::AssignmentExpression(size_t assignment) const {
+		Ast_Script* script = (parser) ? parser->Root() : nullptr;
+		if (!script)
+			return nullptr;
+		for (auto proc : script->procedures)
+			if (proc->type == AST_ASSIGNMENT && assignment-- == 0)
+				return proc->expr;
+		return nullptr;
+	}
+
+	//Samples [a, b] in parallel tiles to bracket sign changes, then refines every bracket in parallel
+	//Tiles whose interval enclosure excludes zero are proven root free and never sampled
+	std::vector<Root> FunctionSolver::FindRoots(size_t assignment, double a, double b, const RootOptions& options) {
+		std::vector<Root> roots;
+		if (assignment >= program.assignments.size() || options.samples == 0 || !(a < b))
+			return roots;
+
+		const Chunk& chunk = program.assignments[assignment].chunk;
+		const uint32_t samples = options.samples;
+		const double step = (b - a) / samples;
+		auto sample_x = [&](size_t i) { return (i == samples) ? b : a + step * i; };
+
+		struct Bracket {
+			double a, b, fa, fb;
+		};
+
+		const size_t tile = (options.tile) ? options.tile : 1;
+		const size_t tiles = (samples + tile - 1) / tile;
+		auto tile_start = [&](size_t t) { return (t * tile < samples) ? t * tile : samples; };
+
+		std::vector<size_t> live;
+		if (options.cull) {
+			std::vector<std::pair<size_t, size_t>> pending = { { 0, tiles } };
+			while (!pending.empty()) {
+				auto range = pending.back();
+				pending.pop_back();
+				if (!vm.RunInterval(chunk, Interval(sample_x(range.first * tile), sample_x(tile_start(range.second)))).Contains(0.0))
+					continue;
+				if (range.second - range.first == 1)
+					live.push_back(range.first);
+				else {
+					size_t mid = range.first + (range.second - range.first) / 2;
+					pending.push_back({ mid, range.second });
+					pending.push_back({ range.first, mid });
+				}
+			}
+		}
+		else {
+			live.resize(tiles);
+			for (size_t t = 0; t < tiles; t++)
+				live[t] = t;
+		}
+
+		size_t threads = (options.threads) ? options.threads : HardwareThreads();
+		std::vector<std::vector<Bracket>> brackets(threads);
+		std::vector<std::vector<Root>> exact(threads);
+
+		ParallelFor(live.size(), threads, [&](size_t first, size_t last, size_t thread) {
+			VirtualMachine local;
+			for (size_t t = first; t < last; t++) {
+				size_t begin = live[t] * tile, end = tile_start(live[t] + 1);
+				double x0 = sample_x(begin);
+				double f0 = local.Run(chunk, x0);
+				for (size_t i = begin; i < end; i++) {
+					double x1 = sample_x(i + 1);
+					double f1 = local.Run(chunk, x1);
+					if (f0 == 0.0) {
+						Root root;
+						root.x = x0;
+						exact[thread].push_back(root);
+					}
+					else if ((f0 < 0.0 && f1 > 0.0) || (f0 > 0.0 && f1 < 0.0))
+						brackets[thread].push_back({ x0, x1, f0, f1 });
+
+					if (i + 1 == samples && f1 == 0.0) {
+						Root root;
+						root.x = x1;
+						exact[thread].push_back(root);
 					}
-					break;
+					x0 = x1;
+					f0 = f1;
 				}
 			}
+		});
+
+		std::vector<Bracket> all;
+		for (size_t t = 0; t < threads; t++) {
+			all.insert(all.end(), brackets[t].begin(), brackets[t].end());
+			roots.insert(roots.end(), exact[t].begin(), exact[t].end());
 		}
+
+		std::vector<Root> refined(all.size());
+		std::vector<char> converged(all.size(), 0);
+		ParallelFor(all.size(), threads, [&](size_t begin, size_t end, size_t /*thread*/) {
+			VirtualMachine local;
+			for (size_t i = begin; i < end; i++)
+				converged[i] = Brent(chunk, local, all[i].a, all[i].b, all[i].fa, all[i].fb, options, refined[i]);
+		});
+
+		for (size_t i = 0; i < all.size(); i++)
+			if (converged[i])
+				roots.push_back(refined[i]);
+
+		std::sort(roots.begin(), roots.end(), [](const Root& l, const Root& r) { return l.x < r.x; });
+		return roots;
+	}
+
+	//Brent's method on a sign-changing bracket, error is half the final bracket width
+	bool FunctionSolver::Brent(const Chunk& chunk, VirtualMachine& machine, double a, double b, double fa, double fb, const RootOptions& options, Root& root) {
+		double c = a, fc = fa, d = b - a, e = d;
+		double bound = fmax(fabs(fa), fabs(fb));
+		uint32_t iteration = 0;
+
+		for (; iteration < options.max_iterations; iteration++) {
+			if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0)) {
+				c = a;
+				fc = fa;
+				d = e = b - a;
+			}
+			if (fabs(fc) < fabs(fb)) {
+				a = b; b = c; c = a;
+				fa = fb; fb = fc; fc = fa;
+			}
+
+			double tol = 2.0 * DBL_EPSILON * fabs(b) + 0.5 * options.tolerance;
+			double m = 0.5 * (c - b);
+			if (fabs(m) <= tol || fb == 0.0)
+				break;
+
+			if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+				double s = fb / fa, p, q;
+				if (a == c) {
+					p = 2.0 * m * s;
+					q = 1.0 - s;
+				}
+				else {
+					double r = fb / fc;
+					q = fa / fc;
+					p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+					q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+				}
+				if (p > 0.0)
+					q = -q;
+				else
+					p = -p;
+
+				if (2.0 * p < fmin(3.0 * m * q - fabs(tol * q), fabs(e * q))) {
+					e = d;
+					d = p / q;
+				}
+				else {
+					d = m;
+					e = m;
+				}
+			}
+			else {
+				d = m;
+				e = m;
+			}
+
+			a = b;
+			fa = fb;
+			b += (fabs(d) > tol) ? d : ((m > 0.0) ? tol : -tol);
+			fb = machine.Run(chunk, b);
+		}
+
+		//Running out of iterations leaves b one step past the last bracket update, so c is brought up to date first
+		if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0))
+			c = a;
+
+		root.x = b;
+		root.error = (fb == 0.0) ? 0.0 : 0.5 * fabs(c - b);
+		root.residual = fb;
+		root.iterations = iteration;
+
+		//A sign change across a pole converges onto the pole with a growing residual, those are rejected
+		return std::isfinite(fb) && fabs(fb) <= bound;
 	}
 }
\ No newline at end of file
@@ -2,17 +2,78 @@
 #define FUNCTION_SOLVER_H
 
 #include "Interpreter.h"
+#include "VirtualMachine.h"
 
 namespace MatLib {
+	enum {
+		NUMERIC_DOUBLE,
+		NUMERIC_RATIONAL,
+		NUMERIC_BIG_FLOAT,
+		NUMERIC_COMPLEX,
+		NUMERIC_MATRIX
+	};
+
+	struct Root {
+		double x = 0.0;
+		double error = 0.0;
+		double residual = 0.0;
+		uint32_t iterations = 0;
+	};
+
+	struct RootOptions {
+		uint32_t samples = 8192;
+		uint32_t max_iterations = 100;
+		double tolerance = 1e-12;
+		size_t threads = 0;
+		bool cull = true;
+		uint32_t tile = 64;
+	};
+
+	//One assignment of the script evaluated in the current numeric mode, text is exact in rational mode and value is
+	//the real part in complex mode and the first element in matrix mode
+	struct ScriptValue {
+		std::string id;
+		std::string text;
+		double value = 0.0;
+	};
+
 	class FunctionSolver : public Interpreter {
 	public:
 		FunctionSolver() = default;
 		FunctionSolver(Parser* parser);
 
+		void Compile();
 		void Solve();
-	private:
+		void Report();
+		double Evaluate(size_t assignment);
+		double Evaluate(size_t assignment, double x);
+		Interval EvaluateInterval(size_t assignment, const Interval& x);
+
+		std::vector<Root> FindRoots(size_t assignment, double a, double b, const RootOptions& options = RootOptions());
+		Program& GetProgram() { return program; }
+		void SetProgram(const Program& program) { this->program = program; }
+		const CompilerStatistics& CompileStatistics() const { return compiler.Statistics(); }
+
+		//Takes effect on the next Compile, only procedures the parser found pure are memoized
+		void SetMemoized(std::string_view name, bool enabled) { compiler.SetMemoized(name, enabled); }
+		bool IsMemoized(std::string_view name) const { return compiler.IsMemoized(name); }
+		const std::vector<MemoTable>& Memos() const { return vm.Memos(); }
 
+		//Picks how EvaluateScript computes, the compiled program and the plots always run in doubles
+		void SetMode(int mode) { this->mode = mode; }
+		int Mode() const { return mode; }
+		std::vector<ScriptValue> EvaluateScript(std::string_view x);
+
+		//The tree of the nth assignment, in the same order as the compiled program's assignments
+		Ast_Expression* AssignmentExpression(size_t assignment) const;
+	private:
+		Compiler compiler;
+		VirtualMachine vm;
+		Program program;
+		int mode = NUMERIC_DOUBLE;
+	private:
+		static bool Brent(const Chunk& chunk, VirtualMachine& machine, double a, double b, double fa, double fb, const RootOptions& options, Root& root);
 	};
 }
 
-#endif // !FUNCTION_SOLVER_H
+#endif // !FUNCTION_SOLVER_H
\ No newline at end of file
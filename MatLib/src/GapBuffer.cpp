@@ -0,0 +1,78 @@
+#include "GapBuffer.h"
+
+#include <cstring>
+
+namespace MatLib {
+	GapBuffer::GapBuffer(size_t capacity) : data(capacity), gap_begin(0), gap_end(capacity) { }
+
+	void GapBuffer::Replace(size_t position, size_t count, std::string_view text) {
+		size_t size = Size();
+		if (position > size)
+			position = size;
+		if (count > size - position)
+			count = size - position;
+
+		MoveGap(position);
+		gap_end += count;
+		Reserve(text.size());
+		memcpy(data.data() + gap_begin, text.data(), text.size());
+		gap_begin += text.size();
+	}
+
+	void GapBuffer::Clear() {
+		gap_begin = 0;
+		gap_end = data.size();
+	}
+
+	void GapBuffer::Copy(size_t position, size_t count, std::string& out) const {
+		out.clear();
+		size_t size = Size();
+		if (position >= size)
+			return;
+		if (count > size - position)
+			count = size - position;
+
+		out.resize(count);
+		size_t before = (position < gap_begin) ? ((gap_begin - position < count) ? gap_begin - position : count) : 0;
+		memcpy(&out[0], data.data() + position, before);
+		memcpy(&out[0] + before, data.data() + position + before + (gap_end - gap_begin), count - before);
+	}
+
+	std::string GapBuffer::Text() const {
+		std::string text;
+		Copy(0, Size(), text);
+		return text;
+	}
+
+	void GapBuffer::MoveGap(size_t position) {
+		if (position < gap_begin) {
+			size_t move = gap_begin - position;
+			memmove(data.data() + gap_end - move, data.data() + position, move);
+			gap_begin -= move;
+			gap_end -= move;
+		}
+		else if (position > gap_begin) {
+			size_t move = position - gap_begin;
+			memmove(data.data() + gap_begin, data.data() + gap_end, move);
+			gap_begin += move;
+			gap_end += move;
+		}
+	}
+
+	//Doubles the storage so a long run of typing reallocates a logarithmic number of times
+	void GapBuffer::Reserve(size_t needed) {
+		if (gap_end - gap_begin >= needed)
+			return;
+
+		size_t tail = data.size() - gap_end;
+		size_t capacity = (data.size()) ? data.size() : 64;
+		while (capacity - Size() < needed)
+			capacity *= 2;
+
+		std::vector<char> grown(capacity);
+		memcpy(grown.data(), data.data(), gap_begin);
+		memcpy(grown.data() + capacity - tail, data.data() + gap_end, tail);
+		data.swap(grown);
+		gap_end = capacity - tail;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#ifndef GAP_BUFFER_H
+#define GAP_BUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MatLib {
+	//Text with a movable hole at the cursor, edits next to the previous one only move the few characters in between
+	class GapBuffer {
+	public:
+		GapBuffer(size_t capacity = 1024);
+
+		void Replace(size_t position, size_t count, std::string_view text);
+		void Insert(size_t position, std::string_view text) { Replace(position, 0, text); }
+		void Erase(size_t position, size_t count) { Replace(position, count, std::string_view()); }
+		void Clear();
+
+		size_t Size() const { return data.size() - (gap_end - gap_begin); }
+		char At(size_t position) const { return (position < gap_begin) ? data[position] : data[position + gap_end - gap_begin]; }
+		void Copy(size_t position, size_t count, std::string& out) const;
+		std::string Text() const;
+	private:
+		std::vector<char> data;
+		size_t gap_begin = 0;
+		size_t gap_end = 0;
+	private:
+		void MoveGap(size_t position);
+		void Reserve(size_t needed);
+	};
+}
+
+#endif // !GAP_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,235 @@
+#include "Gemm.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define MATLIB_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define MATLIB_SSE2
+#endif
+
+namespace MatLib {
+	namespace Gemm {
+		//Below this many multiply-adds packing costs more than it saves
+		static const double GEMM_SMALL = 32.0 * 32.0 * 32.0;
+
+#if defined(MATLIB_AVX2)
+		//Twelve accumulators of four lanes, with two loads of B and one broadcast of A per row that is 14 of 16 registers.
+		//MSVC only builds AVX2 code for processors that also have FMA
+	#if defined(__FMA__) || defined(_MSC_VER)
+		#define GEMM_FMA(a, b, c) _mm256_fmadd_pd(a, b, c)
+	#else
+		#define GEMM_FMA(a, b, c) _mm256_add_pd(_mm256_mul_pd(a, b), c)
+	#endif
+		static const size_t MR = 6;
+		static const size_t NR = 8;
+
+		#define GEMM_ROW(r) \
+			ar = _mm256_broadcast_sd(a + r); \
+			c##r##0 = GEMM_FMA(ar, b0, c##r##0); \
+			c##r##1 = GEMM_FMA(ar, b1, c##r##1);
+
+		#define GEMM_STORE(r) \
+			_mm256_storeu_pd(c + r * ldc, _mm256_add_pd(_mm256_loadu_pd(c + r * ldc), c##r##0)); \
+			_mm256_storeu_pd(c + r * ldc + 4, _mm256_add_pd(_mm256_loadu_pd(c + r * ldc + 4), c##r##1));
+
+		//C[MR by NR] += the packed A panel times the packed B panel
+		static void Kernel(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+			__m256d c00 = _mm256_setzero_pd(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00;
+			__m256d c30 = c00, c31 = c00, c40 = c00, c41 = c00, c50 = c00, c51 = c00;
+			for (size_t p = 0; p < kc; p++) {
+				__m256d b0 = _mm256_loadu_pd(b), b1 = _mm256_loadu_pd(b + 4), ar;
+				GEMM_ROW(0) GEMM_ROW(1) GEMM_ROW(2) GEMM_ROW(3) GEMM_ROW(4) GEMM_ROW(5)
+				a += MR;
+				b += NR;
+			}
+			GEMM_STORE(0) GEMM_STORE(1) GEMM_STORE(2) GEMM_STORE(3) GEMM_STORE(4) GEMM_STORE(5)
+		}
+
+		const char* MicroKernel() {
+	#if defined(__FMA__) || defined(_MSC_VER)
+			return "6x8 AVX2 FMA";
+	#else
+			return "6x8 AVX2";
+	#endif
+		}
+#elif defined(MATLIB_SSE2)
+		//Eight accumulators of two lanes, leaving registers for two loads of B and the broadcast of A
+		static const size_t MR = 4;
+		static const size_t NR = 4;
+
+		#define GEMM_ROW(r) \
+			ar = _mm_set1_pd(a[r]); \
+			c##r##0 = _mm_add_pd(_mm_mul_pd(ar, b0), c##r##0); \
+			c##r##1 = _mm_add_pd(_mm_mul_pd(ar, b1), c##r##1);
+
+		#define GEMM_STORE(r) \
+			_mm_storeu_pd(c + r * ldc, _mm_add_pd(_mm_loadu_pd(c + r * ldc), c##r##0)); \
+			_mm_storeu_pd(c + r * ldc + 2, _mm_add_pd(_mm_loadu_pd(c + r * ldc + 2), c##r##1));
+
+		static void Kernel(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+			__m128d c00 = _mm_setzero_pd(), c01 = c00, c10 = c00, c11 = c00, c20 = c00, c21 = c00, c30 = c00, c31 = c00;
+			for (size_t p = 0; p < kc; p++) {
+				__m128d b0 = _mm_loadu_pd(b), b1 = _mm_loadu_pd(b + 2), ar;
+				GEMM_ROW(0) GEMM_ROW(1) GEMM_ROW(2) GEMM_ROW(3)
+				a += MR;
+				b += NR;
+			}
+			GEMM_STORE(0) GEMM_STORE(1) GEMM_STORE(2) GEMM_STORE(3)
+		}
+
+		const char* MicroKernel() {
+			return "4x4 SSE2";
+		}
+#else
+		static const size_t MR = 4;
+		static const size_t NR = 4;
+
+		static void Kernel(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+			double tile[MR * NR] = { 0.0 };
+			for (size_t p = 0; p < kc; p++) {
+				for (size_t r = 0; r < MR; r++)
+					for (size_t j = 0; j < NR; j++)
+						tile[r * NR + j] += a[r] * b[j];
+				a += MR;
+				b += NR;
+			}
+			for (size_t r = 0; r < MR; r++)
+				for (size_t j = 0; j < NR; j++)
+					c[r * ldc + j] += tile[r * NR + j];
+		}
+
+		const char* MicroKernel() {
+			return "4x4 scalar";
+		}
+#endif
+
+		size_t KernelRows() {
+			return MR;
+		}
+
+		size_t KernelCols() {
+			return NR;
+		}
+
+		void RunKernel(size_t kc, const double* a, const double* b, double* c, size_t ldc) {
+			Kernel(kc, a, b, c, ldc);
+		}
+
+		static size_t RoundUp(size_t value, size_t step) {
+			return (value + step - 1) / step * step;
+		}
+
+		//MR-row panels of the mc by kc block, each stored column after column so the kernel reads A in order. Rows past
+		//the edge are zero, so a partial panel runs through the same kernel
+		static void PackA(const double* a, size_t lda, size_t mc, size_t kc, double* packed) {
+			for (size_t i = 0; i < mc; i += MR) {
+				size_t rows = std::min(MR, mc - i);
+				for (size_t p = 0; p < kc; p++) {
+					for (size_t r = 0; r < rows; r++)
+						packed[r] = a[(i + r) * lda + p];
+					for (size_t r = rows; r < MR; r++)
+						packed[r] = 0.0;
+					packed += MR;
+				}
+			}
+		}
+
+		//NR-column panels of the kc by nc block, each stored row after row
+		static void PackB(const double* b, size_t ldb, size_t kc, size_t nc, double* packed) {
+			for (size_t j = 0; j < nc; j += NR) {
+				size_t cols = std::min(NR, nc - j);
+				for (size_t p = 0; p < kc; p++) {
+					const double* row = b + p * ldb + j;
+					for (size_t c = 0; c < cols; c++)
+						packed[c] = row[c];
+					for (size_t c = cols; c < NR; c++)
+						packed[c] = 0.0;
+					packed += NR;
+				}
+			}
+		}
+
+		void Multiply(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc, size_t m, size_t n, size_t k, ThreadPool* pool) {
+			for (size_t i = 0; i < m; i++)
+				memset(c + i * ldc, 0, n * sizeof(double));
+			if (m == 0 || n == 0 || k == 0)
+				return;
+			if ((double)m * n * k <= GEMM_SMALL) {
+				MultiplyNaive(a, lda, b, ldb, c, ldc, m, n, k);
+				return;
+			}
+
+			if (!pool)
+				pool = &ThreadPool::Shared();
+			size_t threads = pool->Threads();
+			std::vector<double> packed_b(RoundUp(std::min(n, GEMM_NC), NR) * std::min(k, GEMM_KC));
+			std::vector<std::vector<double>> packed_a(threads);
+			size_t blocks = (m + GEMM_MC - 1) / GEMM_MC;
+
+			for (size_t jc = 0; jc < n; jc += GEMM_NC) {
+				size_t nc = std::min(GEMM_NC, n - jc);
+				//Too few row blocks to go around also split the columns, each of those jobs packs its own copy of A
+				size_t groups = (blocks >= threads) ? 1 : std::min((threads + blocks - 1) / blocks, (nc + NR - 1) / NR);
+				size_t span = RoundUp((nc + groups - 1) / groups, NR);
+				groups = (nc + span - 1) / span;
+
+				for (size_t pc = 0; pc < k; pc += GEMM_KC) {
+					size_t kc = std::min(GEMM_KC, k - pc);
+					PackB(b + pc * ldb + jc, ldb, kc, nc, packed_b.data());
+
+					auto job = [&](size_t index, size_t thread) {
+						size_t ic = (index / groups) * GEMM_MC, mc = std::min(GEMM_MC, m - ic);
+						size_t first = (index % groups) * span, last = std::min(first + span, nc);
+						std::vector<double>& pa = packed_a[thread];
+						if (pa.size() < RoundUp(mc, MR) * kc)
+							pa.resize(RoundUp(GEMM_MC, MR) * GEMM_KC);
+						PackA(a + ic * lda + pc, lda, mc, kc, pa.data());
+
+						for (size_t jr = first; jr < last; jr += NR) {
+							for (size_t ir = 0; ir < mc; ir += MR) {
+								const double* ap = pa.data() + ir * kc;
+								const double* bp = packed_b.data() + jr * kc;
+								double* cp = c + (ic + ir) * ldc + jc + jr;
+								if (ir + MR <= mc && jr + NR <= nc) {
+									Kernel(kc, ap, bp, cp, ldc);
+									continue;
+								}
+								double tile[MR * NR] = { 0.0 };
+								Kernel(kc, ap, bp, tile, NR);
+								for (size_t r = 0; r < std::min(MR, mc - ir); r++)
+									for (size_t j = 0; j < std::min(NR, nc - jr); j++)
+										cp[r * ldc + j] += tile[r * NR + j];
+							}
+						}
+					};
+
+					if (blocks * groups == 1 || threads == 1) {
+						for (size_t i = 0; i < blocks * groups; i++)
+							job(i, 0);
+					}
+					else
+						pool->Run(blocks * groups, job);
+				}
+			}
+		}
+
+		void MultiplyNaive(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc, size_t m, size_t n, size_t k) {
+			for (size_t i = 0; i < m; i++) {
+				double* row = c + i * ldc;
+				for (size_t j = 0; j < n; j++)
+					row[j] = 0.0;
+				for (size_t p = 0; p < k; p++) {
+					double s = a[i * lda + p];
+					const double* brow = b + p * ldb;
+					for (size_t j = 0; j < n; j++)
+						row[j] += s * brow[j];
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
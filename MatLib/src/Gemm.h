@@ -0,0 +1,35 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include "ThreadPool.h"
+
+#include <cstddef>
+
+namespace MatLib {
+	//Block sizes of the packed multiply: a KC by NR panel of B stays in L1 across the micro-kernel calls of a block, an MC
+	//by KC block of A stays in L2 and a KC by NC panel of B is shared by every thread from L3
+	constexpr size_t GEMM_MC = 96;
+	constexpr size_t GEMM_KC = 256;
+	constexpr size_t GEMM_NC = 2048;
+
+	namespace Gemm {
+		//C = A B for row-major A (m by k), B (k by n) and C (m by n), with the leading dimension of each. Both operands
+		//are packed into micro-panels so the micro-kernel streams contiguous memory, and the row blocks of A are shared
+		//out over the pool (ThreadPool::Shared when null). Small products skip the packing
+		void Multiply(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc, size_t m, size_t n, size_t k, ThreadPool* pool = nullptr);
+
+		//The unblocked i-k-j loop, the baseline the packed multiply is measured and checked against
+		void MultiplyNaive(const double* a, size_t lda, const double* b, size_t ldb, double* c, size_t ldc, size_t m, size_t n, size_t k);
+
+		//Rows by columns of the register tile, with the instruction set it runs on
+		const char* MicroKernel();
+		size_t KernelRows();
+		size_t KernelCols();
+
+		//The micro-kernel on its own: C (KernelRows by KernelCols) += a packed A panel, kc columns of KernelRows, times a
+		//packed B panel, kc rows of KernelCols. Timed on panels that stay in L1 it is the most one thread can reach
+		void RunKernel(size_t kc, const double* a, const double* b, double* c, size_t ldc);
+	}
+}
+
+#endif // !GEMM_H
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "HashCons.h"
+
+#include <cstring>
+
+namespace MatLib {
+	static uint64_t Mix(uint64_t h, uint64_t v) {
+		h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	static uint64_t StringHash(std::string_view s) {
+		uint64_t h = 0xcbf29ce484222325ull;
+		for (char c : s) {
+			h ^= (uint8_t)c;
+			h *= 0x100000001b3ull;
+		}
+		return h;
+	}
+
+	static uint64_t LeafHash(Ast_PrimaryExpression* p) {
+		if (p->call)
+			return Mix(Mix(AST_PROCEDURE_CALL, StringHash(p->call->id->Name())), (uint64_t)(int64_t)p->call->procedure);
+		if (p->ident)
+			return Mix(Mix(Mix(AST_ID, StringHash(p->ident->Name())), (uint64_t)(int64_t)p->ident->slot), p->ident->local);
+		uint64_t bits = 0;
+		memcpy(&bits, &p->num_const, sizeof(double));
+		return Mix(Mix(AST_PRIMARY, bits), StringHash(p->literal));
+	}
+
+	static Ast_Expression* Unwrap(Ast_Expression* expr) {
+		while (expr && expr->type == AST_PRIMARY && AST_CAST(Ast_PrimaryExpression, expr)->nested)
+			expr = AST_CAST(Ast_PrimaryExpression, expr)->nested;
+		return expr;
+	}
+
+	HashCons::HashCons(Parser* parser) {
+		this->parser = parser;
+	}
+
+	bool HashCons::IsCommutative(int op) {
+		return (op == AST_OPERATOR_ADD || op == AST_OPERATOR_MULTIPLICATIVE);
+	}
+
+	void HashCons::Clear() {
+		table.clear();
+		hashes.clear();
+		stats = HashConsStatistics();
+	}
+
+	//Shares structurally equal subtrees across the whole script, turning the tree into a DAG
+	void HashCons::Run() {
+		Clear();
+		if (!parser || !parser->Root())
+			return;
+
+		for (auto& proc : parser->Root()->procedures)
+			proc->expr = Intern(proc->expr);
+	}
+
+	Ast_Expression* HashCons::Intern(Ast_Expression* expr) {
+		expr = Unwrap(expr);
+		if (!expr)
+			return nullptr;
+
+		auto it = hashes.find(expr);
+		if (it != hashes.end())
+			return expr;
+
+		stats.visited++;
+		switch (expr->type) {
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			if (p->call)
+				for (auto& arg : p->call->args)
+					arg = Intern(arg);
+			break;
+		}
+		case AST_UNARY: {
+			auto u = AST_CAST(Ast_UnaryExpression, expr);
+			u->next = Intern(u->next);
+			break;
+		}
+		case AST_BINARY: {
+			auto b = AST_CAST(Ast_BinaryExpression, expr);
+			b->left = Intern(b->left);
+			b->right = Intern(b->right);
+			break;
+		}
+		case AST_MATRIX:
+			for (auto& element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				element = Intern(element);
+			break;
+		}
+
+		uint64_t h = NodeHash(expr);
+		auto& bucket = table[h];
+		for (auto candidate : bucket) {
+			if (ShallowEqual(candidate, expr)) {
+				stats.shared++;
+				return candidate;
+			}
+		}
+
+		bucket.push_back(expr);
+		hashes[expr] = h;
+		stats.unique++;
+		return expr;
+	}
+
+	//Children are already canonical, so only this node's own fields need hashing
+	uint64_t HashCons::NodeHash(Ast_Expression* expr) {
+		switch (expr->type) {
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			uint64_t h = LeafHash(p);
+			if (p->call)
+				for (auto arg : p->call->args)
+					h = Mix(h, (arg) ? hashes[arg] : 0);
+			return h;
+		}
+		case AST_UNARY: {
+			auto u = AST_CAST(Ast_UnaryExpression, expr);
+			return Mix(Mix(AST_UNARY, u->op), (u->next) ? hashes[u->next] : 0);
+		}
+		case AST_BINARY: {
+			auto b = AST_CAST(Ast_BinaryExpression, expr);
+			uint64_t l = (b->left) ? hashes[b->left] : 0;
+			uint64_t r = (b->right) ? hashes[b->right] : 0;
+			if (Commutes(b->op) && r < l)
+				std::swap(l, r);
+			return Mix(Mix(Mix(AST_BINARY, b->op), l), r);
+		}
+		case AST_MATRIX: {
+			auto m = AST_CAST(Ast_MatrixExpression, expr);
+			uint64_t h = Mix(Mix(AST_MATRIX, m->rows), m->cols);
+			for (auto element : m->elements)
+				h = Mix(h, (element) ? hashes[element] : 0);
+			return h;
+		}
+		}
+		return Mix(expr->type, 0);
+	}
+
+	bool HashCons::ShallowEqual(Ast_Expression* a, Ast_Expression* b) {
+		if (a->type != b->type)
+			return false;
+
+		switch (a->type) {
+		case AST_PRIMARY: {
+			auto pa = AST_CAST(Ast_PrimaryExpression, a);
+			auto pb = AST_CAST(Ast_PrimaryExpression, b);
+			//The language has no side effects, so a call is equal to any call of the same callee on the same arguments
+			if (pa->call || pb->call)
+				return (pa->call && pb->call && pa->call->id->symbol == pb->call->id->symbol && pa->call->builtin == pb->call->builtin &&
+					pa->call->procedure == pb->call->procedure && pa->call->args == pb->call->args);
+			if (pa->ident || pb->ident)
+				return (pa->ident && pb->ident && pa->ident->symbol == pb->ident->symbol && pa->ident->slot == pb->ident->slot && pa->ident->local == pb->ident->local);
+			//Literals that round to the same double still differ in the exact modes
+			return (memcmp(&pa->num_const, &pb->num_const, sizeof(double)) == 0 && pa->literal == pb->literal);
+		}
+		case AST_UNARY: {
+			auto ua = AST_CAST(Ast_UnaryExpression, a);
+			auto ub = AST_CAST(Ast_UnaryExpression, b);
+			return (ua->op == ub->op && ua->next == ub->next);
+		}
+		case AST_BINARY: {
+			auto ba = AST_CAST(Ast_BinaryExpression, a);
+			auto bb = AST_CAST(Ast_BinaryExpression, b);
+			if (ba->op != bb->op)
+				return false;
+			if (ba->left == bb->left && ba->right == bb->right)
+				return true;
+			return (Commutes(ba->op) && ba->left == bb->right && ba->right == bb->left);
+		}
+		case AST_MATRIX: {
+			auto ma = AST_CAST(Ast_MatrixExpression, a);
+			auto mb = AST_CAST(Ast_MatrixExpression, b);
+			return (ma->rows == mb->rows && ma->cols == mb->cols && ma->elements == mb->elements);
+		}
+		}
+		return false;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef HASH_CONS_H
+#define HASH_CONS_H
+
+#include "Parser.h"
+
+namespace MatLib {
+	struct HashConsStatistics {
+		uint32_t visited = 0;
+		uint32_t unique = 0;
+		uint32_t shared = 0;
+	};
+
+	class HashCons {
+	public:
+		HashCons() = default;
+		HashCons(Parser* parser);
+
+		void Run();
+		void Clear();
+		Ast_Expression* Intern(Ast_Expression* expr);
+
+		static bool IsCommutative(int op);
+		//Matrix products do not commute, so with ordered products a*b and b*a stay distinct nodes
+		void SetOrderedProducts(bool ordered) { ordered_products = ordered; }
+
+		const HashConsStatistics& Statistics() const { return stats; }
+	private:
+		Parser* parser = nullptr;
+		std::unordered_map<uint64_t, std::vector<Ast_Expression*>> table;
+		std::unordered_map<Ast_Expression*, uint64_t> hashes;
+		HashConsStatistics stats;
+		bool ordered_products = false;
+	private:
+		bool Commutes(int op) const { return IsCommutative(op) && !(ordered_products && op == AST_OPERATOR_MULTIPLICATIVE); }
+		uint64_t NodeHash(Ast_Expression* expr);
+		bool ShallowEqual(Ast_Expression* a, Ast_Expression* b);
+	};
+}
+
+#endif // !HASH_CONS_H
\ No newline at end of file
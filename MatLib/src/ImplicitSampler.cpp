@@ -0,0 +1,151 @@
+#include "ImplicitSampler.h"
+
+#include <chrono>
+#include <cmath>
+
+namespace MatLib {
+	ImplicitSampler::ImplicitSampler(FunctionSolver* solver, ThreadPool* pool) {
+		this->solver = solver;
+		this->pool = pool;
+	}
+
+	void ImplicitSampler::SetRelation(size_t relation) {
+		this->relation = relation;
+		Reset();
+	}
+
+	void ImplicitSampler::SetView(const SamplerView& view) {
+		if (view.x0 != this->view.x0 || view.x1 != this->view.x1 || view.y0 != this->view.y0 || view.y1 != this->view.y1 ||
+			view.width != this->view.width || view.height != this->view.height) {
+			this->view = view;
+			Reset();
+		}
+	}
+
+	void ImplicitSampler::Reset() {
+		segments.clear();
+		stats = ImplicitStatistics();
+		dirty = true;
+	}
+
+	//Retraces the whole view in one go, returns false when nothing changed since the last call
+	bool ImplicitSampler::Sample() {
+		if (!dirty)
+			return false;
+		dirty = false;
+		segments.clear();
+		stats = ImplicitStatistics();
+		if (!solver || !pool || relation >= solver->GetProgram().relations.size() || tiles == 0 || !(view.x0 < view.x1) || !(view.y0 < view.y1))
+			return true;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		const Chunk& chunk = solver->GetProgram().relations[relation].chunk;
+		if (machines.size() < pool->Threads())
+			machines.resize(pool->Threads());
+		tile_output.resize((size_t)tiles * tiles);
+
+		double tw = (view.x1 - view.x0) / tiles, th = (view.y1 - view.y0) / tiles;
+		pool->Run(tile_output.size(), [&](size_t index, size_t thread) {
+			Tile& tile = tile_output[index];
+			tile.segments.clear();
+			tile.stats = ImplicitStatistics();
+
+			size_t tx = index % tiles, ty = index / tiles;
+			double x0 = view.x0 + tw * tx, y0 = view.y0 + th * ty;
+			double x1 = (tx + 1 == tiles) ? view.x1 : x0 + tw, y1 = (ty + 1 == tiles) ? view.y1 : y0 + th;
+			Refine(chunk, machines[thread], x0, x1, y0, y1, tile);
+		});
+
+		for (auto& tile : tile_output) {
+			segments.insert(segments.end(), tile.segments.begin(), tile.segments.end());
+			stats.cells += tile.stats.cells;
+			stats.culled += tile.stats.culled;
+			stats.leaves += tile.stats.leaves;
+			stats.evaluations += tile.stats.evaluations;
+		}
+		stats.segments = (uint32_t)segments.size();
+		stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return true;
+	}
+
+	//Only axes wider than the leaf size are split, so wide tiles on a non square view still end in square-ish leaves
+	void ImplicitSampler::Refine(const Chunk& chunk, VirtualMachine& vm, double x0, double x1, double y0, double y1, Tile& tile) {
+		tile.stats.cells++;
+		tile.stats.evaluations++;
+		Interval f = vm.RunInterval(chunk, Interval(x0, x1), Interval(y0, y1));
+		if (!f.Contains(0.0)) {
+			tile.stats.culled++;
+			return;
+		}
+
+		bool split_x = (x1 - x0) * view.width / (view.x1 - view.x0) > resolution;
+		bool split_y = (y1 - y0) * view.height / (view.y1 - view.y0) > resolution;
+		if (!split_x && !split_y) {
+			//A continuous f has a finite enclosure, an unbounded one at leaf size means a pole rather than a crossing
+			if (std::isfinite(f.lo) && std::isfinite(f.hi))
+				March(chunk, vm, x0, x1, y0, y1, tile);
+			return;
+		}
+
+		double xm = (split_x) ? 0.5 * (x0 + x1) : x1;
+		double ym = (split_y) ? 0.5 * (y0 + y1) : y1;
+		Refine(chunk, vm, x0, xm, y0, ym, tile);
+		if (split_x)
+			Refine(chunk, vm, xm, x1, y0, ym, tile);
+		if (split_y)
+			Refine(chunk, vm, x0, xm, ym, y1, tile);
+		if (split_x && split_y)
+			Refine(chunk, vm, xm, x1, ym, y1, tile);
+	}
+
+	//Corners go counter clockwise from (x0, y0) and edge i joins corner i to corner i + 1
+	void ImplicitSampler::March(const Chunk& chunk, VirtualMachine& vm, double x0, double x1, double y0, double y1, Tile& tile) {
+		const double cx[4] = { x0, x1, x1, x0 };
+		const double cy[4] = { y0, y0, y1, y1 };
+		double f[4];
+		tile.stats.leaves++;
+		tile.stats.evaluations += 4;
+		for (int i = 0; i < 4; i++) {
+			f[i] = vm.Run(chunk, cx[i], cy[i]);
+			if (!std::isfinite(f[i]))
+				return;
+		}
+
+		double ex[4], ey[4];
+		int count = 0;
+		for (int i = 0; i < 4; i++) {
+			int j = (i + 1) & 3;
+			if ((f[i] > 0.0) == (f[j] > 0.0))
+				continue;
+			double t = f[i] / (f[i] - f[j]);
+			ex[count] = cx[i] + t * (cx[j] - cx[i]);
+			ey[count] = cy[i] + t * (cy[j] - cy[i]);
+			count++;
+		}
+
+		auto emit = [&](int a, int b) {
+			ImplicitSegment segment;
+			segment.x0 = ex[a];
+			segment.y0 = ey[a];
+			segment.x1 = ex[b];
+			segment.y1 = ey[b];
+			tile.segments.push_back(segment);
+		};
+
+		if (count == 2)
+			emit(0, 1);
+		else if (count == 4) {
+			//Saddle, the center decides whether corners 0 and 2 are joined through the middle of the cell
+			tile.stats.evaluations++;
+			double center = vm.Run(chunk, 0.5 * (x0 + x1), 0.5 * (y0 + y1));
+			if ((center > 0.0) == (f[0] > 0.0)) {
+				emit(0, 1);
+				emit(2, 3);
+			}
+			else {
+				emit(3, 0);
+				emit(1, 2);
+			}
+		}
+	}
+}
\ No newline at end of file
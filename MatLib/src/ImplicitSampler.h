@@ -0,0 +1,62 @@
+#ifndef IMPLICIT_SAMPLER_H
+#define IMPLICIT_SAMPLER_H
+
+#include "AdaptiveSampler.h"
+#include "ThreadPool.h"
+
+namespace MatLib {
+	struct ImplicitSegment {
+		double x0 = 0.0, y0 = 0.0;
+		double x1 = 0.0, y1 = 0.0;
+	};
+
+	struct ImplicitStatistics {
+		uint32_t cells = 0;
+		uint32_t culled = 0;
+		uint32_t leaves = 0;
+		uint32_t segments = 0;
+		uint32_t evaluations = 0;
+		double milliseconds = 0.0;
+	};
+
+	//Traces f(x, y) = 0 over the view with a quadtree. Cells whose interval enclosure excludes zero are dropped whole,
+	//cells that reach the leaf size in pixels are contoured with marching squares. Top level tiles run on the thread pool
+	class ImplicitSampler {
+	public:
+		ImplicitSampler() = default;
+		ImplicitSampler(FunctionSolver* solver, ThreadPool* pool);
+
+		void SetRelation(size_t relation);
+		void SetView(const SamplerView& view);
+		void Reset();
+		bool Sample();
+		bool Done() const { return !dirty; }
+
+		const std::vector<ImplicitSegment>& Segments() const { return segments; }
+		const ImplicitStatistics& Statistics() const { return stats; }
+
+		double resolution = 2.0;
+		uint32_t tiles = 8;
+	private:
+		struct Tile {
+			std::vector<ImplicitSegment> segments;
+			ImplicitStatistics stats;
+		};
+
+		FunctionSolver* solver = nullptr;
+		ThreadPool* pool = nullptr;
+		size_t relation = 0;
+		SamplerView view;
+		bool dirty = true;
+
+		std::vector<Tile> tile_output;
+		std::vector<VirtualMachine> machines;
+		std::vector<ImplicitSegment> segments;
+		ImplicitStatistics stats;
+	private:
+		void Refine(const Chunk& chunk, VirtualMachine& vm, double x0, double x1, double y0, double y1, Tile& tile);
+		void March(const Chunk& chunk, VirtualMachine& vm, double x0, double x1, double y0, double y1, Tile& tile);
+	};
+}
+
+#endif // !IMPLICIT_SAMPLER_H
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include "Interner.h"
+
+#include <cstring>
+
+namespace MatLib {
+	//Symbol 0 is the empty name so a zeroed identifier never matches a real one
+	Interner::Interner() : slots(256) {
+		names.push_back(std::string_view());
+	}
+
+	Interner& Interner::Global() {
+		static Interner interner;
+		return interner;
+	}
+
+	uint32_t Interner::Hash(std::string_view name) {
+		uint32_t h = 2166136261u;
+		for (char c : name)
+			h = (h ^ (uint8_t)c) * 16777619u;
+		return h;
+	}
+
+	//Returns the slot holding name, or the empty slot where it would go
+	size_t Interner::Probe(std::string_view name, uint32_t hash) const {
+		size_t mask = slots.size() - 1;
+		for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+			const Slot& slot = slots[i];
+			if (slot.symbol == SYMBOL_NONE || (slot.hash == hash && names[slot.symbol] == name))
+				return i;
+		}
+	}
+
+	uint32_t Interner::Intern(std::string_view name) {
+		if (name.empty())
+			return SYMBOL_NONE;
+
+		uint32_t hash = Hash(name);
+		size_t index = Probe(name, hash);
+		if (slots[index].symbol != SYMBOL_NONE)
+			return slots[index].symbol;
+
+		char* copy = static_cast<char*>(storage.Allocate(name.size(), 1));
+		memcpy(copy, name.data(), name.size());
+
+		uint32_t symbol = (uint32_t)names.size();
+		names.push_back(std::string_view(copy, name.size()));
+		slots[index].hash = hash;
+		slots[index].symbol = symbol;
+
+		//Kept under half full so probe runs stay short
+		if (names.size() * 2 > slots.size())
+			Grow();
+		return symbol;
+	}
+
+	uint32_t Interner::Find(std::string_view name) const {
+		return (name.empty()) ? SYMBOL_NONE : slots[Probe(name, Hash(name))].symbol;
+	}
+
+	void Interner::Grow() {
+		std::vector<Slot> old(slots.size() * 2);
+		old.swap(slots);
+		size_t mask = slots.size() - 1;
+		for (auto& slot : old) {
+			if (slot.symbol == SYMBOL_NONE)
+				continue;
+			size_t i = slot.hash & mask;
+			while (slots[i].symbol != SYMBOL_NONE)
+				i = (i + 1) & mask;
+			slots[i] = slot;
+		}
+	}
+}
\ No newline at end of file
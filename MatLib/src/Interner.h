@@ -0,0 +1,42 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include "Arena.h"
+
+#include <string_view>
+
+namespace MatLib {
+	constexpr uint32_t SYMBOL_NONE = 0;
+
+	//Maps every identifier to a dense id once at lex time, later stages compare and index by the id alone.
+	//Names live in an arena so the views handed out stay valid for the life of the program, lookups go through an open
+	//addressed table of (hash, symbol) pairs. Not thread safe, intern from the thread that lexes and parses
+	class Interner {
+	public:
+		static Interner& Global();
+
+		uint32_t Intern(std::string_view name);
+		uint32_t Find(std::string_view name) const;
+		std::string_view Name(uint32_t symbol) const { return (symbol < names.size()) ? names[symbol] : std::string_view(); }
+
+		size_t Size() const { return names.size(); }
+		size_t Bytes() const { return storage.Statistics().bytes_used; }
+	private:
+		Interner();
+
+		struct Slot {
+			uint32_t hash = 0;
+			uint32_t symbol = SYMBOL_NONE;
+		};
+
+		Arena storage{ 4096 };
+		std::vector<std::string_view> names;
+		std::vector<Slot> slots;
+	private:
+		static uint32_t Hash(std::string_view name);
+		size_t Probe(std::string_view name, uint32_t hash) const;
+		void Grow();
+	};
+}
+
+#endif // !INTERNER_H
\ No newline at end of file
@@ -1,56 +1,512 @@
 #include "Interpreter.h"
+#include "Kernels.h"
+
+#include <cmath>
 
 namespace MatLib {
 	Interpreter::Interpreter(Parser* parser) {
 		this->parser = parser;
 	}
 
+	//Resolved names read their frame slot, anything else is the input or zero
+	double Interpreter::Variable(Ast_Identifier* ident) const {
+		if (ident->local)
+			return 0.0;
+		if (ident->slot >= 0)
+			return ((size_t)ident->slot < environment.size()) ? environment[ident->slot] : 0.0;
+		return (ident->symbol == input_symbol) ? input : 0.0;
+	}
+
+	//Runs the script in order at the current input, each assignment writes its slot for the statements after it
+	void Interpreter::Execute(Ast_Script* script) {
+		if (!script)
+			return;
+		environment.assign(script->slots, 0.0);
+		for (auto proc : script->procedures)
+			if (proc->type == AST_ASSIGNMENT && proc->id && proc->id->slot >= 0)
+				environment[proc->id->slot] = SolveExpression(proc->expr);
+	}
+
+	//Same order as Execute, every assignment is computed from the big-float values before it rather than from doubles
+	void Interpreter::ExecuteBigFloat(Ast_Script* script, const BigFloat& x) {
+		if (!script)
+			return;
+		BigFloat::Precision precision((digits) ? digits : BIG_FLOAT_DEFAULT_DIGITS);
+		big_environment.assign(script->slots, BigFloat());
+		for (auto proc : script->procedures)
+			if (proc->type == AST_ASSIGNMENT && proc->id && proc->id->slot >= 0)
+				big_environment[proc->id->slot] = SolveBigFloat(proc->expr, x);
+	}
+
+	BigFloat Interpreter::SolveBigFloat(Ast_Expression* expr, const BigFloat& x) {
+		BigFloat::Precision precision((digits) ? digits : BIG_FLOAT_DEFAULT_DIGITS);
+		return Solve<BigFloat>(expr, [&](Ast_Identifier* ident) {
+			if (ident->local)
+				return BigFloat();
+			if (ident->slot >= 0)
+				return ((size_t)ident->slot < big_environment.size()) ? big_environment[ident->slot] : BigFloat();
+			return (ident->symbol == input_symbol) ? x : BigFloat();
+		});
+	}
+
+	void Interpreter::ExecuteRational(Ast_Script* script, const Rational& x) {
+		if (!script)
+			return;
+		rational_environment.assign(script->slots, Rational());
+		for (auto proc : script->procedures)
+			if (proc->type == AST_ASSIGNMENT && proc->id && proc->id->slot >= 0)
+				rational_environment[proc->id->slot] = SolveRational(proc->expr, x);
+	}
+
+	Rational Interpreter::SolveRational(Ast_Expression* expr, const Rational& x) {
+		return Solve<Rational>(expr, [&](Ast_Identifier* ident) {
+			if (ident->local)
+				return Rational();
+			if (ident->slot >= 0)
+				return ((size_t)ident->slot < rational_environment.size()) ? rational_environment[ident->slot] : Rational();
+			return (ident->symbol == input_symbol) ? x : Rational();
+		});
+	}
+
+	void Interpreter::ExecuteComplex(Ast_Script* script, const Complex& z) {
+		if (!script)
+			return;
+		complex_environment.assign(script->slots, Complex());
+		for (auto proc : script->procedures)
+			if (proc->type == AST_ASSIGNMENT && proc->id && proc->id->slot >= 0)
+				complex_environment[proc->id->slot] = SolveComplex(proc->expr, z);
+	}
+
+	Complex Interpreter::SolveComplex(Ast_Expression* expr, const Complex& z) {
+		return Solve<Complex>(expr, [&](Ast_Identifier* ident) {
+			if (ident->local)
+				return Complex();
+			if (ident->slot >= 0)
+				return ((size_t)ident->slot < complex_environment.size()) ? complex_environment[ident->slot] : Complex();
+			if (ident->symbol == input_symbol)
+				return z;
+			return (ident->symbol == imaginary_symbol) ? Complex(0.0, 1.0) : Complex();
+		});
+	}
+
+	void Interpreter::ExecuteMatrix(Ast_Script* script, const Matrix& x) {
+		if (!script)
+			return;
+		matrix_environment.assign(script->slots, Matrix());
+		for (auto proc : script->procedures)
+			if (proc->type == AST_ASSIGNMENT && proc->id && proc->id->slot >= 0)
+				matrix_environment[proc->id->slot] = SolveMatrix(proc->expr, x);
+	}
+
+	Matrix Interpreter::SolveMatrix(Ast_Expression* expr, const Matrix& x) {
+		return Solve<Matrix>(expr, [&](Ast_Identifier* ident) {
+			if (ident->local)
+				return Matrix();
+			if (ident->slot >= 0)
+				return ((size_t)ident->slot < matrix_environment.size()) ? matrix_environment[ident->slot] : Matrix();
+			return (ident->symbol == input_symbol) ? x : Matrix();
+		});
+	}
+
 	double Interpreter::SolveExpression(Ast_Expression* expr) {
+		return Solve<double>(expr, [this](Ast_Identifier* ident) {
+			return Variable(ident);
+		});
+	}
+
+	//Leaf for the modes that carry more than a value. Seed resolves the names it knows (the input, gradient variables),
+	//an assigned name is solved from its definition the first time it is read, so it follows the input instead of
+	//reading the environment of the last Execute, and anything else is a plain double. The values are only allocated
+	//once a global is read, expressions of x alone stay off the heap
+	template <typename T, typename Seed>
+	struct DefinitionLeaf {
+		Interpreter* interpreter;
+		const Seed& seed;
+		mutable std::vector<T> values;
+		mutable std::vector<char> ready;
+
+		DefinitionLeaf(Interpreter* interpreter, const Seed& seed) : interpreter(interpreter), seed(seed) { }
+
+		T operator()(Ast_Identifier* ident) const {
+			T value;
+			if (seed(ident, value))
+				return value;
+			Ast_Expression* definition = interpreter->Definition(ident);
+			if (!definition)
+				return T(interpreter->Variable(ident));
+			if (values.empty()) {
+				values.resize(interpreter->parser->Root()->definitions.size());
+				ready.assign(values.size(), 0);
+			}
+			if (!ready[ident->slot]) {
+				values[ident->slot] = interpreter->Solve<T>(definition, *this);
+				ready[ident->slot] = 1;
+			}
+			return values[ident->slot];
+		}
+	};
+
+	Ast_Expression* Interpreter::Definition(Ast_Identifier* ident) const {
+		Ast_Script* script = (parser) ? parser->Root() : nullptr;
+		if (!ident || ident->local || ident->slot < 0 || !script || (size_t)ident->slot >= script->definitions.size())
+			return nullptr;
+		return script->definitions[ident->slot]->expr;
+	}
+
+	Dual Interpreter::SolveDual(Ast_Expression* expr) {
+		auto seed = [this](Ast_Identifier* ident, Dual& value) {
+			if (ident->slot >= 0 || ident->symbol != input_symbol)
+				return false;
+			value = Dual(input, 1.0);
+			return true;
+		};
+		return Solve<Dual>(expr, DefinitionLeaf<Dual, decltype(seed)>(this, seed));
+	}
+
+	Interval Interpreter::SolveInterval(Ast_Expression* expr, const Interval& x) {
+		auto seed = [&](Ast_Identifier* ident, Interval& value) {
+			if (ident->slot >= 0 || ident->symbol != input_symbol)
+				return false;
+			value = x;
+			return true;
+		};
+		return Solve<Interval>(expr, DefinitionLeaf<Interval, decltype(seed)>(this, seed));
+	}
+
+	//False is a proof that f has no zero anywhere in [a, b], true only means one could not be ruled out
+	bool Interpreter::MayHaveRoot(Ast_Expression* expr, double a, double b) {
+		return SolveInterval(expr, Interval(fmin(a, b), fmax(a, b))).Contains(0.0);
+	}
+
+	//Identifiers found in variables are seeded with their value, anything else falls back to the input.
+	//Symbols index straight into variable_slots, so resolving an identifier is one load rather than a search
+	double Interpreter::SolveGradient(Ast_Expression* expr, const std::vector<std::string>& variables, const double* values, double* gradient) {
+		std::vector<uint32_t> symbols(variables.size());
+		for (size_t i = 0; i < variables.size(); i++)
+			symbols[i] = Interner::Global().Intern(variables[i]);
+		if (variable_slots.size() < Interner::Global().Size())
+			variable_slots.resize(Interner::Global().Size(), -1);
+		for (size_t i = variables.size(); i-- > 0;)
+			variable_slots[symbols[i]] = (int32_t)i;
+
+		double value = 0.0;
+		for (size_t first = 0; first == 0 || first < variables.size(); first += GRADIENT_WIDTH) {
+			auto seed = [&](Ast_Identifier* ident, Gradient& value) {
+				int32_t i = (ident->symbol < variable_slots.size()) ? variable_slots[ident->symbol] : -1;
+				if (i < 0)
+					return false;
+
+				value = Gradient(values[i]);
+				if ((size_t)i >= first && i - first < GRADIENT_WIDTH)
+					value.d[i - first] = 1.0;
+				return true;
+			};
+			Gradient g = Solve<Gradient>(expr, DefinitionLeaf<Gradient, decltype(seed)>(this, seed));
+
+			value = g.value;
+			for (size_t i = first; i < variables.size() && i - first < GRADIENT_WIDTH; i++)
+				gradient[i] = g.d[i - first];
+		}
+
+		for (uint32_t symbol : symbols)
+			variable_slots[symbol] = -1;
+		return value;
+	}
+
+	void Interpreter::EvaluateBatch(Ast_Expression* expr, const double* xs, double* out, size_t count) {
+		batch_uses.clear();
+		batch_temps.clear();
+		CountBatchUses(expr);
+		for (auto& use : batch_uses) {
+			auto p = (use.first->type == AST_PRIMARY) ? AST_CAST(Ast_PrimaryExpression, use.first) : nullptr;
+			if (use.second > 1 && !(p && !p->call && !Definition(p->ident)))
+				batch_temps.emplace(use.first, (uint32_t)batch_temps.size());
+		}
+		while (batch_temp_blocks.size() < batch_temps.size())
+			batch_temp_blocks.emplace_back(BATCH_BLOCK_SIZE);
+
+		for (size_t i = 0; i < count; i += BATCH_BLOCK_SIZE) {
+			size_t n = (count - i < BATCH_BLOCK_SIZE) ? count - i : BATCH_BLOCK_SIZE;
+			batch_temp_ready.assign(batch_temps.size(), 0);
+			EvaluateBlock(expr, xs + i, out + i, n, 0);
+		}
+	}
+
+	//Same counting as the compiler: a node reached from more than one parent (after hash consing) is computed once per
+	//block and copied out of its temp block afterwards. Procedure bodies are not counted, they differ at every call, but
+	//the definition behind an assigned name is, every read of the name shares it
+	void Interpreter::CountBatchUses(Ast_Expression* expr) {
+		if (!expr || batch_uses[expr]++ > 0)
+			return;
+
+		switch (expr->type) {
+		case AST_UNARY:
+			CountBatchUses(AST_CAST(Ast_UnaryExpression, expr)->next);
+			break;
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			CountBatchUses(p->nested);
+			CountBatchUses(Definition(p->ident));
+			if (p->call)
+				for (auto arg : p->call->args)
+					CountBatchUses(arg);
+			break;
+		}
+		case AST_BINARY:
+			CountBatchUses(AST_CAST(Ast_BinaryExpression, expr)->left);
+			CountBatchUses(AST_CAST(Ast_BinaryExpression, expr)->right);
+			break;
+		case AST_MATRIX:
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				CountBatchUses(element);
+			break;
+		}
+	}
+
+	void Interpreter::EvaluateBlock(Ast_Expression* expr, const double* xs, double* out, size_t count, size_t depth, double* const* frame) {
+		auto it = (frame) ? batch_temps.end() : batch_temps.find(expr);
+		if (it == batch_temps.end()) {
+			EvaluateNode(expr, xs, out, count, depth, frame);
+			return;
+		}
+
+		double* temp = batch_temp_blocks[it->second].data();
+		if (!batch_temp_ready[it->second]) {
+			EvaluateNode(expr, xs, temp, count, depth, frame);
+			batch_temp_ready[it->second] = 1;
+		}
+		Kernels::Copy(temp, out, count);
+	}
+
+	//Call arguments take one scratch block each, the callee then runs on the blocks after them
+	void Interpreter::EvaluateNode(Ast_Expression* expr, const double* xs, double* out, size_t count, size_t depth, double* const* frame) {
 		if (expr) {
 			switch (expr->type) {
 			case AST_UNARY: {
 				auto u = AST_CAST(Ast_UnaryExpression, expr);
-				double p = SolveExpression(u->next);
-				switch (u->op) {
-				case AST_UNARY_MINUS:
-					return -p;
+				EvaluateBlock(u->next, xs, out, count, depth, frame);
+				if (u->op == AST_UNARY_MINUS)
+					Kernels::Negate(out, out, count);
+				return;
+			}
+			case AST_PRIMARY: {
+				auto p = AST_CAST(Ast_PrimaryExpression, expr);
+				if (p->nested)
+					EvaluateBlock(p->nested, xs, out, count, depth, frame);
+				else if (p->ident && p->ident->local && frame)
+					Kernels::Copy(frame[p->ident->slot], out, count);
+				else if (Ast_Expression* definition = Definition(p->ident))
+					EvaluateBlock(definition, xs, out, count, depth);
+				else if (p->call && p->call->builtin >= 0) {
+					//Built-ins run their block kernel over the whole block of arguments at once
+					const Builtin& builtin = Builtins::Get(p->call->builtin);
+					double* args[PROCEDURE_MAX_ARGS];
+					for (size_t i = 0; i < builtin.args; i++) {
+						args[i] = Scratch(depth + i);
+						EvaluateBlock(p->call->args[i], xs, args[i], count, depth + i + 1, frame);
+					}
+					builtin.block(args, out, count);
+				}
+				else if (p->call) {
+					Ast_Procedure* callee = (parser && parser->Root()) ? parser->Root()->Callee(p->call) : nullptr;
+					if (!callee) {
+						Kernels::Fill(out, NAN, count);
+						return;
+					}
+					double* args[PROCEDURE_MAX_ARGS];
+					for (size_t i = 0; i < callee->args.size(); i++) {
+						args[i] = Scratch(depth + i);
+						EvaluateBlock(p->call->args[i], xs, args[i], count, depth + i + 1, frame);
+					}
+					EvaluateBlock(callee->expr, xs, out, count, depth + callee->args.size(), args);
+				}
+				else if (p->ident && p->ident->slot < 0 && p->ident->symbol == input_symbol)
+					Kernels::Copy(xs, out, count);
+				else
+					Kernels::Fill(out, (p->ident) ? Variable(p->ident) : p->num_const, count);
+				return;
+			}
+			case AST_BINARY: {
+				auto b = AST_CAST(Ast_BinaryExpression, expr);
+				double* right = Scratch(depth);
+				EvaluateBlock(b->left, xs, out, count, depth + 1, frame);
+				EvaluateBlock(b->right, xs, right, count, depth + 1, frame);
+
+				switch (b->op) {
+				case AST_OPERATOR_ADD:
+					Kernels::Add(out, right, out, count);
+					return;
+				case AST_OPERATOR_SUB:
+					Kernels::Sub(out, right, out, count);
+					return;
+				case AST_OPERATOR_MULTIPLICATIVE:
+					Kernels::Mul(out, right, out, count);
+					return;
+				case AST_OPERATOR_DIVISION:
+					Kernels::Div(out, right, out, count);
+					return;
+				case AST_OPERATOR_POWER:
+					Kernels::Pow(out, right, out, count);
+					return;
 				default:
-					return p;
+					break;
 				}
 				break;
 			}
+			case AST_MATRIX: {
+				//Batches are scalar, a 1x1 matrix is its element and anything larger has no value
+				auto m = AST_CAST(Ast_MatrixExpression, expr);
+				if (m->elements.size() == 1)
+					EvaluateBlock(m->elements[0], xs, out, count, depth, frame);
+				else
+					Kernels::Fill(out, NAN, count);
+				return;
+			}
+			}
+		}
+		Kernels::Fill(out, 0.0, count);
+	}
+
+	double* Interpreter::Scratch(size_t depth) {
+		while (batch_scratch.size() <= depth)
+			batch_scratch.emplace_back(BATCH_BLOCK_SIZE);
+		return batch_scratch[depth].data();
+	}
+
+	void Interpreter::EvaluateComplexBatch(Ast_Expression* expr, const double* re, const double* im, double* out_re, double* out_im, size_t count) {
+		for (size_t i = 0; i < count; i += BATCH_BLOCK_SIZE) {
+			size_t n = (count - i < BATCH_BLOCK_SIZE) ? count - i : BATCH_BLOCK_SIZE;
+			EvaluateComplexBlock(expr, re + i, im + i, out_re + i, out_im + i, n, 0);
+		}
+	}
+
+	//Same walk as EvaluateBlock over split arrays. A scratch block and a frame entry hold the real half followed by the
+	//imaginary half, and an assigned name is evaluated from its definition so it may depend on the input
+	void Interpreter::EvaluateComplexBlock(Ast_Expression* expr, const double* re, const double* im, double* out_re, double* out_im, size_t count, size_t depth, double* const* frame) {
+		if (expr) {
+			switch (expr->type) {
+			case AST_UNARY: {
+				auto u = AST_CAST(Ast_UnaryExpression, expr);
+				EvaluateComplexBlock(u->next, re, im, out_re, out_im, count, depth, frame);
+				if (u->op == AST_UNARY_MINUS) {
+					//Subtracts from zero like the scalar negation rather than flipping signs
+					double* zero = ComplexScratch(depth);
+					Kernels::Fill(zero, 0.0, count);
+					Kernels::Sub(zero, out_re, out_re, count);
+					Kernels::Sub(zero, out_im, out_im, count);
+				}
+				return;
+			}
 			case AST_PRIMARY: {
 				auto p = AST_CAST(Ast_PrimaryExpression, expr);
-				
-				if (p->nested) {
-					return SolveExpression(p->nested);
+				Ast_Script* script = (parser) ? parser->Root() : nullptr;
+				if (p->nested)
+					EvaluateComplexBlock(p->nested, re, im, out_re, out_im, count, depth, frame);
+				else if (p->ident && p->ident->local && frame) {
+					Kernels::Copy(frame[p->ident->slot], out_re, count);
+					Kernels::Copy(frame[p->ident->slot] + BATCH_BLOCK_SIZE, out_im, count);
 				}
-				else 
-					return p->num_const;
-				break;
+				else if (Ast_Expression* definition = Definition(p->ident))
+					EvaluateComplexBlock(definition, re, im, out_re, out_im, count, depth);
+				else if (p->ident && p->ident->slot < 0 && p->ident->symbol == input_symbol) {
+					Kernels::Copy(re, out_re, count);
+					Kernels::Copy(im, out_im, count);
+				}
+				else if (p->ident && p->ident->slot < 0 && p->ident->symbol == imaginary_symbol) {
+					Kernels::Fill(out_re, 0.0, count);
+					Kernels::Fill(out_im, 1.0, count);
+				}
+				else if (p->call) {
+					Ast_Procedure* callee = (p->call->builtin < 0 && script) ? script->Callee(p->call) : nullptr;
+					size_t args_count = (p->call->builtin >= 0) ? Builtins::Get(p->call->builtin).args : (callee) ? callee->args.size() : 0;
+					if (p->call->builtin < 0 && !callee) {
+						Kernels::Fill(out_re, NAN, count);
+						Kernels::Fill(out_im, NAN, count);
+						return;
+					}
+					double* args[PROCEDURE_MAX_ARGS];
+					for (size_t i = 0; i < args_count; i++) {
+						args[i] = ComplexScratch(depth + i);
+						EvaluateComplexBlock(p->call->args[i], re, im, args[i], args[i] + BATCH_BLOCK_SIZE, count, depth + i + 1, frame);
+					}
+					if (callee) {
+						EvaluateComplexBlock(callee->expr, re, im, out_re, out_im, count, depth + args_count, args);
+						return;
+					}
+
+					//exp has a block kernel, the other built-ins go lane by lane through the scalar Complex functions
+					if (p->call->builtin == BUILTIN_EXP) {
+						Kernels::ComplexExp(args[0], args[0] + BATCH_BLOCK_SIZE, out_re, out_im, count);
+						return;
+					}
+					for (size_t j = 0; j < count; j++) {
+						Complex lane[PROCEDURE_MAX_ARGS];
+						for (size_t i = 0; i < args_count; i++)
+							lane[i] = Complex(args[i][j], args[i][j + BATCH_BLOCK_SIZE]);
+						Complex value = Builtins::Apply<Complex>(p->call->builtin, lane);
+						out_re[j] = value.re;
+						out_im[j] = value.im;
+					}
+				}
+				else {
+					Kernels::Fill(out_re, (p->ident) ? Variable(p->ident) : p->num_const, count);
+					Kernels::Fill(out_im, 0.0, count);
+				}
+				return;
 			}
 			case AST_BINARY: {
 				auto b = AST_CAST(Ast_BinaryExpression, expr);
-				double left = SolveExpression(b->left);
-				double right = SolveExpression(b->right);
+				double* right = ComplexScratch(depth);
+				double* right_im = right + BATCH_BLOCK_SIZE;
+				EvaluateComplexBlock(b->left, re, im, out_re, out_im, count, depth + 1, frame);
+				EvaluateComplexBlock(b->right, re, im, right, right_im, count, depth + 1, frame);
 
 				switch (b->op) {
 				case AST_OPERATOR_ADD:
-					return left + right;
+					Kernels::Add(out_re, right, out_re, count);
+					Kernels::Add(out_im, right_im, out_im, count);
+					return;
 				case AST_OPERATOR_SUB:
-					return left - right;
+					Kernels::Sub(out_re, right, out_re, count);
+					Kernels::Sub(out_im, right_im, out_im, count);
+					return;
 				case AST_OPERATOR_MULTIPLICATIVE:
-					return left * right;
+					Kernels::ComplexMul(out_re, out_im, right, right_im, out_re, out_im, count);
+					return;
 				case AST_OPERATOR_DIVISION:
-					return left / right;
+					Kernels::ComplexDiv(out_re, out_im, right, right_im, out_re, out_im, count);
+					return;
+				case AST_OPERATOR_POWER:
+					for (size_t j = 0; j < count; j++) {
+						Complex value = Power(Complex(out_re[j], out_im[j]), Complex(right[j], right_im[j]));
+						out_re[j] = value.re;
+						out_im[j] = value.im;
+					}
+					return;
 				default:
 					break;
 				}
-
 				break;
 			}
+			case AST_MATRIX: {
+				auto m = AST_CAST(Ast_MatrixExpression, expr);
+				if (m->elements.size() == 1)
+					EvaluateComplexBlock(m->elements[0], re, im, out_re, out_im, count, depth, frame);
+				else {
+					Kernels::Fill(out_re, NAN, count);
+					Kernels::Fill(out_im, NAN, count);
+				}
+				return;
+			}
 			}
 		}
-		return 0.0;
+		Kernels::Fill(out_re, 0.0, count);
+		Kernels::Fill(out_im, 0.0, count);
+	}
+
+	double* Interpreter::ComplexScratch(size_t depth) {
+		while (complex_scratch.size() <= depth)
+			complex_scratch.emplace_back(2 * BATCH_BLOCK_SIZE);
+		return complex_scratch[depth].data();
 	}
 }
\ No newline at end of file
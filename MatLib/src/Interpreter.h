@@ -2,17 +2,184 @@
 #define INTERPRETER_H
 
 #include "Parser.h"
+#include "Builtins.h"
+#include "BigFloat.h"
+#include "Rational.h"
+#include "Complex.h"
+#include "Matrix.h"
 
 namespace MatLib {
+	constexpr size_t BATCH_BLOCK_SIZE = 256;
+
+	//A number as Solve reads it. The exact modes parse the literal as written so no digit goes through a double
+	template <typename T>
+	inline T Literal(const Ast_PrimaryExpression* p) { return T(p->num_const); }
+
+	template <>
+	inline BigFloat Literal<BigFloat>(const Ast_PrimaryExpression* p) {
+		return (p->literal.empty()) ? BigFloat(p->num_const) : BigFloat::Parse(p->literal);
+	}
+
+	template <>
+	inline Rational Literal<Rational>(const Ast_PrimaryExpression* p) {
+		return (p->literal.empty()) ? Rational(p->num_const) : Rational::Parse(p->literal);
+	}
+
 	class Interpreter {
 	public:
 		Interpreter() = default;
 		Interpreter(Parser* parser);
 
 		double SolveExpression(Ast_Expression* expr);
+		Dual SolveDual(Ast_Expression* expr);
+		Interval SolveInterval(Ast_Expression* expr, const Interval& x);
+		bool MayHaveRoot(Ast_Expression* expr, double a, double b);
+		double SolveGradient(Ast_Expression* expr, const std::vector<std::string>& variables, const double* values, double* gradient);
+		void EvaluateBatch(Ast_Expression* expr, const double* xs, double* out, size_t count);
+		void Execute(Ast_Script* script);
+
+		//Big-float mode evaluates the whole script at digits significant digits, 0 leaves the script in doubles
+		void SetDigits(uint32_t digits) { this->digits = digits; }
+		uint32_t Digits() const { return digits; }
+		void ExecuteBigFloat(Ast_Script* script, const BigFloat& x);
+		BigFloat SolveBigFloat(Ast_Expression* expr, const BigFloat& x);
+		const std::vector<BigFloat>& BigFloatEnvironment() const { return big_environment; }
+
+		//Rational mode keeps every value exact, anything without an exact rational result becomes NaN
+		void ExecuteRational(Ast_Script* script, const Rational& x);
+		Rational SolveRational(Ast_Expression* expr, const Rational& x);
+		const std::vector<Rational>& RationalEnvironment() const { return rational_environment; }
+
+		//Complex mode reads an unassigned i as the imaginary unit. The batch form takes the inputs and results as split
+		//real and imaginary arrays and evaluates assigned names from their definitions at every point
+		void ExecuteComplex(Ast_Script* script, const Complex& z);
+		Complex SolveComplex(Ast_Expression* expr, const Complex& z);
+		void EvaluateComplexBatch(Ast_Expression* expr, const double* re, const double* im, double* out_re, double* out_im, size_t count);
+		const std::vector<Complex>& ComplexEnvironment() const { return complex_environment; }
+
+		//Matrix mode gives every value a shape, [a, b; c, d] literals build them and * is the matrix product
+		void ExecuteMatrix(Ast_Script* script, const Matrix& x);
+		Matrix SolveMatrix(Ast_Expression* expr, const Matrix& x);
+		const std::vector<Matrix>& MatrixEnvironment() const { return matrix_environment; }
+
+		void SetInput(std::string_view id) { input_symbol = Interner::Global().Intern(id); }
+		void SetInputValue(double value) { input = value; }
+		std::string_view InputId() const { return Interner::Global().Name(input_symbol); }
+		const std::vector<double>& Environment() const { return environment; }
+
+		//Shared tree walk for every numeric mode, T needs + - * / unary -, Pow, the built-ins, Assemble and construction
+		//from double. A call evaluates its arguments into a frame on the native stack, so calls never touch the heap
+		template <typename T, typename Leaf>
+		T Solve(Ast_Expression* expr, const Leaf& leaf, const T* frame = nullptr) {
+			if (expr) {
+				switch (expr->type) {
+				case AST_UNARY: {
+					auto u = AST_CAST(Ast_UnaryExpression, expr);
+					T p = Solve<T>(u->next, leaf, frame);
+					switch (u->op) {
+					case AST_UNARY_MINUS:
+						return -p;
+					default:
+						return p;
+					}
+					break;
+				}
+				case AST_PRIMARY: {
+					auto p = AST_CAST(Ast_PrimaryExpression, expr);
+
+					if (p->nested)
+						return Solve<T>(p->nested, leaf, frame);
+					else if (p->ident && p->ident->local)
+						return (frame) ? frame[p->ident->slot] : T(0.0);
+					else if (p->ident)
+						return leaf(p->ident);
+					else if (p->call && p->call->builtin >= 0) {
+						T args[PROCEDURE_MAX_ARGS];
+						for (size_t i = 0; i < p->call->args.size(); i++)
+							args[i] = Solve<T>(p->call->args[i], leaf, frame);
+						return Builtins::Apply<T>(p->call->builtin, args);
+					}
+					else if (p->call) {
+						//Resolve reported the call, it has nothing to run with these arguments
+						Ast_Procedure* callee = (parser && parser->Root()) ? parser->Root()->Callee(p->call) : nullptr;
+						if (!callee)
+							return T(NAN);
+						T args[PROCEDURE_MAX_ARGS];
+						for (size_t i = 0; i < p->call->args.size(); i++)
+							args[i] = Solve<T>(p->call->args[i], leaf, frame);
+						return Solve<T>(callee->expr, leaf, args);
+					}
+					else
+						return Literal<T>(p);
+					break;
+				}
+				case AST_BINARY: {
+					auto b = AST_CAST(Ast_BinaryExpression, expr);
+					T left = Solve<T>(b->left, leaf, frame);
+					T right = Solve<T>(b->right, leaf, frame);
+
+					switch (b->op) {
+					case AST_OPERATOR_ADD:
+						return left + right;
+					case AST_OPERATOR_SUB:
+						return left - right;
+					case AST_OPERATOR_MULTIPLICATIVE:
+						return left * right;
+					case AST_OPERATOR_DIVISION:
+						return left / right;
+					case AST_OPERATOR_POWER:
+						return Pow(left, right);
+					default:
+						break;
+					}
+
+					break;
+				}
+				case AST_MATRIX: {
+					auto m = AST_CAST(Ast_MatrixExpression, expr);
+					std::vector<T> elements;
+					elements.reserve(m->elements.size());
+					for (auto element : m->elements)
+						elements.push_back(Solve<T>(element, leaf, frame));
+					return Assemble(m->rows, m->cols, elements);
+				}
+				}
+			}
+			return T(0.0);
+		}
 	protected:
-		Parser* parser; 
+		Parser* parser = nullptr;
+		uint32_t input_symbol = Interner::Global().Intern("x");
+		double input = 0.0;
+		std::vector<double> environment;
+		uint32_t digits = 0;
+		std::vector<BigFloat> big_environment;
+		std::vector<Rational> rational_environment;
+		std::vector<Complex> complex_environment;
+		std::vector<Matrix> matrix_environment;
+		uint32_t imaginary_symbol = Interner::Global().Intern("i");
+	private:
+		std::vector<std::vector<double>> batch_scratch;
+		std::unordered_map<Ast_Expression*, uint32_t> batch_uses;
+		std::unordered_map<Ast_Expression*, uint32_t> batch_temps;
+		std::vector<std::vector<double>> batch_temp_blocks;
+		std::vector<char> batch_temp_ready;
+		std::vector<std::vector<double>> complex_scratch;
+		std::vector<int32_t> variable_slots;
+	private:
+		void CountBatchUses(Ast_Expression* expr);
+		void EvaluateBlock(Ast_Expression* expr, const double* xs, double* out, size_t count, size_t depth, double* const* frame = nullptr);
+		void EvaluateNode(Ast_Expression* expr, const double* xs, double* out, size_t count, size_t depth, double* const* frame);
+		double* Scratch(size_t depth);
+		void EvaluateComplexBlock(Ast_Expression* expr, const double* re, const double* im, double* out_re, double* out_im, size_t count, size_t depth, double* const* frame = nullptr);
+		double* ComplexScratch(size_t depth);
+		double Variable(Ast_Identifier* ident) const;
+		//The expression assigned to a global name, null for locals, inputs and unknown names
+		Ast_Expression* Definition(Ast_Identifier* ident) const;
+
+		template <typename T, typename Seed>
+		friend struct DefinitionLeaf;
 	};
 }
 
-#endif // !INTERPRETER_H
+#endif // !INTERPRETER_H
\ No newline at end of file
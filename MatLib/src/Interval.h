@@ -0,0 +1,153 @@
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include "Kernels.h"
+
+#include <cmath>
+#include <cfloat>
+
+namespace MatLib {
+	//Closed range [lo, hi] that is guaranteed to hold the exact real result, every operation rounds its bounds outward by one ulp
+	struct Interval {
+		double lo = 0.0;
+		double hi = 0.0;
+
+		Interval() = default;
+		Interval(double value) : lo(value), hi(value) { }
+		Interval(double lo, double hi) : lo(lo), hi(hi) { }
+
+		bool Contains(double value) const { return lo <= value && value <= hi; }
+		bool IsEntire() const { return lo == -HUGE_VAL && hi == HUGE_VAL; }
+		double Width() const { return hi - lo; }
+		double Mid() const { return 0.5 * lo + 0.5 * hi; }
+
+		static Interval Entire() { return Interval(-HUGE_VAL, HUGE_VAL); }
+	};
+
+	inline double RoundDown(double value) { return std::nextafter(value, -HUGE_VAL); }
+	inline double RoundUp(double value) { return std::nextafter(value, HUGE_VAL); }
+
+	//A NaN bound means the result is undefined somewhere in the range, so nothing can be ruled out
+	inline Interval Outward(double lo, double hi, int ulps = 1) {
+		if (std::isnan(lo) || std::isnan(hi))
+			return Interval::Entire();
+		for (int i = 0; i < ulps; i++) {
+			lo = RoundDown(lo);
+			hi = RoundUp(hi);
+		}
+		return Interval(lo, hi);
+	}
+
+	//0 * inf is taken as 0 since the infinite bound is never actually reached
+	inline double IntervalProduct(double a, double b) { return (a == 0.0 || b == 0.0) ? 0.0 : a * b; }
+
+	inline Interval operator-(const Interval& a) { return Interval(-a.hi, -a.lo); }
+	inline Interval operator+(const Interval& a, const Interval& b) { return Outward(a.lo + b.lo, a.hi + b.hi); }
+	inline Interval operator-(const Interval& a, const Interval& b) { return Outward(a.lo - b.hi, a.hi - b.lo); }
+
+	inline Interval operator*(const Interval& a, const Interval& b) {
+		double p0 = IntervalProduct(a.lo, b.lo), p1 = IntervalProduct(a.lo, b.hi);
+		double p2 = IntervalProduct(a.hi, b.lo), p3 = IntervalProduct(a.hi, b.hi);
+		return Outward(fmin(fmin(p0, p1), fmin(p2, p3)), fmax(fmax(p0, p1), fmax(p2, p3)));
+	}
+
+	inline Interval operator/(const Interval& a, const Interval& b) {
+		if (b.Contains(0.0) || std::isnan(b.lo) || std::isnan(b.hi))
+			return Interval::Entire();
+		double q0 = a.lo / b.lo, q1 = a.lo / b.hi, q2 = a.hi / b.lo, q3 = a.hi / b.hi;
+		return Outward(fmin(fmin(q0, q1), fmin(q2, q3)), fmax(fmax(q0, q1), fmax(q2, q3)));
+	}
+
+	//pow is not correctly rounded by every libm, so its bounds are widened by two ulps instead of one
+	inline Interval Pow(const Interval& a, const Interval& b) {
+		if (std::isnan(a.lo) || std::isnan(a.hi) || std::isnan(b.lo) || std::isnan(b.hi))
+			return Interval::Entire();
+
+		//Integer exponents keep negative bases defined, even powers fold the base onto |x|
+		if (b.lo == b.hi && b.lo == floor(b.lo) && fabs(b.lo) < 9007199254740992.0) {
+			double n = fabs(b.lo);
+			if (n == 0.0)
+				return Interval(1.0);
+
+			Interval p;
+			if (fmod(n, 2.0) == 0.0) {
+				double low = (a.lo > 0.0) ? a.lo : ((a.hi < 0.0) ? -a.hi : 0.0);
+				p = Outward(pow(low, n), pow(fmax(fabs(a.lo), fabs(a.hi)), n), 2);
+				p.lo = fmax(p.lo, 0.0);
+			}
+			else
+				p = Outward(pow(a.lo, n), pow(a.hi, n), 2);
+			return (b.lo < 0.0) ? Interval(1.0) / p : p;
+		}
+
+		//Real exponents are only defined for x >= 0, where pow is monotone in each argument so the corners bound it
+		if (a.hi < 0.0)
+			return Interval::Entire();
+		double x0 = fmax(a.lo, 0.0);
+		double c0 = pow(x0, b.lo), c1 = pow(x0, b.hi), c2 = pow(a.hi, b.lo), c3 = pow(a.hi, b.hi);
+		Interval p = Outward(fmin(fmin(c0, c1), fmin(c2, c3)), fmax(fmax(c0, c1), fmax(c2, c3)), 2);
+		p.lo = fmax(p.lo, 0.0);
+		return p;
+	}
+
+	//True when [lo, hi] may hold phase + 2 pi n for some integer n. The slack only ever turns a miss into a hit
+	inline bool Reaches(const Interval& a, double phase) {
+		const double period = 6.283185307179586;
+		double n = ceil((a.lo - phase) / period - 1e-9);
+		return phase + n * period <= a.hi + 1e-9 * (1.0 + fabs(a.hi));
+	}
+
+	//The built-in kernels are within one ulp, so their bounds are widened by two. Between the ends a wave can only go
+	//further where the range reaches one of its peaks, wide or huge ranges are simply [-1, 1]
+	inline Interval Periodic(const Interval& a, double (*f)(double), double peak) {
+		if (std::isnan(a.lo) || std::isnan(a.hi))
+			return Interval::Entire();
+		if (a.hi - a.lo >= 6.283185307179586 || fabs(a.lo) > 1e6 || fabs(a.hi) > 1e6)
+			return Interval(-1.0, 1.0);
+
+		double flo = f(a.lo), fhi = f(a.hi);
+		Interval p = Outward(fmin(flo, fhi), fmax(flo, fhi), 2);
+		if (Reaches(a, peak))
+			p.hi = 1.0;
+		if (Reaches(a, peak + 3.141592653589793))
+			p.lo = -1.0;
+		return Interval(fmax(p.lo, -1.0), fmin(p.hi, 1.0));
+	}
+
+	inline Interval Sin(const Interval& a) { return Periodic(a, Kernels::Sin, 1.5707963267948966); }
+	inline Interval Cos(const Interval& a) { return Periodic(a, Kernels::Cos, 0.0); }
+
+	inline Interval Exp(const Interval& a) {
+		Interval p = Outward(Kernels::Exp(a.lo), Kernels::Exp(a.hi), 2);
+		p.lo = fmax(p.lo, 0.0);
+		return p;
+	}
+
+	//Undefined below zero, so a range reaching there rules nothing out
+	inline Interval Log(const Interval& a) {
+		if (!(a.lo >= 0.0))
+			return Interval::Entire();
+		return Outward(Kernels::Log(a.lo), Kernels::Log(a.hi), 2);
+	}
+
+	inline Interval Sqrt(const Interval& a) {
+		if (!(a.lo >= 0.0))
+			return Interval::Entire();
+		Interval p = Outward(sqrt(a.lo), sqrt(a.hi));
+		p.lo = fmax(p.lo, 0.0);
+		return p;
+	}
+
+	//Same shape as Pow, widened further by the kernel's error, which grows by an ulp for every 16 of |b ln a| = |ln a^b|
+	inline Interval Power(const Interval& a, const Interval& b) {
+		Interval p = Pow(a, b);
+		if (p.IsEntire())
+			return p;
+		double reach = fmax(fabs(log(fmax(fabs(p.lo), DBL_MIN))), fabs(log(fmax(fabs(p.hi), DBL_MIN))));
+		Interval q = Outward(p.lo, p.hi, 2 + (int)(fmin(reach, 710.0) / 16.0));
+		q.lo = (p.lo >= 0.0) ? fmax(q.lo, 0.0) : q.lo;
+		return q;
+	}
+}
+
+#endif // !INTERVAL_H
\ No newline at end of file
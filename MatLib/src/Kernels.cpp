@@ -0,0 +1,583 @@
+#include "Kernels.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//The block kernels must match the scalar ones bit for bit, and TwoSum and TwoProduct need every rounding step, so a
+//multiply and an add are never fused into one
+#if defined(_MSC_VER)
+	#pragma fp_contract(off)
+#elif defined(__clang__)
+	#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+	#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define MATLIB_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define MATLIB_SSE2
+#endif
+
+namespace MatLib {
+	namespace Kernels {
+		//The tail of every ComplexDiv, max and the reciprocal match the vector lanes
+		static void ComplexDivScalar(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count) {
+			for (size_t i = 0; i < count; i++) {
+				double s = 1.0 / fmax(fabs(br[i]), fabs(bi[i]));
+				double c = br[i] * s, d = bi[i] * s;
+				double r = s / (c * c + d * d);
+				double re = (ar[i] * c + ai[i] * d) * r, im = (ai[i] * c - ar[i] * d) * r;
+				out_re[i] = re;
+				out_im[i] = im;
+			}
+		}
+
+#if defined(MATLIB_AVX2)
+		#define KERNEL_BINARY(name, intrinsic, op) \
+			void name(const double* a, const double* b, double* out, size_t count) { \
+				size_t i = 0; \
+				for (; i + 4 <= count; i += 4) \
+					_mm256_storeu_pd(out + i, intrinsic(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))); \
+				for (; i < count; i++) \
+					out[i] = a[i] op b[i]; \
+			}
+
+		KERNEL_BINARY(Add, _mm256_add_pd, +)
+		KERNEL_BINARY(Sub, _mm256_sub_pd, -)
+		KERNEL_BINARY(Mul, _mm256_mul_pd, *)
+		KERNEL_BINARY(Div, _mm256_div_pd, /)
+
+		void Negate(const double* in, double* out, size_t count) {
+			const __m256d sign = _mm256_set1_pd(-0.0);
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+				_mm256_storeu_pd(out + i, _mm256_xor_pd(_mm256_loadu_pd(in + i), sign));
+			for (; i < count; i++)
+				out[i] = -in[i];
+		}
+
+		void Fill(double* out, double value, size_t count) {
+			const __m256d v = _mm256_set1_pd(value);
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+				_mm256_storeu_pd(out + i, v);
+			for (; i < count; i++)
+				out[i] = value;
+		}
+
+		void ComplexMul(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count) {
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m256d a = _mm256_loadu_pd(ar + i), b = _mm256_loadu_pd(ai + i), c = _mm256_loadu_pd(br + i), d = _mm256_loadu_pd(bi + i);
+				_mm256_storeu_pd(out_re + i, _mm256_sub_pd(_mm256_mul_pd(a, c), _mm256_mul_pd(b, d)));
+				_mm256_storeu_pd(out_im + i, _mm256_add_pd(_mm256_mul_pd(a, d), _mm256_mul_pd(b, c)));
+			}
+			for (; i < count; i++) {
+				double re = ar[i] * br[i] - ai[i] * bi[i], im = ar[i] * bi[i] + ai[i] * br[i];
+				out_re[i] = re;
+				out_im[i] = im;
+			}
+		}
+
+		void ComplexDiv(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count) {
+			const __m256d sign = _mm256_set1_pd(-0.0), one = _mm256_set1_pd(1.0);
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4) {
+				__m256d a = _mm256_loadu_pd(ar + i), b = _mm256_loadu_pd(ai + i), c = _mm256_loadu_pd(br + i), d = _mm256_loadu_pd(bi + i);
+				__m256d s = _mm256_div_pd(one, _mm256_max_pd(_mm256_andnot_pd(sign, c), _mm256_andnot_pd(sign, d)));
+				c = _mm256_mul_pd(c, s);
+				d = _mm256_mul_pd(d, s);
+				__m256d r = _mm256_div_pd(s, _mm256_add_pd(_mm256_mul_pd(c, c), _mm256_mul_pd(d, d)));
+				_mm256_storeu_pd(out_re + i, _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(a, c), _mm256_mul_pd(b, d)), r));
+				_mm256_storeu_pd(out_im + i, _mm256_mul_pd(_mm256_sub_pd(_mm256_mul_pd(b, c), _mm256_mul_pd(a, d)), r));
+			}
+			ComplexDivScalar(ar + i, ai + i, br + i, bi + i, out_re + i, out_im + i, count - i);
+		}
+
+		const char* InstructionSet() { return "AVX2"; }
+#elif defined(MATLIB_SSE2)
+		#define KERNEL_BINARY(name, intrinsic, op) \
+			void name(const double* a, const double* b, double* out, size_t count) { \
+				size_t i = 0; \
+				for (; i + 2 <= count; i += 2) \
+					_mm_storeu_pd(out + i, intrinsic(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i))); \
+				for (; i < count; i++) \
+					out[i] = a[i] op b[i]; \
+			}
+
+		KERNEL_BINARY(Add, _mm_add_pd, +)
+		KERNEL_BINARY(Sub, _mm_sub_pd, -)
+		KERNEL_BINARY(Mul, _mm_mul_pd, *)
+		KERNEL_BINARY(Div, _mm_div_pd, /)
+
+		void Negate(const double* in, double* out, size_t count) {
+			const __m128d sign = _mm_set1_pd(-0.0);
+			size_t i = 0;
+			for (; i + 2 <= count; i += 2)
+				_mm_storeu_pd(out + i, _mm_xor_pd(_mm_loadu_pd(in + i), sign));
+			for (; i < count; i++)
+				out[i] = -in[i];
+		}
+
+		void Fill(double* out, double value, size_t count) {
+			const __m128d v = _mm_set1_pd(value);
+			size_t i = 0;
+			for (; i + 2 <= count; i += 2)
+				_mm_storeu_pd(out + i, v);
+			for (; i < count; i++)
+				out[i] = value;
+		}
+
+		void ComplexMul(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count) {
+			size_t i = 0;
+			for (; i + 2 <= count; i += 2) {
+				__m128d a = _mm_loadu_pd(ar + i), b = _mm_loadu_pd(ai + i), c = _mm_loadu_pd(br + i), d = _mm_loadu_pd(bi + i);
+				_mm_storeu_pd(out_re + i, _mm_sub_pd(_mm_mul_pd(a, c), _mm_mul_pd(b, d)));
+				_mm_storeu_pd(out_im + i, _mm_add_pd(_mm_mul_pd(a, d), _mm_mul_pd(b, c)));
+			}
+			for (; i < count; i++) {
+				double re = ar[i] * br[i] - ai[i] * bi[i], im = ar[i] * bi[i] + ai[i] * br[i];
+				out_re[i] = re;
+				out_im[i] = im;
+			}
+		}
+
+		void ComplexDiv(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count) {
+			const __m128d sign = _mm_set1_pd(-0.0), one = _mm_set1_pd(1.0);
+			size_t i = 0;
+			for (; i + 2 <= count; i += 2) {
+				__m128d a = _mm_loadu_pd(ar + i), b = _mm_loadu_pd(ai + i), c = _mm_loadu_pd(br + i), d = _mm_loadu_pd(bi + i);
+				__m128d s = _mm_div_pd(one, _mm_max_pd(_mm_andnot_pd(sign, c), _mm_andnot_pd(sign, d)));
+				c = _mm_mul_pd(c, s);
+				d = _mm_mul_pd(d, s);
+				__m128d r = _mm_div_pd(s, _mm_add_pd(_mm_mul_pd(c, c), _mm_mul_pd(d, d)));
+				_mm_storeu_pd(out_re + i, _mm_mul_pd(_mm_add_pd(_mm_mul_pd(a, c), _mm_mul_pd(b, d)), r));
+				_mm_storeu_pd(out_im + i, _mm_mul_pd(_mm_sub_pd(_mm_mul_pd(b, c), _mm_mul_pd(a, d)), r));
+			}
+			ComplexDivScalar(ar + i, ai + i, br + i, bi + i, out_re + i, out_im + i, count - i);
+		}
+
+		const char* InstructionSet() { return "SSE2"; }
+#else
+		#define KERNEL_BINARY(name, intrinsic, op) \
+			void name(const double* a, const double* b, double* out, size_t count) { \
+				for (size_t i = 0; i < count; i++) \
+					out[i] = a[i] op b[i]; \
+			}
+
+		KERNEL_BINARY(Add, _, +)
+		KERNEL_BINARY(Sub, _, -)
+		KERNEL_BINARY(Mul, _, *)
+		KERNEL_BINARY(Div, _, /)
+
+		void Negate(const double* in, double* out, size_t count) {
+			for (size_t i = 0; i < count; i++)
+				out[i] = -in[i];
+		}
+
+		void Fill(double* out, double value, size_t count) {
+			for (size_t i = 0; i < count; i++)
+				out[i] = value;
+		}
+
+		void ComplexMul(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count) {
+			for (size_t i = 0; i < count; i++) {
+				double re = ar[i] * br[i] - ai[i] * bi[i], im = ar[i] * bi[i] + ai[i] * br[i];
+				out_re[i] = re;
+				out_im[i] = im;
+			}
+		}
+
+		void ComplexDiv(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count) {
+			ComplexDivScalar(ar, ai, br, bi, out_re, out_im, count);
+		}
+
+		const char* InstructionSet() { return "Scalar"; }
+#endif
+		#undef KERNEL_BINARY
+
+		void Pow(const double* a, const double* b, double* out, size_t count) {
+			for (size_t i = 0; i < count; i++)
+				out[i] = pow(a[i], b[i]);
+		}
+
+		void Copy(const double* in, double* out, size_t count) {
+			if (in != out)
+				memmove(out, in, count * sizeof(double));
+		}
+
+		//Lane helpers for the elementary functions. Each kernel is written once against these and instantiated for the
+		//widest vector the build allows and for plain double, so the scalar and block paths round identically
+		namespace Lane {
+			template <typename V> V Splat(double value);
+
+			inline uint64_t Bits(double value) {
+				uint64_t bits;
+				memcpy(&bits, &value, sizeof(double));
+				return bits;
+			}
+
+			inline double FromBits(uint64_t bits) {
+				double value;
+				memcpy(&value, &bits, sizeof(double));
+				return value;
+			}
+
+			template <> inline double Splat<double>(double value) { return value; }
+			inline double Load(const double* in, double) { return *in; }
+			inline void Store(double* out, double value) { *out = value; }
+			inline double Add(double a, double b) { return a + b; }
+			inline double Sub(double a, double b) { return a - b; }
+			inline double Mul(double a, double b) { return a * b; }
+			inline double Div(double a, double b) { return a / b; }
+			inline double Sqrt(double a) { return sqrt(a); }
+			inline double And(double a, double b) { return FromBits(Bits(a) & Bits(b)); }
+			inline double Or(double a, double b) { return FromBits(Bits(a) | Bits(b)); }
+			inline double Xor(double a, double b) { return FromBits(Bits(a) ^ Bits(b)); }
+			inline double LessEqual(double a, double b) { return FromBits((a <= b) ? ~0ull : 0ull); }
+			inline double Select(double mask, double a, double b) { return (Bits(mask)) ? a : b; }
+			inline double AddBits(double a, double b) { return FromBits(Bits(a) + Bits(b)); }
+			inline double SubBits(double a, double b) { return FromBits(Bits(a) - Bits(b)); }
+			template <int N> inline double ShiftLeft(double a) { return FromBits(Bits(a) << N); }
+			template <int N> inline double ShiftRight(double a) { return FromBits(Bits(a) >> N); }
+			inline bool All(double mask) { return Bits(mask) != 0; }
+
+#if defined(MATLIB_AVX2)
+			typedef __m256d Vector;
+			constexpr size_t WIDTH = 4;
+
+			template <> inline __m256d Splat<__m256d>(double value) { return _mm256_set1_pd(value); }
+			inline __m256d Load(const double* in, __m256d) { return _mm256_loadu_pd(in); }
+			inline void Store(double* out, __m256d value) { _mm256_storeu_pd(out, value); }
+			inline __m256d Add(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+			inline __m256d Sub(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+			inline __m256d Mul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+			inline __m256d Div(__m256d a, __m256d b) { return _mm256_div_pd(a, b); }
+			inline __m256d Sqrt(__m256d a) { return _mm256_sqrt_pd(a); }
+			inline __m256d And(__m256d a, __m256d b) { return _mm256_and_pd(a, b); }
+			inline __m256d Or(__m256d a, __m256d b) { return _mm256_or_pd(a, b); }
+			inline __m256d Xor(__m256d a, __m256d b) { return _mm256_xor_pd(a, b); }
+			inline __m256d LessEqual(__m256d a, __m256d b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+			inline __m256d Select(__m256d mask, __m256d a, __m256d b) { return _mm256_blendv_pd(b, a, mask); }
+			inline __m256d AddBits(__m256d a, __m256d b) { return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_castpd_si256(a), _mm256_castpd_si256(b))); }
+			inline __m256d SubBits(__m256d a, __m256d b) { return _mm256_castsi256_pd(_mm256_sub_epi64(_mm256_castpd_si256(a), _mm256_castpd_si256(b))); }
+			template <int N> inline __m256d ShiftLeft(__m256d a) { return _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(a), N)); }
+			template <int N> inline __m256d ShiftRight(__m256d a) { return _mm256_castsi256_pd(_mm256_srli_epi64(_mm256_castpd_si256(a), N)); }
+			inline bool All(__m256d mask) { return _mm256_movemask_pd(mask) == 0xF; }
+#elif defined(MATLIB_SSE2)
+			typedef __m128d Vector;
+			constexpr size_t WIDTH = 2;
+
+			template <> inline __m128d Splat<__m128d>(double value) { return _mm_set1_pd(value); }
+			inline __m128d Load(const double* in, __m128d) { return _mm_loadu_pd(in); }
+			inline void Store(double* out, __m128d value) { _mm_storeu_pd(out, value); }
+			inline __m128d Add(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+			inline __m128d Sub(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+			inline __m128d Mul(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+			inline __m128d Div(__m128d a, __m128d b) { return _mm_div_pd(a, b); }
+			inline __m128d Sqrt(__m128d a) { return _mm_sqrt_pd(a); }
+			inline __m128d And(__m128d a, __m128d b) { return _mm_and_pd(a, b); }
+			inline __m128d Or(__m128d a, __m128d b) { return _mm_or_pd(a, b); }
+			inline __m128d Xor(__m128d a, __m128d b) { return _mm_xor_pd(a, b); }
+			inline __m128d LessEqual(__m128d a, __m128d b) { return _mm_cmple_pd(a, b); }
+			inline __m128d Select(__m128d mask, __m128d a, __m128d b) { return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b)); }
+			inline __m128d AddBits(__m128d a, __m128d b) { return _mm_castsi128_pd(_mm_add_epi64(_mm_castpd_si128(a), _mm_castpd_si128(b))); }
+			inline __m128d SubBits(__m128d a, __m128d b) { return _mm_castsi128_pd(_mm_sub_epi64(_mm_castpd_si128(a), _mm_castpd_si128(b))); }
+			template <int N> inline __m128d ShiftLeft(__m128d a) { return _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(a), N)); }
+			template <int N> inline __m128d ShiftRight(__m128d a) { return _mm_castsi128_pd(_mm_srli_epi64(_mm_castpd_si128(a), N)); }
+			inline bool All(__m128d mask) { return _mm_movemask_pd(mask) == 0x3; }
+#else
+			typedef double Vector;
+			constexpr size_t WIDTH = 1;
+#endif
+
+			//Adding 1.5 * 2^52 rounds to the nearest integer and leaves it in the low mantissa bits, where the bit
+			//tricks below read it without a float to integer conversion
+			constexpr double ROUND = 0x1.8p52;
+
+			//Exact sum a + b = hi + lo, for any ordering of the magnitudes
+			template <typename V>
+			inline void TwoSum(V a, V b, V& hi, V& lo) {
+				hi = Add(a, b);
+				V bb = Sub(hi, a);
+				lo = Add(Sub(a, Sub(hi, bb)), Sub(b, bb));
+			}
+
+			//Exact product a * b = hi + lo by Veltkamp splitting, which needs no fused multiply add
+			template <typename V>
+			inline void TwoProduct(V a, V b, V& hi, V& lo) {
+				const V split = Splat<V>(134217729.0);
+				V ca = Mul(split, a), cb = Mul(split, b);
+				V ah = Sub(ca, Sub(ca, a)), bh = Sub(cb, Sub(cb, b));
+				V al = Sub(a, ah), bl = Sub(b, bh);
+				hi = Mul(a, b);
+				lo = Add(Add(Add(Sub(Mul(ah, bh), hi), Mul(ah, bl)), Mul(al, bh)), Mul(al, bl));
+			}
+
+			//fdlibm's rational approximation of e^r for |r| <= ln2 / 2, where r = hi - lo and lo carries the bits of the
+			//reduction that did not fit in hi
+			template <typename V>
+			inline V ExpReduced(V hi, V lo) {
+				V r = Sub(hi, lo);
+				V z = Mul(r, r);
+				V p = Add(Splat<V>(-1.65339022054652515390e-06), Mul(z, Splat<V>(4.13813679705723846039e-08)));
+				p = Add(Splat<V>(6.61375632143793436117e-05), Mul(z, p));
+				p = Add(Splat<V>(-2.77777777770155933842e-03), Mul(z, p));
+				p = Add(Splat<V>(1.66666666666666019037e-01), Mul(z, p));
+				V c = Sub(r, Mul(z, p));
+				V q = Div(Mul(r, c), Sub(Splat<V>(2.0), c));
+				return Sub(Splat<V>(1.0), Sub(Sub(lo, q), hi));
+			}
+
+			//Multiplies by 2^k, where k sits in the low bits of rounded, for results that stay normal
+			template <typename V>
+			inline V Scale(V value, V rounded) {
+				return AddBits(value, ShiftLeft<52>(rounded));
+			}
+
+			//e^x = 2^k * e^r with x = k ln2 + r, ln2 is split so k * LN2_HI is exact
+			constexpr double LN2_HI = 0x1.62e42feep-1;
+			constexpr double LN2_LO = 0x1.a39ef35793c76p-33;
+			constexpr double INV_LN2 = 0x1.71547652b82fep0;
+
+			template <typename V>
+			inline V Exp(V x) {
+				V rounded = Add(Mul(x, Splat<V>(INV_LN2)), Splat<V>(ROUND));
+				V k = Sub(rounded, Splat<V>(ROUND));
+				V hi = Sub(x, Mul(k, Splat<V>(LN2_HI)));
+				V lo = Mul(k, Splat<V>(LN2_LO));
+				return Scale(ExpReduced(hi, lo), rounded);
+			}
+
+			template <typename V>
+			inline V ExpDomain(V x) {
+				const V limit = Splat<V>(708.0);
+				return And(LessEqual(x, limit), LessEqual(Splat<V>(-708.0), x));
+			}
+
+			//Splits a positive normal x into 2^k * (1 + f) with sqrt(2) / 2 <= 1 + f < sqrt(2), k exact as a double
+			template <typename V>
+			inline void Decompose(V x, V& k, V& f) {
+				const V one = Splat<V>(1.0);
+				const V two52 = Splat<V>(0x1p52);
+				V m = Or(And(x, Splat<V>(FromBits(0x000fffffffffffffull))), one);
+				V big = LessEqual(Splat<V>(0x1.6a09e667f3bcdp0), m);
+				m = Select(big, Mul(m, Splat<V>(0.5)), m);
+				k = Sub(Or(ShiftRight<52>(x), two52), Add(two52, Splat<V>(1023.0)));
+				k = Add(k, And(big, one));
+				f = Sub(m, one);
+			}
+
+			//fdlibm's ln(1 + f) = f - f^2 / 2 + s (f^2 / 2 + R) with s = f / (2 + f), returns s and R = R(s^2)
+			template <typename V>
+			inline V LogSeries(V f, V& s) {
+				s = Div(f, Add(Splat<V>(2.0), f));
+				V z = Mul(s, s);
+				V w = Mul(z, z);
+				V t1 = Mul(w, Add(Splat<V>(3.999999999940941908e-01), Mul(w, Add(Splat<V>(2.222219843214978396e-01), Mul(w, Splat<V>(1.531383769920937332e-01))))));
+				V t2 = Add(Splat<V>(2.857142874366239149e-01), Mul(w, Add(Splat<V>(1.818357216161805012e-01), Mul(w, Splat<V>(1.479819860511658591e-01)))));
+				t2 = Mul(z, Add(Splat<V>(6.666666666666735130e-01), Mul(w, t2)));
+				return Add(t2, t1);
+			}
+
+			template <typename V>
+			inline V Log(V x) {
+				V k, f, s;
+				Decompose(x, k, f);
+				V hfsq = Mul(Splat<V>(0.5), Mul(f, f));
+				V tail = Mul(s, Add(hfsq, LogSeries(f, s)));
+				return Sub(Mul(k, Splat<V>(LN2_HI)), Sub(Sub(hfsq, Add(tail, Mul(k, Splat<V>(LN2_LO)))), f));
+			}
+
+			template <typename V>
+			inline V LogDomain(V x) {
+				return And(LessEqual(Splat<V>(DBL_MIN), x), LessEqual(x, Splat<V>(DBL_MAX)));
+			}
+
+			//a^b = e^(b ln a) with ln a carried as a double-double to about 2^-59, so the error grows only slowly with b.
+			//The f^2 / 2 and s (f^2 / 2) terms are exact products and the rounding of s is corrected to first order, the
+			//correction only needs 1 / (2 + f) to a few bits so a short series stands in for a second division.
+			//domain is cleared for negative bases, zeros, infinities and products outside the range of e^x, libm takes those
+			template <typename V>
+			inline V Power(V a, V b, V& domain) {
+				V k, f, s;
+				Decompose(a, k, f);
+				V r = LogSeries(f, s);
+				V square, square_lo;
+				TwoProduct(f, f, square, square_lo);
+				V hfsq = Mul(Splat<V>(0.5), square);
+
+				V d = Add(Splat<V>(2.0), f);
+				V d_lo = Add(Sub(Splat<V>(2.0), d), f);
+				V q, q_lo;
+				TwoProduct(s, d, q, q_lo);
+				V half_f = Mul(Splat<V>(0.5), f);
+				V inverse = Mul(Splat<V>(0.5), Sub(Splat<V>(1.0), Mul(half_f, Sub(Splat<V>(1.0), half_f))));
+				V ds = Mul(Sub(Sub(Sub(f, q), q_lo), Mul(s, d_lo)), inverse);
+
+				V head, head_lo, cube, cube_lo, sum, sum_lo;
+				TwoSum(f, Sub(Splat<V>(0.0), hfsq), head, head_lo);
+				TwoProduct(s, hfsq, cube, cube_lo);
+				V small = Sub(head_lo, Mul(Mul(Splat<V>(0.5), square_lo), Sub(Splat<V>(1.0), s)));
+				small = Add(Mul(s, r), Add(cube_lo, Add(Mul(ds, Add(hfsq, Mul(Splat<V>(3.0), r))), small)));
+				TwoSum(head, cube, sum, sum_lo);
+				small = Add(small, sum_lo);
+				V log_hi, log_lo;
+				TwoSum(Mul(k, Splat<V>(LN2_HI)), sum, log_hi, sum_lo);
+				small = Add(small, Add(sum_lo, Mul(k, Splat<V>(LN2_LO))));
+				TwoSum(log_hi, small, log_hi, log_lo);
+
+				V p, p_lo;
+				TwoProduct(b, log_hi, p, p_lo);
+				p_lo = Add(p_lo, Mul(b, log_lo));
+				domain = And(And(LogDomain(a), ExpDomain(p)), LessEqual(Mul(b, b), Splat<V>(1e300)));
+
+				V rounded = Add(Mul(p, Splat<V>(INV_LN2)), Splat<V>(ROUND));
+				V n = Sub(rounded, Splat<V>(ROUND));
+				V hi = Sub(p, Mul(n, Splat<V>(LN2_HI)));
+				V lo = Sub(Mul(n, Splat<V>(LN2_LO)), p_lo);
+				return Scale(ExpReduced(hi, lo), rounded);
+			}
+
+			//pi / 2 split in 33 bit pieces so k times each of the first three is exact for k < 2^20
+			constexpr double PIO2_1 = 0x1.921fb544p0;
+			constexpr double PIO2_2 = 0x1.0b4611a6p-34;
+			constexpr double PIO2_3 = 0x1.3198a2ep-69;
+			constexpr double PIO2_3T = 0x1.b839a252049c1p-104;
+			constexpr double INV_PIO2 = 0x1.45f306dc9c883p-1;
+
+			//fdlibm's sin and cos kernels on [-pi/4, pi/4], y is the tail of the reduced argument
+			template <typename V>
+			inline V SinReduced(V x, V y) {
+				V z = Mul(x, x);
+				V v = Mul(z, x);
+				V r = Add(Splat<V>(-2.50507602534068634195e-08), Mul(z, Splat<V>(1.58969099521155010221e-10)));
+				r = Add(Splat<V>(2.75573137070700676789e-06), Mul(z, r));
+				r = Add(Splat<V>(-1.98412698298579493134e-04), Mul(z, r));
+				r = Add(Splat<V>(8.33333333332248946124e-03), Mul(z, r));
+				V t = Sub(Mul(z, Sub(Mul(Splat<V>(0.5), y), Mul(v, r))), y);
+				return Sub(x, Sub(t, Mul(v, Splat<V>(-1.66666666666666324348e-01))));
+			}
+
+			template <typename V>
+			inline V CosReduced(V x, V y) {
+				V z = Mul(x, x);
+				V w = Mul(z, z);
+				V r = Mul(z, Add(Splat<V>(4.16666666666666019037e-02), Mul(z, Add(Splat<V>(-1.38888888888741095749e-03), Mul(z, Splat<V>(2.48015872894767294178e-05))))));
+				V r2 = Add(Splat<V>(-2.75573143513906633035e-07), Mul(z, Add(Splat<V>(2.08757232129817482790e-09), Mul(z, Splat<V>(-1.13596475577881948265e-11)))));
+				r = Add(r, Mul(Mul(w, w), r2));
+				V hz = Mul(Splat<V>(0.5), z);
+				const V one = Splat<V>(1.0);
+				w = Sub(one, hz);
+				return Add(w, Add(Sub(Sub(one, w), hz), Sub(Mul(z, r), Mul(x, y))));
+			}
+
+			//sin(x + quadrant pi / 2), so cos is the same kernel one quadrant on. The parity of k picks the polynomial
+			//and its second bit the sign, both read straight from the rounded bits
+			template <typename V>
+			inline V SinQuadrant(V x, uint64_t quadrant) {
+				V rounded = Add(Mul(x, Splat<V>(INV_PIO2)), Splat<V>(ROUND));
+				V k = Sub(rounded, Splat<V>(ROUND));
+				V w = Sub(x, Mul(k, Splat<V>(PIO2_1)));
+				V hi, lo;
+				TwoSum(w, Xor(Mul(k, Splat<V>(PIO2_2)), Splat<V>(-0.0)), hi, lo);
+				lo = Sub(lo, Add(Mul(k, Splat<V>(PIO2_3)), Mul(k, Splat<V>(PIO2_3T))));
+				V r = Add(hi, lo);
+				V r_lo = Add(Sub(hi, r), lo);
+
+				V q = AddBits(rounded, Splat<V>(FromBits(quadrant)));
+				V odd = SubBits(Splat<V>(0.0), And(q, Splat<V>(FromBits(1))));
+				V sign = And(ShiftLeft<62>(q), Splat<V>(-0.0));
+				return Xor(Select(odd, CosReduced(r, r_lo), SinReduced(r, r_lo)), sign);
+			}
+
+			template <typename V>
+			inline V SinDomain(V x) {
+				return And(LessEqual(x, Splat<V>(1e6)), LessEqual(Splat<V>(-1e6), x));
+			}
+
+			template <typename V> inline V Sin(V x) { return SinQuadrant(x, 0); }
+			template <typename V> inline V Cos(V x) { return SinQuadrant(x, 1); }
+		}
+
+		//Whole vectors go through the kernel, a vector with any lane outside the kernel's domain is redone lane by lane
+		//by the scalar function, which falls back to libm for exactly those lanes
+		#define KERNEL_UNARY(name, domain, fallback) \
+			double name(double x) { \
+				return (Lane::All(Lane::domain(x))) ? Lane::name(x) : fallback(x); \
+			} \
+			void name(const double* in, double* out, size_t count) { \
+				size_t i = 0; \
+				for (; i + Lane::WIDTH <= count; i += Lane::WIDTH) { \
+					Lane::Vector x = Lane::Load(in + i, Lane::Vector()); \
+					if (Lane::All(Lane::domain(x))) { \
+						Lane::Store(out + i, Lane::name(x)); \
+						continue; \
+					} \
+					for (size_t j = i; j < i + Lane::WIDTH; j++) \
+						out[j] = name(in[j]); \
+				} \
+				for (; i < count; i++) \
+					out[i] = name(in[i]); \
+			}
+
+		KERNEL_UNARY(Sin, SinDomain, sin)
+		KERNEL_UNARY(Cos, SinDomain, cos)
+		KERNEL_UNARY(Exp, ExpDomain, exp)
+		KERNEL_UNARY(Log, LogDomain, log)
+		#undef KERNEL_UNARY
+
+		double Sqrt(double x) {
+			return sqrt(x);
+		}
+
+		void Sqrt(const double* in, double* out, size_t count) {
+			size_t i = 0;
+			for (; i + Lane::WIDTH <= count; i += Lane::WIDTH)
+				Lane::Store(out + i, Lane::Sqrt(Lane::Load(in + i, Lane::Vector())));
+			for (; i < count; i++)
+				out[i] = sqrt(in[i]);
+		}
+
+		double Power(double a, double b) {
+			double domain = 0.0;
+			double value = Lane::Power(a, b, domain);
+			return (Lane::All(domain)) ? value : pow(a, b);
+		}
+
+		void Power(const double* a, const double* b, double* out, size_t count) {
+			size_t i = 0;
+			for (; i + Lane::WIDTH <= count; i += Lane::WIDTH) {
+				Lane::Vector domain;
+				Lane::Vector value = Lane::Power(Lane::Load(a + i, Lane::Vector()), Lane::Load(b + i, Lane::Vector()), domain);
+				if (Lane::All(domain)) {
+					Lane::Store(out + i, value);
+					continue;
+				}
+				for (size_t j = i; j < i + Lane::WIDTH; j++)
+					out[j] = Power(a[j], b[j]);
+			}
+			for (; i < count; i++)
+				out[i] = Power(a[i], b[i]);
+		}
+
+		//e^re (cos im + i sin im) from the real block kernels, a chunk at a time so the outputs can alias the inputs
+		void ComplexExp(const double* re, const double* im, double* out_re, double* out_im, size_t count) {
+			const size_t CHUNK = 256;
+			double e[CHUNK], c[CHUNK], s[CHUNK];
+			for (size_t i = 0; i < count; i += CHUNK) {
+				size_t n = (count - i < CHUNK) ? count - i : CHUNK;
+				Exp(re + i, e, n);
+				Cos(im + i, c, n);
+				Sin(im + i, s, n);
+				Mul(e, c, out_re + i, n);
+				Mul(e, s, out_im + i, n);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+
+namespace MatLib {
+	namespace Kernels {
+		void Fill(double* out, double value, size_t count);
+		void Copy(const double* in, double* out, size_t count);
+		void Negate(const double* in, double* out, size_t count);
+		void Add(const double* a, const double* b, double* out, size_t count);
+		void Sub(const double* a, const double* b, double* out, size_t count);
+		void Mul(const double* a, const double* b, double* out, size_t count);
+		void Div(const double* a, const double* b, double* out, size_t count);
+		void Pow(const double* a, const double* b, double* out, size_t count);
+
+		//Elementary functions from polynomial kernels with argument reduction. The scalar and block forms run the same
+		//arithmetic, so a value never depends on which path computed it. Worst errors measured against a long double
+		//reference: sin and cos 0.78 ulp for |x| <= 1e6, exp 0.91 ulp, log 0.82 ulp, sqrt correctly rounded, pow 0.93 ulp
+		//while |b ln a| <= 8 and about 1 + |b ln a| / 32 ulp beyond. Arguments outside a kernel's range (huge angles,
+		//non-positive bases, overflow, NaN) are handed to libm
+		double Sin(double x);
+		double Cos(double x);
+		double Exp(double x);
+		double Log(double x);
+		double Sqrt(double x);
+		double Power(double a, double b);
+		void Sin(const double* in, double* out, size_t count);
+		void Cos(const double* in, double* out, size_t count);
+		void Exp(const double* in, double* out, size_t count);
+		void Log(const double* in, double* out, size_t count);
+		void Sqrt(const double* in, double* out, size_t count);
+		void Power(const double* a, const double* b, double* out, size_t count);
+
+		//Complex values as split real and imaginary arrays, the outputs may alias the first operand. Each runs the same
+		//steps as the matching Complex operator or function, so the batch and scalar complex paths agree to the bit
+		void ComplexMul(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count);
+		void ComplexDiv(const double* ar, const double* ai, const double* br, const double* bi, double* out_re, double* out_im, size_t count);
+		void ComplexExp(const double* re, const double* im, double* out_re, double* out_im, size_t count);
+
+		const char* InstructionSet();
+	}
+}
+
+#endif // !KERNELS_H
\ No newline at end of file
@@ -1,136 +1,179 @@
 #include "Lexer.h"
 #include "Logger.h"
+#include "Interner.h"
 
-namespace MatLib {
-	Lexer::Lexer() { 
-		symbols[Tok::T_LTE] = "<=";
-		symbols[Tok::T_GTE] = ">=";
-		symbols[Tok::T_DOUBLE_EQUAL] = "==";
-		symbols[Tok::T_NOT] = "!=";
-	}
-
-	void Lexer::Input(const std::string& input) {
-		this->input = input;
-	}
-
-	void Lexer::CreateToken(int type) {
-		tokens.push_back(Token());
-		tokens.back().type = type;
-		tokens.back().line = current_line;
-	}
-	
-	void Lexer::Run() {
-		current_character = 0;
-		current_line = 1;
-		while (current_character < input.size()) {
-			if (input[current_character] == '\n') {
-				current_line++;
-				current_character++;
-				CreateToken(Tok::T_NEWLINE);
-				continue;
-			}
-
-			working += input[current_character];
-
-
-			if (current_possible_token_type == TokenCategories::NONE) {	//Don't know what the current character could be
-				if (isdigit(working.back()))
-					current_possible_token_type = TokenCategories::NUMERIC;
-				else if (isalpha(working.back())) 
-					current_possible_token_type = TokenCategories::ID;
-				else if (working.back() != ' ')
-					current_possible_token_type = TokenCategories::SYMBOL;
-			}
+#include <cstdlib>
+#include <cstring>
 
-			if (current_possible_token_type == TokenCategories::NUMERIC && (Limit() || !IsDigit(1))) {
-				CreateToken(Tok::T_NUM_CONST);
-				tokens.back().num_const = atoi(working.c_str());
-				ResetStatus();
-			}
-			else if (current_possible_token_type == TokenCategories::ID && (Limit() || !IsCharacter(1) || NextChar() == ' ')) {
-				std::string temp = SpaceLess();
-				uint32_t offset = 0;
-				offset = ReadTill(temp, [&]() {
-					return (!Limit() && IsCharacter(1) && NextChar() != ' ');
-				});
-				if (Search(temp, keywords)) continue;
-				else {
-					CreateToken(Tok::T_IDENTIFIER);
-					tokens.back().id = working;
-					ResetStatus();
-				}
-			}
-			else if (current_possible_token_type == TokenCategories::SYMBOL) {
-				std::string temp = SpaceLess();
-				uint32_t offset = ReadTill(temp, [&]() {
-					return (!Limit() && IsSymbol(1) && NextChar() != ' ');
-				});
-				if (Search(temp, symbols)) continue;
-				else {
-					CreateToken(working[0]);
-					tokens.back().id = working;
-					current_character -= offset;
-					ResetStatus();
-				}
+namespace MatLib {
+	enum : uint8_t {
+		CHAR_OTHER,
+		CHAR_SPACE,
+		CHAR_NEWLINE,
+		CHAR_DIGIT,
+		CHAR_ALPHA,
+		CHAR_SYMBOL
+	};
+
+	struct CharTable {
+		uint8_t classes[256] = { 0 };
+
+		constexpr CharTable() {
+			for (int c = 0; c < 256; c++) {
+				if (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f')
+					classes[c] = CHAR_SPACE;
+				else if (c == '\n')
+					classes[c] = CHAR_NEWLINE;
+				else if (c >= '0' && c <= '9')
+					classes[c] = CHAR_DIGIT;
+				else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_')
+					classes[c] = CHAR_ALPHA;
+				else if (c > ' ' && c < 127)
+					classes[c] = CHAR_SYMBOL;
 			}
-
-			current_character++;
 		}
+	};
 
-		CreateToken(Tok::T_EOF);
-		ResetStatus();
-	}
+	static constexpr CharTable CHAR_TABLE;
 
-	bool Lexer::Search(const std::string& possible, Searchable& search) {
-		for (auto& s : search) {
-			if (s.second == possible) {
-				CreateToken(s.first);
-				current_character++;
-				ResetStatus();
-				return true;
-			}
-		}
-		return false;
+	static inline uint8_t CharClass(char c) {
+		return CHAR_TABLE.classes[(uint8_t)c];
 	}
 
-	char Lexer::NextChar() {
-		return input[(current_character + 1) % input.size()];
+	Lexer::Lexer() { 
+		RegisterSymbol("<=", Tok::T_LTE);
+		RegisterSymbol(">=", Tok::T_GTE);
+		RegisterSymbol("==", Tok::T_DOUBLE_EQUAL);
+		RegisterSymbol("!=", Tok::T_NOT);
 	}
 
-	bool Lexer::IsDigit(uint32_t offset) {
-		return (isdigit(input[current_character + offset]));
+	//Only symbols of two or more characters are stored, single characters are already their own token type
+	bool Lexer::RegisterSymbol(std::string_view symbol, int type) {
+		return symbol.size() > 1 && symbols.Insert(symbol, type);
 	}
 
-	bool Lexer::IsCharacter(uint32_t offset) {
-		return (isalpha(input[current_character + offset]));
+	bool Lexer::RegisterKeyword(std::string_view keyword, int type) {
+		return keywords.Insert(keyword, type);
 	}
 
-	bool Lexer::IsSymbol(uint32_t offset) {
-		return (!IsDigit(offset) && !IsCharacter(offset));
+	void Lexer::Input(const std::string& input) {
+		this->input = input;
+		tokens.clear();
 	}
 
-	bool Lexer::Limit() {
-		return (current_character + 1 == input.size());
+	static inline void CreateToken(std::vector<Token>& tokens, int type, uint32_t line, const char* begin, const char* end) {
+		tokens.emplace_back();
+		tokens.back().type = type;
+		tokens.back().line = line;
+		tokens.back().text = std::string_view(begin, end - begin);
 	}
 
-	void Lexer::ResetStatus() {
-		current_possible_token_type = TokenCategories::NONE;
-		working.clear();
+	void Lexer::Run() {
+		tokens.clear();
+		Scan(input, 1, tokens);
 	}
 
-	uint32_t Lexer::ReadTill(std::string& temp, const std::function<bool(void)>& condition) {
-		uint32_t offset = 0;
-		while (condition()) {
-			temp += input[current_character + 1];
-			current_character++;
-			offset++;
+	//One pass over source driven by the character class table, tokens only reference source so nothing is copied.
+	//Appends to tokens and always ends with T_EOF, which lets the editor re-lex single lines
+	void Lexer::Scan(std::string_view source, uint32_t line, std::vector<Token>& tokens) const {
+		const char* p = source.data();
+		const char* end = p + source.size();
+
+		while (p < end) {
+			const char* start = p;
+			switch (CharClass(*p)) {
+			case CHAR_SPACE:
+				p++;
+				break;
+			case CHAR_NEWLINE:
+				//Numbered like the line after it, as the original lexer did, so parser errors keep their line numbers
+				CreateToken(tokens, Tok::T_NEWLINE, ++line, start, ++p);
+				break;
+			case CHAR_OTHER:
+				//Control characters and bytes outside ASCII, taking the byte as the type would make 0xFF read as T_EOF
+				EMBER_LOG_ERROR("Unexpected character 0x%02X on line %d.", (uint8_t)*p, line);
+				CreateToken(tokens, Tok::T_UNKNOWN, line, start, ++p);
+				break;
+			case CHAR_DIGIT: {
+				while (p < end && CharClass(*p) == CHAR_DIGIT)
+					p++;
+				if (p + 1 < end && *p == '.' && CharClass(p[1]) == CHAR_DIGIT) {
+					p++;
+					while (p < end && CharClass(*p) == CHAR_DIGIT)
+						p++;
+				}
+				if (p < end && (*p == 'e' || *p == 'E')) {
+					const char* exponent = p + 1;
+					if (exponent < end && (*exponent == '+' || *exponent == '-'))
+						exponent++;
+					if (exponent < end && CharClass(*exponent) == CHAR_DIGIT) {
+						p = exponent;
+						while (p < end && CharClass(*p) == CHAR_DIGIT)
+							p++;
+					}
+				}
+				CreateToken(tokens, Tok::T_NUM_CONST, line, start, p);
+				tokens.back().num_const = ParseNumber(start, p);
+				break;
+			}
+			case CHAR_ALPHA: {
+				while (p < end && (CharClass(*p) == CHAR_ALPHA || CharClass(*p) == CHAR_DIGIT))
+					p++;
+				std::string_view name(start, p - start);
+				int keyword = (keywords.Size()) ? keywords.Find(name) : 0;
+				CreateToken(tokens, (keyword) ? keyword : Tok::T_IDENTIFIER, line, start, p);
+				if (!keyword)
+					tokens.back().symbol = Interner::Global().Intern(name);
+				break;
+			}
+			default: {
+				//Longest match first, every length is a single perfect hash probe
+				size_t longest = 1;
+				while (longest < symbols.MaxLength() && p + longest < end && CharClass(p[longest]) == CHAR_SYMBOL)
+					longest++;
+				int symbol = 0;
+				for (; longest > 1; longest--)
+					if ((symbol = symbols.Find(std::string_view(start, longest))) != 0)
+						break;
+				if (symbol) {
+					p += longest;
+					CreateToken(tokens, symbol, line, start, p);
+					break;
+				}
+				p++;
+				CreateToken(tokens, (uint8_t)*start, line, start, p);
+				break;
+			}
+			}
 		}
-		return offset;
+
+		CreateToken(tokens, Tok::T_EOF, line, end, end);
 	}
 
-	std::string Lexer::SpaceLess() {
-		working.erase(std::remove_if(working.begin(), working.end(), isspace), working.end());	
-		return working;
+	//Up to 15 significant digits and a power of ten up to 22 are both exact doubles, so one multiply or divide is correctly
+	//rounded. Anything longer goes through strtod on a stack copy
+	double Lexer::ParseNumber(const char* begin, const char* end) {
+		uint64_t mantissa = 0;
+		int digits = 0, scale = 0;
+		const char* p = begin;
+		for (; p < end && CharClass(*p) == CHAR_DIGIT; p++, digits++)
+			mantissa = mantissa * 10 + (*p - '0');
+		if (p < end && *p == '.')
+			for (p++; p < end && CharClass(*p) == CHAR_DIGIT; p++, digits++, scale--)
+				mantissa = mantissa * 10 + (*p - '0');
+
+		static const double POWERS[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+		if (p == end && digits <= 15 && scale >= -22)
+			return (scale < 0) ? (double)mantissa / POWERS[-scale] : (double)mantissa;
+
+		char buffer[128];
+		size_t length = end - begin;
+		if (length >= sizeof(buffer))
+			return strtod(std::string(begin, end).c_str(), nullptr);
+		memcpy(buffer, begin, length);
+		buffer[length] = '\0';
+		return strtod(buffer, nullptr);
 	}
 
 	void Lexer::Log() {
@@ -146,12 +189,11 @@ namespace MatLib {
 	}
 
 	std::string Lexer::DecodeToken(Token* token) {
-		if (token->type > 255 && token->type != Tok::T_IDENTIFIER && token->type != Tok::T_NUM_CONST) {
-			return symbols[token->type];
-		}
+		if (token->type == Tok::T_NEWLINE)
+			return "";
+		if (token->type > 255 && token->type != Tok::T_NUM_CONST)
+			return std::string(token->text);
 		switch (token->type) {
-		case Tok::T_IDENTIFIER:
-			return token->id;
 		case Tok::T_NUM_CONST:
 			return std::to_string(token->num_const);
 		default:
@@ -3,9 +3,10 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
-#include <functional>
+
+#include "PerfectHash.h"
 
 namespace MatLib {
     namespace Tok {
@@ -29,6 +30,7 @@ namespace MatLib {
             T_LARROW = '<',
             T_RARROW = '>',
             T_COMMA = ',',
+            T_SEMICOLON = ';',
 
             T_EOF = 255,      
 
@@ -39,61 +41,46 @@ namespace MatLib {
             T_NOT,
             T_GTE,
             T_NEWLINE,
+            T_UNKNOWN,
         };
     }
 
+    //text points into the lexer's input, so tokens are only valid until the next Input()
     struct Token {
         int type = 0;
         uint32_t line = 0;
 
         double num_const = 0.0;
-        std::string id = "";
+        std::string_view text;
+        uint32_t symbol = 0;
     };
 
     class Lexer {
     public:
-        using Searchable = std::unordered_map<int, std::string>;
         Lexer();
 
         void Input(const std::string& input);
         void Run();
+        void Scan(std::string_view source, uint32_t line, std::vector<Token>& tokens) const;
         void Log();
         void Clear() { tokens.clear(); }
         std::string DecodeToken(Token* token);
         std::vector<Token>& Tokens() { return tokens; }
+        const std::string& Source() const { return input; }
 
-        Searchable& Symbols() { return symbols; }
-        Searchable& Keywords() { return keywords; }
-
-        bool Search(const std::string& possible, Searchable& search);
+        //Register before Run, each call rebuilds its table so lookups stay collision free
+        bool RegisterSymbol(std::string_view symbol, int type);
+        bool RegisterKeyword(std::string_view keyword, int type);
+        const PerfectHash& Symbols() const { return symbols; }
+        const PerfectHash& Keywords() const { return keywords; }
     private:
-        enum class TokenCategories {
-            NONE,
-            NUMERIC,
-            ID,
-            SYMBOL
-        };
-
         std::string input;
         std::vector<Token> tokens;
 
-        TokenCategories current_possible_token_type = TokenCategories::NONE;
-        std::string working;
-
-        std::unordered_map<int, std::string> symbols;
-        std::unordered_map<int, std::string> keywords;
-        uint32_t current_character = 0;
-        uint32_t current_line = 0;
+        PerfectHash symbols;
+        PerfectHash keywords;
     private:
-        void CreateToken(int type);
-        char NextChar();
-        bool IsDigit(uint32_t offset = 0);
-        bool IsCharacter(uint32_t offset = 0);
-        bool IsSymbol(uint32_t offset = 0);
-        bool Limit();
-        void ResetStatus();
-        std::string SpaceLess();
-        uint32_t ReadTill(std::string& temp, const std::function<bool(void)>& condition);
+        static double ParseNumber(const char* begin, const char* end);
     };
 }
 
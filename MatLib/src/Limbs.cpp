@@ -0,0 +1,509 @@
+#include "Limbs.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace MatLib {
+	namespace Limbs {
+		void Trim(Natural& a) {
+			while (!a.empty() && a.back() == 0)
+				a.pop_back();
+		}
+
+		int Compare(const Natural& a, const Natural& b) {
+			if (a.size() != b.size())
+				return (a.size() < b.size()) ? -1 : 1;
+			for (size_t i = a.size(); i-- > 0;)
+				if (a[i] != b[i])
+					return (a[i] < b[i]) ? -1 : 1;
+			return 0;
+		}
+
+		//out += a, the carry runs on through the rest of out
+		static void AddAt(uint32_t* out, size_t n, const uint32_t* a, size_t na) {
+			uint64_t carry = 0;
+			size_t i = 0;
+			for (; i < na; i++) {
+				carry += (uint64_t)out[i] + a[i];
+				out[i] = (uint32_t)carry;
+				carry >>= 32;
+			}
+			for (; carry && i < n; i++) {
+				carry += out[i];
+				out[i] = (uint32_t)carry;
+				carry >>= 32;
+			}
+		}
+
+		//out -= a, callers guarantee out >= a
+		static void SubAt(uint32_t* out, size_t n, const uint32_t* a, size_t na) {
+			int64_t borrow = 0;
+			size_t i = 0;
+			for (; i < na; i++) {
+				int64_t d = (int64_t)out[i] - a[i] - borrow;
+				borrow = (d < 0) ? 1 : 0;
+				out[i] = (uint32_t)d;
+			}
+			for (; borrow && i < n; i++) {
+				borrow = (out[i] == 0) ? 1 : 0;
+				out[i]--;
+			}
+		}
+
+		Natural Add(const Natural& a, const Natural& b) {
+			const Natural& longer = (a.size() >= b.size()) ? a : b;
+			const Natural& shorter = (a.size() >= b.size()) ? b : a;
+			Natural sum(longer.size() + 1, 0);
+			std::copy(longer.begin(), longer.end(), sum.begin());
+			AddAt(sum.data(), sum.size(), shorter.data(), shorter.size());
+			Trim(sum);
+			return sum;
+		}
+
+		Natural Sub(const Natural& a, const Natural& b) {
+			Natural difference = a;
+			SubAt(difference.data(), difference.size(), b.data(), b.size());
+			Trim(difference);
+			return difference;
+		}
+
+		Natural Multiply(const Natural& a, const Natural& b) {
+			if (a.empty() || b.empty())
+				return Natural();
+			Natural product(a.size() + b.size());
+			Multiply(a.data(), a.size(), b.data(), b.size(), product.data());
+			Trim(product);
+			return product;
+		}
+
+		Natural ShiftLeft(const Natural& a, size_t bits) {
+			if (a.empty())
+				return a;
+			size_t limbs = bits / 32, shift = bits % 32;
+			Natural shifted(a.size() + limbs + 1, 0);
+			for (size_t i = 0; i < a.size(); i++) {
+				uint64_t v = (uint64_t)a[i] << shift;
+				shifted[i + limbs] |= (uint32_t)v;
+				shifted[i + limbs + 1] |= (uint32_t)(v >> 32);
+			}
+			Trim(shifted);
+			return shifted;
+		}
+
+		size_t BitLength(const Natural& a) {
+			if (a.empty())
+				return 0;
+			size_t bits = 32 * (a.size() - 1);
+			for (uint32_t top = a.back(); top; top >>= 1)
+				bits++;
+			return bits;
+		}
+
+		void MultiplySmall(Natural& a, uint32_t m, uint32_t carry) {
+			uint64_t c = carry;
+			for (auto& limb : a) {
+				c += (uint64_t)limb * m;
+				limb = (uint32_t)c;
+				c >>= 32;
+			}
+			if (c)
+				a.push_back((uint32_t)c);
+			Trim(a);
+		}
+
+		uint32_t DivideSmall(Natural& a, uint32_t d) {
+			uint64_t remainder = 0;
+			for (size_t i = a.size(); i-- > 0;) {
+				uint64_t v = (remainder << 32) | a[i];
+				a[i] = (uint32_t)(v / d);
+				remainder = v % d;
+			}
+			Trim(a);
+			return (uint32_t)remainder;
+		}
+
+		Natural ShiftRight(const Natural& a, size_t bits) {
+			size_t limbs = bits / 32, shift = bits % 32;
+			if (limbs >= a.size())
+				return Natural();
+			Natural shifted(a.size() - limbs);
+			for (size_t i = 0; i < shifted.size(); i++) {
+				uint64_t v = a[i + limbs];
+				if (i + limbs + 1 < a.size())
+					v |= (uint64_t)a[i + limbs + 1] << 32;
+				shifted[i] = (uint32_t)(v >> shift);
+			}
+			Trim(shifted);
+			return shifted;
+		}
+
+		Natural FromUint64(uint64_t value) {
+			Natural n = { (uint32_t)value, (uint32_t)(value >> 32) };
+			Trim(n);
+			return n;
+		}
+
+		//Nine digits per short division, so the cost is quadratic in the length but with a small constant
+		std::string ToDecimal(const Natural& a) {
+			if (a.empty())
+				return "0";
+			std::vector<uint32_t> chunks;
+			Natural n = a;
+			while (!n.empty())
+				chunks.push_back(DivideSmall(n, 1000000000));
+
+			std::string text = std::to_string(chunks.back());
+			char digits[16];
+			for (size_t i = chunks.size() - 1; i-- > 0;) {
+				snprintf(digits, sizeof(digits), "%09u", chunks[i]);
+				text += digits;
+			}
+			return text;
+		}
+
+		static int LeadingZeros(uint32_t x) {
+			int n = 0;
+			for (; n < 32 && !(x & 0x80000000u); x <<= 1)
+				n++;
+			return n;
+		}
+
+		void DivMod(const Natural& a, const Natural& b, Natural& quotient, Natural& remainder) {
+			if (Compare(a, b) < 0) {
+				quotient.clear();
+				remainder = a;
+				return;
+			}
+			if (b.size() == 1) {
+				quotient = a;
+				remainder = FromUint64(DivideSmall(quotient, b[0]));
+				return;
+			}
+
+			//Normalize so the divisor's top bit is set, then every trial quotient is off by at most two
+			size_t n = b.size(), m = a.size() - n;
+			int s = LeadingZeros(b.back());
+			Natural v = ShiftLeft(b, s), u = ShiftLeft(a, s);
+			u.resize(a.size() + 1, 0);
+			quotient.assign(m + 1, 0);
+
+			for (size_t j = m + 1; j-- > 0;) {
+				uint64_t numerator = ((uint64_t)u[j + n] << 32) | u[j + n - 1];
+				uint64_t qhat = numerator / v[n - 1], rhat = numerator % v[n - 1];
+				while (qhat > 0xFFFFFFFFull || qhat * v[n - 2] > ((rhat << 32) | u[j + n - 2])) {
+					qhat--;
+					rhat += v[n - 1];
+					if (rhat > 0xFFFFFFFFull)
+						break;
+				}
+
+				int64_t borrow = 0, t = 0;
+				for (size_t i = 0; i < n; i++) {
+					uint64_t p = qhat * v[i];
+					t = (int64_t)u[i + j] - borrow - (int64_t)(p & 0xFFFFFFFF);
+					u[i + j] = (uint32_t)t;
+					borrow = (int64_t)(p >> 32) - (t >> 32);
+				}
+				t = (int64_t)u[j + n] - borrow;
+				u[j + n] = (uint32_t)t;
+
+				if (t < 0) {
+					qhat--;
+					uint64_t carry = 0;
+					for (size_t i = 0; i < n; i++) {
+						carry += (uint64_t)u[i + j] + v[i];
+						u[i + j] = (uint32_t)carry;
+						carry >>= 32;
+					}
+					u[j + n] += (uint32_t)carry;
+				}
+				quotient[j] = (uint32_t)qhat;
+			}
+
+			u.resize(n);
+			Trim(u);
+			remainder = ShiftRight(u, s);
+			Trim(quotient);
+		}
+
+		//a / b for b known to divide a, a single limb divisor skips the long division
+		Natural Quotient(const Natural& a, const Natural& b) {
+			if (b.size() == 1) {
+				Natural q = a;
+				if (b[0] != 1)
+					DivideSmall(q, b[0]);
+				return q;
+			}
+			Natural q, r;
+			DivMod(a, b, q, r);
+			return q;
+		}
+
+		//Newton's x = (x + a / x) / 2 from above, stops at the first step that does not decrease
+		Natural SquareRoot(const Natural& a) {
+			if (a.empty())
+				return a;
+			Natural x = ShiftLeft(Natural{ 1 }, (BitLength(a) + 1) / 2 + 1);
+			for (;;) {
+				Natural q, r;
+				DivMod(a, x, q, r);
+				Natural y = Add(x, q);
+				y = ShiftRight(y, 1);
+				if (Compare(y, x) >= 0)
+					return x;
+				x = y;
+			}
+		}
+
+		//Stein's algorithm, shifts and subtractions only
+		uint64_t Gcd(uint64_t a, uint64_t b) {
+			if (a == 0)
+				return b;
+			if (b == 0)
+				return a;
+			int shift = 0;
+			while (!((a | b) & 1)) {
+				a >>= 1;
+				b >>= 1;
+				shift++;
+			}
+			while (!(a & 1))
+				a >>= 1;
+			do {
+				while (!(b & 1))
+					b >>= 1;
+				if (a > b)
+					std::swap(a, b);
+				b -= a;
+			} while (b);
+			return a << shift;
+		}
+
+		//|x| * a - |y| * b or the other way round, Lehmer cofactors always have opposite signs and a non-negative result
+		static Natural Combine(const Natural& a, int64_t x, const Natural& b, int64_t y) {
+			Natural p = a, q = b;
+			MultiplySmall(p, (uint32_t)((x < 0) ? -x : x));
+			MultiplySmall(q, (uint32_t)((y < 0) ? -y : y));
+			if (x < 0 || p.empty())
+				return Sub(q, p);
+			return Sub(p, q);
+		}
+
+		//Bits [top - 32, top) of a, where top is the bit length of the larger operand
+		static uint64_t Leading(const Natural& a, size_t top) {
+			uint64_t v = 0;
+			for (size_t bit = top; bit-- > top - 32;) {
+				size_t limb = bit / 32;
+				v = (v << 1) | ((limb < a.size()) ? ((a[limb] >> (bit % 32)) & 1) : 0);
+			}
+			return v;
+		}
+
+		Natural Gcd(const Natural& x, const Natural& y) {
+			Natural a = x, b = y;
+			if (Compare(a, b) < 0)
+				std::swap(a, b);
+
+			while (b.size() > 2) {
+				size_t top = BitLength(a);
+				int64_t u = (int64_t)Leading(a, top), v = (int64_t)Leading(b, top);
+				int64_t A = 1, B = 0, C = 0, D = 1;
+				while (v + C > 0 && v + D > 0) {
+					int64_t q = (u + A) / (v + C);
+					if (q != (u + B) / (v + D))
+						break;
+					int64_t t = A - q * C;
+					A = C;
+					C = t;
+					t = B - q * D;
+					B = D;
+					D = t;
+					t = u - q * v;
+					u = v;
+					v = t;
+				}
+
+				if (B == 0) {
+					Natural q, r;
+					DivMod(a, b, q, r);
+					a.swap(b);
+					b.swap(r);
+				}
+				else {
+					Natural next_a = Combine(a, A, b, B), next_b = Combine(a, C, b, D);
+					a.swap(next_a);
+					b.swap(next_b);
+				}
+			}
+
+			if (b.empty())
+				return a;
+			Natural q, r;
+			DivMod(a, b, q, r);
+			auto word = [](const Natural& n) { return (n.empty()) ? 0 : (n.size() == 1) ? (uint64_t)n[0] : ((uint64_t)n[1] << 32) | n[0]; };
+			return FromUint64(Gcd(word(b), word(r)));
+		}
+
+		void MultiplySchool(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+			std::fill(out, out + na + nb, 0);
+			for (size_t i = 0; i < na; i++) {
+				uint64_t carry = 0, m = a[i];
+				for (size_t j = 0; j < nb; j++) {
+					carry += m * b[j] + out[i + j];
+					out[i + j] = (uint32_t)carry;
+					carry >>= 32;
+				}
+				out[i + nb] = (uint32_t)carry;
+			}
+		}
+
+		//One level of a1 a0 * b1 b0 = z2 B^2m + z1 B^m + z0 with z1 = (a0 + a1)(b0 + b1) - z0 - z2, the three
+		//half-size products go back through Multiply so each picks its own algorithm
+		void MultiplyKaratsuba(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+			if (na < nb) {
+				std::swap(a, b);
+				std::swap(na, nb);
+			}
+			if (nb == 0) {
+				std::fill(out, out + na, 0);
+				return;
+			}
+
+			//Lopsided operands are cut into slices as long as the shorter one
+			if (2 * nb <= na) {
+				std::fill(out, out + na + nb, 0);
+				std::vector<uint32_t> part(2 * nb);
+				for (size_t i = 0; i < na; i += nb) {
+					size_t n = std::min(nb, na - i);
+					Multiply(a + i, n, b, nb, part.data());
+					AddAt(out + i, na + nb - i, part.data(), n + nb);
+				}
+				return;
+			}
+
+			size_t m = (na + 1) / 2;
+			Multiply(a, m, b, m, out);
+			Multiply(a + m, na - m, b + m, nb - m, out + 2 * m);
+
+			std::vector<uint32_t> sa(m + 1, 0), sb(m + 1, 0), middle(2 * m + 2);
+			std::copy(a, a + m, sa.begin());
+			AddAt(sa.data(), m + 1, a + m, na - m);
+			std::copy(b, b + m, sb.begin());
+			AddAt(sb.data(), m + 1, b + m, nb - m);
+			Multiply(sa.data(), m + 1, sb.data(), m + 1, middle.data());
+			SubAt(middle.data(), middle.size(), out, 2 * m);
+			SubAt(middle.data(), middle.size(), out + 2 * m, na + nb - 2 * m);
+
+			size_t used = middle.size();
+			while (used > 0 && middle[used - 1] == 0)
+				used--;
+			AddAt(out + m, na + nb - m, middle.data(), used);
+		}
+
+		//Twiddles for every level up to the largest transform so far, level h (a power of two) keeps
+		//e^(-pi i j / h) for j < h at [h, 2h) so each butterfly pass reads them in order
+		static void Twiddles(size_t n, const double*& cosines, const double*& sines) {
+			thread_local std::vector<double> cos_table, sin_table;
+			if (cos_table.size() < n) {
+				cos_table.assign(n, 1.0);
+				sin_table.assign(n, 0.0);
+				const double PI = 3.14159265358979323846264338327950;
+				for (size_t half = 1; half < n; half <<= 1) {
+					for (size_t j = 0; j < half; j++) {
+						cos_table[half + j] = cos(PI * (double)j / (double)half);
+						sin_table[half + j] = -sin(PI * (double)j / (double)half);
+					}
+				}
+			}
+			cosines = cos_table.data();
+			sines = sin_table.data();
+		}
+
+		static void Transform(double* re, double* im, size_t n) {
+			for (size_t i = 1, j = 0; i < n; i++) {
+				size_t bit = n >> 1;
+				for (; j & bit; bit >>= 1)
+					j ^= bit;
+				j ^= bit;
+				if (i < j) {
+					std::swap(re[i], re[j]);
+					std::swap(im[i], im[j]);
+				}
+			}
+
+			const double* cosines = nullptr;
+			const double* sines = nullptr;
+			Twiddles(n, cosines, sines);
+			for (size_t half = 1; half < n; half <<= 1) {
+				const double* wr = cosines + half;
+				const double* wi = sines + half;
+				for (size_t i = 0; i < n; i += 2 * half) {
+					double* ur = re + i;
+					double* ui = im + i;
+					double* vr = re + i + half;
+					double* vi = im + i + half;
+					for (size_t j = 0; j < half; j++) {
+						double tr = vr[j] * wr[j] - vi[j] * wi[j];
+						double ti = vr[j] * wi[j] + vi[j] * wr[j];
+						vr[j] = ur[j] - tr;
+						vi[j] = ui[j] - ti;
+						ur[j] += tr;
+						ui[j] += ti;
+					}
+				}
+			}
+		}
+
+		//a rides in the real part and b in the imaginary part, so one forward transform serves both operands
+		void MultiplyFFT(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+			size_t pieces = 2 * (na + nb), n = 1;
+			while (n < pieces)
+				n <<= 1;
+
+			std::vector<double> re(n, 0.0), im(n, 0.0);
+			for (size_t i = 0; i < na; i++) {
+				re[2 * i] = (double)(a[i] & 0xFFFF);
+				re[2 * i + 1] = (double)(a[i] >> 16);
+			}
+			for (size_t i = 0; i < nb; i++) {
+				im[2 * i] = (double)(b[i] & 0xFFFF);
+				im[2 * i + 1] = (double)(b[i] >> 16);
+			}
+			Transform(re.data(), im.data(), n);
+
+			//A[k] = (C[k] + conj C[-k]) / 2 and B[k] = (C[k] - conj C[-k]) / 2i, the product is conjugated
+			//so the inverse transform can reuse the forward one
+			std::vector<double> pr(n), pi(n);
+			for (size_t k = 0; k < n; k++) {
+				size_t j = (n - k) & (n - 1);
+				double ar = 0.5 * (re[k] + re[j]), ai = 0.5 * (im[k] - im[j]);
+				double br = 0.5 * (im[k] + im[j]), bi = -0.5 * (re[k] - re[j]);
+				pr[k] = ar * br - ai * bi;
+				pi[k] = -(ar * bi + ai * br);
+			}
+			Transform(pr.data(), pi.data(), n);
+
+			uint64_t carry = 0;
+			double scale = 1.0 / (double)n;
+			for (size_t i = 0; i < na + nb; i++) {
+				carry += (uint64_t)llround(pr[2 * i] * scale);
+				uint32_t low = (uint32_t)(carry & 0xFFFF);
+				carry >>= 16;
+				carry += (uint64_t)llround(pr[2 * i + 1] * scale);
+				out[i] = low | (uint32_t)((carry & 0xFFFF) << 16);
+				carry >>= 16;
+			}
+		}
+
+		void Multiply(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+			size_t shorter = std::min(na, nb);
+			if (shorter < KARATSUBA_THRESHOLD)
+				MultiplySchool(a, na, b, nb, out);
+			else if (shorter >= FFT_THRESHOLD && 2 * (na + nb) <= FFT_MAX_POINTS)
+				MultiplyFFT(a, na, b, nb, out);
+			else
+				MultiplyKaratsuba(a, na, b, nb, out);
+		}
+	}
+}
\ No newline at end of file
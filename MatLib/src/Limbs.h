@@ -0,0 +1,53 @@
+#ifndef LIMBS_H
+#define LIMBS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace MatLib {
+	//Little-endian base 2^32 digits without leading zero limbs, so zero is the empty vector
+	typedef std::vector<uint32_t> Natural;
+
+	//Lengths in limbs of the shorter operand, measured on the product benchmark. The FFT splits limbs into 16-bit
+	//pieces and stays exact while the transform has at most 2^16 points, longer products recurse through Karatsuba
+	constexpr size_t KARATSUBA_THRESHOLD = 32;
+	constexpr size_t FFT_THRESHOLD = 1536;
+	constexpr size_t FFT_MAX_POINTS = 1 << 16;
+
+	namespace Limbs {
+		void Trim(Natural& a);
+		int Compare(const Natural& a, const Natural& b);
+		Natural Add(const Natural& a, const Natural& b);
+		Natural Sub(const Natural& a, const Natural& b);
+		Natural Multiply(const Natural& a, const Natural& b);
+		Natural ShiftLeft(const Natural& a, size_t bits);
+		Natural ShiftRight(const Natural& a, size_t bits);
+		size_t BitLength(const Natural& a);
+		Natural FromUint64(uint64_t value);
+		std::string ToDecimal(const Natural& a);
+
+		//Knuth's algorithm D, b may not be zero
+		void DivMod(const Natural& a, const Natural& b, Natural& quotient, Natural& remainder);
+		Natural Quotient(const Natural& a, const Natural& b);
+		Natural SquareRoot(const Natural& a);
+
+		//Lehmer steps on the leading 32 bits while the smaller operand is longer than 64 bits, binary GCD after
+		Natural Gcd(const Natural& a, const Natural& b);
+		uint64_t Gcd(uint64_t a, uint64_t b);
+
+		//a = a * m + carry, and a = a / d returning the remainder
+		void MultiplySmall(Natural& a, uint32_t m, uint32_t carry = 0);
+		uint32_t DivideSmall(Natural& a, uint32_t d);
+
+		//out holds na + nb limbs and may not overlap either input. Multiply picks the algorithm, the others are
+		//exposed so the benchmark can time each one on the same operands
+		void Multiply(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out);
+		void MultiplySchool(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out);
+		void MultiplyKaratsuba(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out);
+		void MultiplyFFT(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out);
+	}
+}
+
+#endif // !LIMBS_H
\ No newline at end of file
@@ -7,6 +7,13 @@
 #include "Lexer.h"
 #include "Parser.h"
 #include "FunctionSolver.h"
+#include "Optimizer.h"
+#include "HashCons.h"
+#include "Differentiator.h"
+#include "Plotter.h"
+#include "Benchmark.h"
+#include "Document.h"
+#include "ProgramCache.h"
 
 #include <examples/imgui_impl_opengl3.h>
 #include <examples/imgui_impl_sdl.h>
@@ -14,6 +21,16 @@
 #define WINDOW_WIDTH 1280
 #define WINDOW_HEIGHT 720
 
+//Lets the editor grow the string instead of writing into a fixed buffer
+static int ResizeSource(ImGuiInputTextCallbackData* data) {
+	if (data->EventFlag == ImGuiInputTextFlags_CallbackResize) {
+		std::string* source = (std::string*)data->UserData;
+		source->resize(data->BufTextLen);
+		data->Buf = &(*source)[0];
+	}
+	return 0;
+}
+
 class Sandbox : public Ember::Application {
 public:
 	void OnCreate() {
@@ -69,13 +86,11 @@ public:
 		colors[ImGuiCol_TitleBgActive] = ImVec4{ 0.15f, 0.1505f, 0.151f, 1.0f };
 		colors[ImGuiCol_TitleBgCollapsed] = ImVec4{ 0.15f, 0.1505f, 0.151f, 1.0f };
 		window->SetResizeable(true);
-
-
-		memset(in, 0, 512);
 	}
 
 	virtual ~Sandbox() {
 		delete fb;
+		delete domain_texture;
 	}
 
 	void OnUserUpdate(float delta) {
@@ -87,6 +102,19 @@ public:
 
 		q->Update(renderer);
 
+		plotter.SetView(CameraView());
+		plotter.Update((cap_samples) ? (uint32_t)samples_per_frame : 0);
+		plotter.Draw(renderer);
+
+		auto& domain = plotter.Domain();
+		if (domain_coloring && domain.Sample() && !domain.Pixels().empty()) {
+			if (!domain_texture || domain_texture->GetWidth() != domain.Width() || domain_texture->GetHeight() != domain.Height()) {
+				delete domain_texture;
+				domain_texture = new Ember::Texture(domain.Width(), domain.Height());
+			}
+			domain_texture->SetData((void*)domain.Pixels().data());
+		}
+
 		renderer->EndScene();
 		fb->UnBind();
 	}
@@ -94,6 +122,18 @@ public:
 	void UserDefEvent(Ember::Event& event) {
 		Ember::EventDispatcher dispatch(&event);
 		camera.OnEvent(event);
+		dispatch.Dispatch<Ember::ResizeEvent>(EMBER_BIND_FUNC(OnFrameResize));
+	}
+
+	//The scene is drawn into fb at the window's size, so the samplers' pixel tolerances match what is on screen
+	void OnFrameResize(const Ember::ResizeEvent& resize) {
+		if (resize.w <= 0 || resize.h <= 0)
+			return;
+		frame_width = (uint32_t)resize.w;
+		frame_height = (uint32_t)resize.h;
+		delete fb;
+		fb = new Ember::FrameBuffer(frame_width, frame_height);
+		Ember::RendererCommand::SetViewport(0, 0, frame_width, frame_height);
 	}
 
 	void OnGuiUpdate() {
@@ -142,18 +182,169 @@ public:
 
 		ImGui::Begin("Lexer");
 
-		ImGui::InputTextMultiline("Lexer Input", in, 512);
-		if (ImGui::Button("Compile")) {
-			lexer.Clear();
-			lexer.Input(in);
-			lexer.Run();
-			MatLib::Parser p(&lexer);
-			p.Run();
-			p.Visualize();
-			MatLib::FunctionSolver fs(&p);
-			fs.Solve();
-			p.Destroy();
+		//Every keystroke re-lexes and re-parses only the lines it touched, Compile still rebuilds everything and logs.
+		//The pipeline keeps the tree in step with the text, a cached program only skips the compile
+		if (ImGui::InputTextMultiline("Lexer Input", &source[0], source.capacity() + 1, ImVec2(0, 0), ImGuiInputTextFlags_CallbackResize, ResizeSource, &source)) {
+			uint64_t options = CompileOptions();
+			document.Sync(source);
+			document.Update();
+			RunPipeline();
+			if (const MatLib::Program* cached = cache.Find(source, options))
+				solver.SetProgram(*cached);
+			else {
+				solver.Compile();
+				cache.Insert(source, options, solver.GetProgram());
+			}
+			plotter.Reset();
+			document.Finish();
+		}
+		if (ImGui::Button("Compile") || rebuild) {
+			auto start = std::chrono::high_resolution_clock::now();
+			//A cached program skips lexing, parsing and optimizing, the document catches up on the next keystroke
+			const MatLib::Program* cached = (rebuild) ? nullptr : cache.Find(source, CompileOptions());
+			rebuild = false;
+			if (cached) {
+				lexer.Clear();
+				solver.SetProgram(*cached);
+				compile_us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+				solver.Report();
+			}
+			else {
+				lexer.Clear();
+				lexer.Input(source);
+				lexer.Run();
+				document.Sync(source);
+				document.Rebuild();
+				document.Update();
+				RunPipeline();
+				solver.Compile();
+				cache.Insert(source, CompileOptions(), solver.GetProgram());
+				compile_us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
+				optimizer.Log();
+				parser.Visualize();
+				solver.Report();
+				document.Finish();
+			}
+			plotter.Reset();
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Benchmark"))
+			MatLib::Benchmark::RunAll();
+		ImGui::SameLine();
+		ImGui::Checkbox("Derivatives", &derivatives);
+
+		ImGui::Checkbox("Cap Samples", &cap_samples);
+		ImGui::SameLine();
+		ImGui::InputInt("Samples Per Frame", &samples_per_frame);
+		if (samples_per_frame < 1)
+			samples_per_frame = 1;
+		auto plot_stats = plotter.Statistics();
+		ImGui::Text("Plot: %u evaluations, %u points, %u pending", plot_stats.evaluations, plot_stats.points, plot_stats.pending);
+		auto implicit_stats = plotter.ImplicitStats();
+		ImGui::Text("Implicit: %u cells (%u culled), %u segments, %.2f ms", implicit_stats.cells, implicit_stats.culled, implicit_stats.segments, implicit_stats.milliseconds);
+
+		//Colors the chosen assignment over the complex plane of the view with x read as z = x + iy. Like the exact modes
+		//it needs an optimizer that leaves (-1) ^ 0.5 alone rather than folding it to NaN
+		if (ImGui::Checkbox("Domain Coloring", &domain_coloring)) {
+			optimizer.SetExact(numeric_mode != MatLib::NUMERIC_DOUBLE || domain_coloring);
+			rebuild = true;
+		}
+		if (domain_coloring) {
+			ImGui::SameLine();
+			if (ImGui::InputInt("Function", &domain_function)) {
+				domain_function = (domain_function < 0) ? 0 : domain_function;
+				plotter.Domain().SetFunction((size_t)domain_function);
+			}
+			if (ImGui::SliderInt("Pixels Per Sample", &domain_scale, 1, 8)) {
+				plotter.Domain().scale = (uint32_t)domain_scale;
+				plotter.Domain().Reset();
+			}
+			auto& domain_stats = plotter.Domain().Statistics();
+			ImGui::Text("Domain: %u x %u, %.2f ms (%.1f Mpixels/s)", domain_stats.width, domain_stats.height, domain_stats.milliseconds,
+				(domain_stats.milliseconds > 0.0) ? domain_stats.evaluations / domain_stats.milliseconds / 1000.0 : 0.0);
+		}
+
+		ImGui::InputFloat2("Root Interval", root_interval);
+		ImGui::SameLine();
+		if (ImGui::Button("Find Roots")) {
+			for (size_t i = 0; i < solver.GetProgram().assignments.size(); i++) {
+				printf("Roots of %s:\n", solver.GetProgram().assignments[i].id.c_str());
+				for (auto& root : solver.FindRoots(i, root_interval[0], root_interval[1]))
+					printf("\tx = %.15g +- %g\n", root.x, root.error);
+			}
+		}
+		auto& cache_stats = cache.Statistics();
+		ImGui::Text("Program Cache: %u hits, %u misses, %u evicted, %zu entries, %zu / %zu bytes, last compile %.1f us", cache_stats.hits, cache_stats.misses,
+			cache_stats.evictions, cache_stats.entries, cache_stats.bytes, cache.Budget(), compile_us);
+		if (ImGui::InputInt("Cache Budget (KB)", &cache_budget_kb)) {
+			if (cache_budget_kb < 0)
+				cache_budget_kb = 0;
+			cache.SetBudget((size_t)cache_budget_kb * 1024);
+		}
+		auto& doc_stats = document.Statistics();
+		ImGui::Text("Editor: %u lines, %u re-lexed (%u-%u), %u statements reparsed, %u reused, %.3f ms update, %.3f ms latency (%.3f max)", doc_stats.lines, doc_stats.relexed,
+			doc_stats.first_changed + 1, doc_stats.last_changed + 1, doc_stats.reparsed, doc_stats.reused, doc_stats.update_ms, doc_stats.latency_ms, doc_stats.max_latency_ms);
+		auto& ast_stats = parser.AllocationStatistics();
+		ImGui::Text("AST Arena: %zu allocations, %zu bytes used, %zu bytes reserved, %zu heap blocks", ast_stats.allocations, ast_stats.bytes_used, ast_stats.bytes_reserved, ast_stats.block_allocations);
+		ImGui::Text("Symbols: %zu interned, %zu bytes", MatLib::Interner::Global().Size(), MatLib::Interner::Global().Bytes());
+		auto& opt_stats = optimizer.Statistics();
+		ImGui::Text("Optimizer: %u -> %u nodes (%u folded, %u simplified)", opt_stats.nodes_before, opt_stats.nodes_after, opt_stats.folded, opt_stats.simplified);
+		ImGui::Text("Hash Consing: %u unique nodes, %u shared", hash_cons.Statistics().unique, hash_cons.Statistics().shared);
+		auto& compile_stats = solver.CompileStatistics();
+		ImGui::Text("Procedures: %zu defined, %u calls inlined, %u calls through frames, %u memoized", (parser.Root()) ? parser.Root()->functions.size() : (size_t)0, compile_stats.inlined,
+			compile_stats.calls, compile_stats.memo_calls);
+		if (parser.Root()) {
+			auto& functions = parser.Root()->functions;
+			for (size_t i = 0; i < functions.size(); i++) {
+				if (!functions[i]->pure)
+					continue;
+				std::string name(functions[i]->id->Name());
+				bool memoized = solver.IsMemoized(name);
+				//Cached programs were compiled with the old memo choices, so they are dropped along with them
+				if (ImGui::Checkbox(("Memoize " + name).c_str(), &memoized)) {
+					solver.SetMemoized(name, memoized);
+					cache.Clear();
+					solver.Compile();
+					plotter.Reset();
+				}
+				if (memoized && i < solver.Memos().size()) {
+					auto& memo_stats = solver.Memos()[i].Statistics();
+					ImGui::SameLine();
+					ImGui::Text("%.1f%% hit rate, %llu hits, %llu misses, %llu evicted, %u / %u entries", memo_stats.HitRate() * 100.0, (unsigned long long)memo_stats.hits,
+						(unsigned long long)memo_stats.misses, (unsigned long long)memo_stats.evictions, memo_stats.size, solver.Memos()[i].Capacity());
+				}
+			}
+		}
+		//Switching mode re-parses the script, outside double mode the optimizer only folds what stays exact and matrix
+		//mode keeps a * b and b * a apart when hash consing
+		const char* modes[] = { "Double", "Rational", "Big-Float", "Complex", "Matrix" };
+		bool mode_changed = ImGui::Combo("Numeric Mode", &numeric_mode, modes, IM_ARRAYSIZE(modes));
+		if (numeric_mode == MatLib::NUMERIC_BIG_FLOAT && ImGui::InputInt("Big-Float Digits", &big_digits)) {
+			if (big_digits < 1)
+				big_digits = 1;
+			if (big_digits > (int)MatLib::BIG_FLOAT_MAX_DIGITS)
+				big_digits = (int)MatLib::BIG_FLOAT_MAX_DIGITS;
+			mode_changed = true;
 		}
+		if (mode_changed) {
+			solver.SetMode(numeric_mode);
+			solver.SetDigits((uint32_t)big_digits);
+			optimizer.SetExact(numeric_mode != MatLib::NUMERIC_DOUBLE || domain_coloring);
+			hash_cons.SetOrderedProducts(numeric_mode == MatLib::NUMERIC_MATRIX);
+			rebuild = true;
+		}
+		ImGui::InputText("Script x", script_x, sizeof(script_x));
+		ImGui::SameLine();
+		if (ImGui::Button("Evaluate") && parser.Root()) {
+			auto start = std::chrono::high_resolution_clock::now();
+			script_results.clear();
+			for (auto& value : solver.EvaluateScript(script_x))
+				script_results += value.id + " = " + value.text + "\n";
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			printf("----%s (x = %s, %.2f ms)----\n%s", modes[numeric_mode], script_x, ms, script_results.c_str());
+		}
+		ImGui::TextWrapped("%s", script_results.c_str());
+
 		ImGui::Text("Lexer Output:");
 		auto& tokens = lexer.Tokens();
 
@@ -177,14 +368,84 @@ public:
 		}
 
 		ImGui::End();
+
+		if (domain_coloring && domain_texture) {
+			ImGui::Begin("Domain Coloring");
+			ImGui::Image((void*)(uintptr_t)domain_texture->GetTextureId(), ImGui::GetContentRegionAvail());
+			ImGui::End();
+		}
+	}
+
+	//The world rectangle the camera shows at the framebuffer's size, found by taking the corners of clip space back
+	//through projection * view. Panning, zooming or resizing changes it and the plotter then starts over
+	MatLib::SamplerView CameraView() {
+		auto& ortho = camera.GetCamera();
+		glm::mat4 inverse = glm::inverse(ortho.GetProjection() * ortho.GetView());
+		glm::vec4 a = inverse * glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f);
+		glm::vec4 b = inverse * glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
+
+		MatLib::SamplerView view;
+		view.x0 = fmin(a.x, b.x);
+		view.x1 = fmax(a.x, b.x);
+		view.y0 = fmin(a.y, b.y);
+		view.y1 = fmax(a.y, b.y);
+		view.width = frame_width;
+		view.height = frame_height;
+		return view;
+	}
+
+	//Everything that changes the compiled program for the same source, ordered products follow the matrix mode
+	uint64_t CompileOptions() const {
+		uint64_t options = (uint64_t)numeric_mode << MatLib::PROGRAM_MODE_SHIFT;
+		if (derivatives)
+			options |= MatLib::PROGRAM_DERIVATIVES;
+		if (optimizer.IsExact())
+			options |= MatLib::PROGRAM_EXACT;
+		if (numeric_mode == MatLib::NUMERIC_MATRIX)
+			options |= MatLib::PROGRAM_ORDERED_PRODUCTS;
+		if (domain_coloring)
+			options |= MatLib::PROGRAM_DOMAIN_COLORING;
+		return options;
+	}
+
+	void RunPipeline() {
+		optimizer.Run();
+		if (derivatives)
+			differentiator.Run("x");
+		hash_cons.Run();
 	}
 private:
 	Ember::OrthoCameraController camera;
 	Ember::FrameBuffer* fb;
+	uint32_t frame_width = WINDOW_WIDTH;
+	uint32_t frame_height = WINDOW_HEIGHT;
 	Ember::Quad* q;
 	float background[3] = { 0.129f, 0.309f, 0.431f };
 	MatLib::Lexer lexer;
-	char in[512];
+	MatLib::Parser parser{ &lexer };
+	MatLib::Document document{ &lexer, &parser };
+	MatLib::Optimizer optimizer{ &parser };
+	MatLib::HashCons hash_cons{ &parser };
+	MatLib::Differentiator differentiator{ &parser };
+	bool derivatives = false;
+	bool rebuild = false;
+	MatLib::FunctionSolver solver{ &parser };
+	MatLib::ProgramCache cache;
+	int cache_budget_kb = (int)(MatLib::PROGRAM_CACHE_BUDGET / 1024);
+	double compile_us = 0.0;
+	float root_interval[2] = { -10.0f, 10.0f };
+	MatLib::CurvePlotter plotter{ &solver };
+	bool cap_samples = false;
+	int samples_per_frame = 512;
+	bool domain_coloring = false;
+	int domain_function = 0;
+	int domain_scale = 1;
+	Ember::Texture* domain_texture = nullptr;
+	int numeric_mode = MatLib::NUMERIC_DOUBLE;
+	int big_digits = (int)MatLib::BIG_FLOAT_DEFAULT_DIGITS;
+	char script_x[256] = "1";
+	std::string script_results;
+	std::string source;
 };
 
 int main(int argc, char** argv) {
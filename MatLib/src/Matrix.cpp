@@ -0,0 +1,274 @@
+#include "Matrix.h"
+#include "Gemm.h"
+#include "Kernels.h"
+#include "Dual.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace MatLib {
+	Matrix::Matrix(double value) : data(1, value) { }
+
+	Matrix::Matrix(uint32_t rows, uint32_t cols, double value) : rows(rows), cols(cols), data((size_t)rows * cols, value) { }
+
+	Matrix Matrix::Identity(uint32_t n) {
+		Matrix m(n, n);
+		for (uint32_t i = 0; i < n; i++)
+			m.At(i, i) = 1.0;
+		return m;
+	}
+
+	Matrix Matrix::Parse(std::string_view text) {
+		std::vector<std::vector<double>> values(1);
+		std::string s(text);
+		const char* p = s.c_str();
+		while (*p) {
+			char* end = nullptr;
+			double value = strtod(p, &end);
+			if (end != p) {
+				values.back().push_back(value);
+				p = end;
+			}
+			else if (*p == ';') {
+				values.emplace_back();
+				p++;
+			}
+			else if (*p == '[' || *p == ']' || *p == ',' || *p == ' ' || *p == '\t')
+				p++;
+			else
+				return NaN();
+		}
+
+		if (values.back().empty() && values.size() > 1)
+			values.pop_back();
+		if (values[0].empty())
+			return NaN();
+		Matrix m((uint32_t)values.size(), (uint32_t)values[0].size());
+		for (uint32_t i = 0; i < m.rows; i++) {
+			if (values[i].size() != m.cols)
+				return NaN();
+			for (uint32_t j = 0; j < m.cols; j++)
+				m.At(i, j) = values[i][j];
+		}
+		return m;
+	}
+
+	double Matrix::ToDouble() const {
+		return (IsScalar()) ? data[0] : NAN;
+	}
+
+	std::string Matrix::ToString() const {
+		char number[32];
+		if (IsScalar()) {
+			snprintf(number, sizeof(number), "%.17g", data[0]);
+			return number;
+		}
+
+		std::string text = "[";
+		for (uint32_t i = 0; i < rows; i++) {
+			for (uint32_t j = 0; j < cols; j++) {
+				snprintf(number, sizeof(number), "%.17g", At(i, j));
+				text += number;
+				if (j + 1 < cols)
+					text += ", ";
+			}
+			if (i + 1 < rows)
+				text += "; ";
+		}
+		return text + "]";
+	}
+
+	Matrix Matrix::Transpose() const {
+		Matrix t(cols, rows);
+		for (uint32_t i = 0; i < rows; i++)
+			for (uint32_t j = 0; j < cols; j++)
+				t.At(j, i) = At(i, j);
+		return t;
+	}
+
+	Matrix Matrix::Solve(const Matrix& a, const Matrix& b) {
+		if (!a.IsSquare() || a.rows != b.rows)
+			return NaN();
+
+		uint32_t n = a.rows, m = b.cols;
+		Matrix lu = a, x = b;
+		for (uint32_t k = 0; k < n; k++) {
+			uint32_t pivot = k;
+			for (uint32_t i = k + 1; i < n; i++)
+				if (fabs(lu.At(i, k)) > fabs(lu.At(pivot, k)))
+					pivot = i;
+			if (lu.At(pivot, k) == 0.0 || std::isnan(lu.At(pivot, k)))
+				return NaN();
+			if (pivot != k) {
+				std::swap_ranges(&lu.At(k, 0), &lu.At(k, 0) + n, &lu.At(pivot, 0));
+				std::swap_ranges(&x.At(k, 0), &x.At(k, 0) + m, &x.At(pivot, 0));
+			}
+
+			//Eliminates below the pivot in both the factor and the right hand sides
+			for (uint32_t i = k + 1; i < n; i++) {
+				double l = lu.At(i, k) / lu.At(k, k);
+				if (l == 0.0)
+					continue;
+				for (uint32_t j = k + 1; j < n; j++)
+					lu.At(i, j) -= l * lu.At(k, j);
+				for (uint32_t j = 0; j < m; j++)
+					x.At(i, j) -= l * x.At(k, j);
+			}
+		}
+
+		for (uint32_t k = n; k-- > 0;) {
+			for (uint32_t j = 0; j < m; j++) {
+				double sum = x.At(k, j);
+				for (uint32_t i = k + 1; i < n; i++)
+					sum -= lu.At(k, i) * x.At(i, j);
+				x.At(k, j) = sum / lu.At(k, k);
+			}
+		}
+		return x;
+	}
+
+	//Applies a block kernel to equal shapes, a scalar operand is first spread over the shape of the other
+	static Matrix Elementwise(const Matrix& a, const Matrix& b, void (*kernel)(const double*, const double*, double*, size_t)) {
+		if (a.Rows() == b.Rows() && a.Cols() == b.Cols()) {
+			Matrix out(a.Rows(), a.Cols());
+			kernel(a.Data(), b.Data(), out.Data(), (size_t)a.Rows() * a.Cols());
+			return out;
+		}
+		if (a.IsScalar()) {
+			Matrix out(b.Rows(), b.Cols(), a.ToDouble());
+			kernel(out.Data(), b.Data(), out.Data(), (size_t)b.Rows() * b.Cols());
+			return out;
+		}
+		if (b.IsScalar()) {
+			Matrix out(a.Rows(), a.Cols(), b.ToDouble());
+			kernel(a.Data(), out.Data(), out.Data(), (size_t)a.Rows() * a.Cols());
+			return out;
+		}
+		return Matrix::NaN();
+	}
+
+	static Matrix Map(const Matrix& x, void (*kernel)(const double*, double*, size_t)) {
+		Matrix out(x.Rows(), x.Cols());
+		kernel(x.Data(), out.Data(), (size_t)x.Rows() * x.Cols());
+		return out;
+	}
+
+	Matrix operator-(const Matrix& a) {
+		return Map(a, Kernels::Negate);
+	}
+
+	Matrix operator+(const Matrix& a, const Matrix& b) {
+		return Elementwise(a, b, Kernels::Add);
+	}
+
+	Matrix operator-(const Matrix& a, const Matrix& b) {
+		return Elementwise(a, b, Kernels::Sub);
+	}
+
+	Matrix operator*(const Matrix& a, const Matrix& b) {
+		if (a.IsScalar() || b.IsScalar())
+			return Elementwise(a, b, Kernels::Mul);
+		if (a.Cols() != b.Rows())
+			return Matrix::NaN();
+		Matrix c(a.Rows(), b.Cols());
+		Gemm::Multiply(a.Data(), a.Cols(), b.Data(), b.Cols(), c.Data(), c.Cols(), a.Rows(), b.Cols(), a.Cols());
+		return c;
+	}
+
+	//a / b is a times the inverse of b, found as the solution of b' x' = a' rather than by inverting b
+	Matrix operator/(const Matrix& a, const Matrix& b) {
+		if (b.IsScalar())
+			return Elementwise(a, b, Kernels::Div);
+		if (a.IsScalar())
+			return a * b.Inverse();
+		if (a.Cols() != b.Rows())
+			return Matrix::NaN();
+		return Matrix::Solve(b.Transpose(), a.Transpose()).Transpose();
+	}
+
+	Matrix Sin(const Matrix& x) {
+		return Map(x, Kernels::Sin);
+	}
+
+	Matrix Cos(const Matrix& x) {
+		return Map(x, Kernels::Cos);
+	}
+
+	Matrix Exp(const Matrix& x) {
+		return Map(x, Kernels::Exp);
+	}
+
+	Matrix Log(const Matrix& x) {
+		return Map(x, Kernels::Log);
+	}
+
+	Matrix Sqrt(const Matrix& x) {
+		return Map(x, Kernels::Sqrt);
+	}
+
+	//A square base to an integer power by repeated squaring, a negative power squares the inverse
+	static Matrix IntegerPower(const Matrix& a, const Matrix& b) {
+		double n = b.ToDouble();
+		if (!a.IsSquare() || !b.IsScalar() || n != floor(n) || fabs(n) > MATRIX_MAX_SQUARING)
+			return Matrix::NaN();
+
+		Matrix result = Matrix::Identity(a.Rows());
+		Matrix square = (n < 0.0) ? a.Inverse() : a;
+		for (uint32_t e = (uint32_t)fabs(n); e; e >>= 1) {
+			if (e & 1)
+				result = result * square;
+			if (e > 1)
+				square = square * square;
+		}
+		return result;
+	}
+
+	Matrix Pow(const Matrix& a, const Matrix& b) {
+		if (a.IsScalar() && b.IsScalar())
+			return Matrix(Pow(a.ToDouble(), b.ToDouble()));
+		return IntegerPower(a, b);
+	}
+
+	Matrix Power(const Matrix& a, const Matrix& b) {
+		if (a.IsScalar() && b.IsScalar())
+			return Matrix(Kernels::Power(a.ToDouble(), b.ToDouble()));
+		return IntegerPower(a, b);
+	}
+
+	Matrix Assemble(uint32_t rows, uint32_t cols, const std::vector<Matrix>& elements) {
+		if (elements.size() != (size_t)rows * cols || elements.empty())
+			return Matrix::NaN();
+
+		uint32_t height = 0, width = 0;
+		for (uint32_t i = 0; i < rows; i++) {
+			uint32_t row_width = 0;
+			for (uint32_t j = 0; j < cols; j++) {
+				const Matrix& block = elements[(size_t)i * cols + j];
+				if (block.Rows() != elements[(size_t)i * cols].Rows())
+					return Matrix::NaN();
+				row_width += block.Cols();
+			}
+			if (i > 0 && row_width != width)
+				return Matrix::NaN();
+			width = row_width;
+			height += elements[(size_t)i * cols].Rows();
+		}
+
+		Matrix m(height, width);
+		uint32_t top = 0;
+		for (uint32_t i = 0; i < rows; i++) {
+			uint32_t left = 0;
+			for (uint32_t j = 0; j < cols; j++) {
+				const Matrix& block = elements[(size_t)i * cols + j];
+				for (uint32_t r = 0; r < block.Rows(); r++)
+					for (uint32_t c = 0; c < block.Cols(); c++)
+						m.At(top + r, left + c) = block.At(r, c);
+				left += block.Cols();
+			}
+			top += elements[(size_t)i * cols].Rows();
+		}
+		return m;
+	}
+}
\ No newline at end of file
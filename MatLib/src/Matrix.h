@@ -0,0 +1,72 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MatLib {
+	//Integer powers of a square matrix up to this size go by repeated squaring, anything else is NaN
+	constexpr double MATRIX_MAX_SQUARING = 1 << 20;
+
+	//Dense row-major matrix, the value of matrix mode. A 1x1 matrix is a scalar: it is added to or subtracted from every
+	//element of the other operand and scales it in products. Shapes that do not fit give a 1x1 NaN
+	class Matrix {
+	public:
+		Matrix() : Matrix(0.0) { }
+		Matrix(double value);
+		Matrix(uint32_t rows, uint32_t cols, double value = 0.0);
+
+		//Reads a number or a literal like "[1, 2; 3, 4]", spaces also separate columns
+		static Matrix Parse(std::string_view text);
+		static Matrix Identity(uint32_t n);
+		static Matrix NaN() { return Matrix(NAN); }
+
+		uint32_t Rows() const { return rows; }
+		uint32_t Cols() const { return cols; }
+		bool IsScalar() const { return rows == 1 && cols == 1; }
+		bool IsSquare() const { return rows == cols; }
+		double& At(uint32_t row, uint32_t col) { return data[(size_t)row * cols + col]; }
+		double At(uint32_t row, uint32_t col) const { return data[(size_t)row * cols + col]; }
+		double* Data() { return data.data(); }
+		const double* Data() const { return data.data(); }
+
+		//The value of a 1x1 matrix, NaN for anything larger
+		double ToDouble() const;
+		std::string ToString() const;
+		Matrix Transpose() const;
+
+		//x with a x = b by LU with partial pivoting, NaN when a is singular or the shapes do not fit
+		static Matrix Solve(const Matrix& a, const Matrix& b);
+		Matrix Inverse() const { return Solve(*this, Identity(rows)); }
+	private:
+		uint32_t rows = 1;
+		uint32_t cols = 1;
+		std::vector<double> data;
+	};
+
+	Matrix operator-(const Matrix& a);
+	Matrix operator+(const Matrix& a, const Matrix& b);
+	Matrix operator-(const Matrix& a, const Matrix& b);
+	Matrix operator*(const Matrix& a, const Matrix& b);
+	Matrix operator/(const Matrix& a, const Matrix& b);
+
+	//Element by element, as a script applies them to numbers
+	Matrix Sin(const Matrix& x);
+	Matrix Cos(const Matrix& x);
+	Matrix Exp(const Matrix& x);
+	Matrix Log(const Matrix& x);
+	Matrix Sqrt(const Matrix& x);
+
+	//A scalar base and exponent follow the double mode's ^ and pow, a square base takes integer exponents
+	Matrix Pow(const Matrix& a, const Matrix& b);
+	Matrix Power(const Matrix& a, const Matrix& b);
+
+	//[A, B; C, D] with matrix elements is a block matrix, the blocks in a row share their height and every row of
+	//blocks has the same total width
+	Matrix Assemble(uint32_t rows, uint32_t cols, const std::vector<Matrix>& elements);
+}
+
+#endif // !MATRIX_H
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include "MemoTable.h"
+
+#include <cstring>
+
+namespace MatLib {
+	MemoTable::MemoTable(uint32_t capacity) {
+		this->capacity = (capacity) ? capacity : 1;
+	}
+
+	//Tables of procedures that are never memoized are never reserved and stay empty
+	void MemoTable::Allocate() {
+		size_t slots = 2;
+		while (slots < 2 * (size_t)capacity)
+			slots *= 2;
+		entries.resize(capacity);
+		index.assign(slots, EMPTY);
+	}
+
+	uint64_t MemoTable::Hash(const uint64_t* key, uint32_t count) {
+		uint64_t h = 0x9e3779b97f4a7c15ull * (count + 1);
+		for (uint32_t i = 0; i < count; i++) {
+			h ^= key[i] + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdull;
+		}
+		return h ^ (h >> 33);
+	}
+
+	//Linear probing, returns the slot holding the key or the empty slot that ends its run
+	size_t MemoTable::Probe(const uint64_t* key, uint32_t count, uint64_t hash) const {
+		size_t mask = index.size() - 1;
+		for (size_t i = hash & mask;; i = (i + 1) & mask) {
+			uint32_t entry = index[i];
+			if (entry == EMPTY)
+				return i;
+			const Entry& e = entries[entry];
+			if (e.hash == hash && e.count == count && memcmp(e.key, key, count * sizeof(uint64_t)) == 0)
+				return i;
+		}
+	}
+
+	bool MemoTable::Find(const double* args, uint32_t count, double& value) {
+		if (index.empty()) {
+			stats.misses++;
+			return false;
+		}
+
+		uint64_t key[PROCEDURE_MAX_ARGS];
+		memcpy(key, args, count * sizeof(uint64_t));
+		size_t position = Probe(key, count, Hash(key, count));
+		if (index[position] == EMPTY) {
+			stats.misses++;
+			return false;
+		}
+
+		uint32_t entry = index[position];
+		if (entry != head) {
+			Unlink(entry);
+			PushFront(entry);
+		}
+		value = entries[entry].value;
+		stats.hits++;
+		return true;
+	}
+
+	void MemoTable::Insert(const double* args, uint32_t count, double value) {
+		Reserve();
+		uint64_t key[PROCEDURE_MAX_ARGS];
+		memcpy(key, args, count * sizeof(uint64_t));
+		uint64_t hash = Hash(key, count);
+		size_t position = Probe(key, count, hash);
+		if (index[position] != EMPTY) {
+			entries[index[position]].value = value;
+			return;
+		}
+
+		uint32_t entry;
+		if (used < entries.size())
+			entry = used++;
+		else {
+			//Full, the least recently used entry gives up its storage
+			entry = tail;
+			const Entry& old = entries[entry];
+			Erase(Probe(old.key, old.count, old.hash));
+			Unlink(entry);
+			stats.evictions++;
+			position = Probe(key, count, hash);
+		}
+
+		Entry& e = entries[entry];
+		memcpy(e.key, key, count * sizeof(uint64_t));
+		e.count = count;
+		e.hash = hash;
+		e.value = value;
+		index[position] = entry;
+		PushFront(entry);
+		stats.size = used;
+	}
+
+	void MemoTable::Clear() {
+		index.assign(index.size(), EMPTY);
+		head = EMPTY;
+		tail = EMPTY;
+		used = 0;
+		stats = MemoStatistics();
+	}
+
+	void MemoTable::Unlink(uint32_t entry) {
+		Entry& e = entries[entry];
+		if (e.prev != EMPTY)
+			entries[e.prev].next = e.next;
+		else
+			head = e.next;
+		if (e.next != EMPTY)
+			entries[e.next].prev = e.prev;
+		else
+			tail = e.prev;
+		e.prev = EMPTY;
+		e.next = EMPTY;
+	}
+
+	void MemoTable::PushFront(uint32_t entry) {
+		Entry& e = entries[entry];
+		e.prev = EMPTY;
+		e.next = head;
+		if (head != EMPTY)
+			entries[head].prev = entry;
+		head = entry;
+		if (tail == EMPTY)
+			tail = entry;
+	}
+
+	//Backward shift deletion keeps every probe run unbroken without tombstones
+	void MemoTable::Erase(size_t position) {
+		size_t mask = index.size() - 1;
+		index[position] = EMPTY;
+		for (size_t i = (position + 1) & mask; index[i] != EMPTY; i = (i + 1) & mask) {
+			size_t home = entries[index[i]].hash & mask;
+			//Move the entry back if its home is not in the cyclic range (position, i]
+			bool in_range = (position <= i) ? (home > position && home <= i) : (home > position || home <= i);
+			if (!in_range) {
+				index[position] = index[i];
+				index[i] = EMPTY;
+				position = i;
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef MEMO_TABLE_H
+#define MEMO_TABLE_H
+
+#include "Parser.h"
+
+namespace MatLib {
+	constexpr uint32_t MEMO_CAPACITY = 4096;
+
+	struct MemoStatistics {
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		uint32_t size = 0;
+
+		double HitRate() const { return (hits + misses) ? (double)hits / (hits + misses) : 0.0; }
+	};
+
+	//Bounded least recently used map from argument bit patterns to a result. Reserve allocates the entries, the hash
+	//index and the recency list in one go, after which lookups and inserts never touch the heap. The VM reserves every
+	//table a chunk calls before running it, a table used without Reserve allocates on its first insert
+	class MemoTable {
+	public:
+		MemoTable(uint32_t capacity = MEMO_CAPACITY);
+
+		void Reserve() { if (index.empty()) Allocate(); }
+		bool Find(const double* args, uint32_t count, double& value);
+		void Insert(const double* args, uint32_t count, double value);
+		void Clear();
+
+		uint32_t Capacity() const { return capacity; }
+		const MemoStatistics& Statistics() const { return stats; }
+	private:
+		static constexpr uint32_t EMPTY = UINT32_MAX;
+
+		struct Entry {
+			uint64_t key[PROCEDURE_MAX_ARGS] = { 0 };
+			uint64_t hash = 0;
+			uint32_t count = 0;
+			double value = 0.0;
+			uint32_t prev = EMPTY;
+			uint32_t next = EMPTY;
+		};
+
+		std::vector<Entry> entries;
+		std::vector<uint32_t> index;
+		uint32_t head = EMPTY;
+		uint32_t tail = EMPTY;
+		uint32_t used = 0;
+		uint32_t capacity = MEMO_CAPACITY;
+		MemoStatistics stats;
+	private:
+		void Allocate();
+		static uint64_t Hash(const uint64_t* key, uint32_t count);
+		size_t Probe(const uint64_t* key, uint32_t count, uint64_t hash) const;
+		void Unlink(uint32_t entry);
+		void PushFront(uint32_t entry);
+		void Erase(size_t position);
+	};
+}
+
+#endif // !MEMO_TABLE_H
\ No newline at end of file
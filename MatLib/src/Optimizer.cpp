@@ -0,0 +1,248 @@
+#include "Optimizer.h"
+
+#include <cmath>
+
+namespace MatLib {
+	Optimizer::Optimizer(Parser* parser) {
+		this->parser = parser;
+	}
+
+	void Optimizer::Run() {
+		stats = OptimizerStatistics();
+		if (!parser || !parser->Root())
+			return;
+
+		for (auto& proc : parser->Root()->procedures) {
+			stats.nodes_before += CountNodes(proc->expr);
+			proc->expr = Optimize(proc->expr);
+			stats.nodes_after += CountNodes(proc->expr);
+		}
+	}
+
+	Ast_Expression* Optimizer::Optimize(Ast_Expression* expr) {
+		if (!expr)
+			return nullptr;
+
+		switch (expr->type) {
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			if (p->nested) {
+				stats.collapsed++;
+				return Optimize(p->nested);
+			}
+			if (p->call)
+				for (auto& arg : p->call->args)
+					arg = Optimize(arg);
+			return p;
+		}
+		case AST_UNARY:
+			return OptimizeUnary(AST_CAST(Ast_UnaryExpression, expr));
+		case AST_BINARY:
+			return OptimizeBinary(AST_CAST(Ast_BinaryExpression, expr));
+		case AST_MATRIX:
+			for (auto& element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				element = Optimize(element);
+			return expr;
+		}
+		return expr;
+	}
+
+	Ast_Expression* Optimizer::OptimizeUnary(Ast_UnaryExpression* u) {
+		u->next = Optimize(u->next);
+		if (u->op != AST_UNARY_MINUS) {
+			stats.simplified++;
+			return u->next;
+		}
+
+		double value = 0.0;
+		if (Known(u->next, &value)) {
+			stats.folded++;
+			return MakeConstant(-value, u->line);
+		}
+
+		//--x
+		if (u->next && u->next->type == AST_UNARY && AST_CAST(Ast_UnaryExpression, u->next)->op == AST_UNARY_MINUS) {
+			stats.simplified++;
+			return AST_CAST(Ast_UnaryExpression, u->next)->next;
+		}
+		return u;
+	}
+
+	//Only identities that keep NaN and infinity intact are applied (x + 0 may flip the sign of a zero), so x*0 is left alone
+	Ast_Expression* Optimizer::OptimizeBinary(Ast_BinaryExpression* b) {
+		b->left = Optimize(b->left);
+		b->right = Optimize(b->right);
+
+		double left = 0.0, right = 0.0;
+		bool left_const = Known(b->left, &left);
+		bool right_const = Known(b->right, &right);
+
+		if (left_const && right_const) {
+			if (exact && !FoldsExactly(b->op, left, right))
+				return b;
+			switch (b->op) {
+			case AST_OPERATOR_ADD:
+				stats.folded++;
+				return MakeConstant(left + right, b->line);
+			case AST_OPERATOR_SUB:
+				stats.folded++;
+				return MakeConstant(left - right, b->line);
+			case AST_OPERATOR_MULTIPLICATIVE:
+				stats.folded++;
+				return MakeConstant(left * right, b->line);
+			case AST_OPERATOR_DIVISION:
+				stats.folded++;
+				return MakeConstant(left / right, b->line);
+			case AST_OPERATOR_POWER:
+				stats.folded++;
+				return MakeConstant(pow(left, right), b->line);
+			}
+			return b;
+		}
+
+		switch (b->op) {
+		case AST_OPERATOR_ADD:
+			if (right_const && right == 0.0) {
+				stats.simplified++;
+				return b->left;
+			}
+			if (left_const && left == 0.0) {
+				stats.simplified++;
+				return b->right;
+			}
+			break;
+		case AST_OPERATOR_SUB:
+			if (right_const && right == 0.0) {
+				stats.simplified++;
+				return b->left;
+			}
+			//x - -y
+			if (b->right && b->right->type == AST_UNARY && AST_CAST(Ast_UnaryExpression, b->right)->op == AST_UNARY_MINUS) {
+				stats.simplified++;
+				b->op = AST_OPERATOR_ADD;
+				b->right = AST_CAST(Ast_UnaryExpression, b->right)->next;
+			}
+			break;
+		case AST_OPERATOR_MULTIPLICATIVE:
+			if (right_const && right == 1.0) {
+				stats.simplified++;
+				return b->left;
+			}
+			if (left_const && left == 1.0) {
+				stats.simplified++;
+				return b->right;
+			}
+			break;
+		case AST_OPERATOR_DIVISION:
+			if (right_const && right == 1.0) {
+				stats.simplified++;
+				return b->left;
+			}
+			break;
+		case AST_OPERATOR_POWER:
+			if (right_const && right == 1.0) {
+				stats.simplified++;
+				return b->left;
+			}
+			//pow(x, 0) is 1 even for NaN and infinity, but a matrix to the zero is the identity so exact modes keep it
+			if (right_const && right == 0.0 && !exact) {
+				stats.simplified++;
+				return MakeConstant(1.0, b->line);
+			}
+			break;
+		}
+		return b;
+	}
+
+	//Integers below 2^53 whose result is another such integer, so folding loses nothing a double cannot hold
+	bool Optimizer::FoldsExactly(int op, double left, double right) {
+		const double LIMIT = 9007199254740992.0;
+		if (left != floor(left) || right != floor(right) || fabs(left) > LIMIT || fabs(right) > LIMIT)
+			return false;
+
+		switch (op) {
+		case AST_OPERATOR_ADD:
+			return fabs(left + right) <= LIMIT;
+		case AST_OPERATOR_SUB:
+			return fabs(left - right) <= LIMIT;
+		case AST_OPERATOR_MULTIPLICATIVE:
+			return fabs(left * right) <= LIMIT && fma(left, right, -(left * right)) == 0.0;
+		case AST_OPERATOR_DIVISION:
+			return right != 0.0 && fmod(left, right) == 0.0;
+		case AST_OPERATOR_POWER: {
+			if (right < 0.0 || right > 64.0)
+				return false;
+			double p = 1.0;
+			for (int i = 0; i < (int)right; i++) {
+				if (fabs(p * left) > LIMIT || fma(p, left, -(p * left)) != 0.0)
+					return false;
+				p *= left;
+			}
+			return true;
+		}
+		}
+		return false;
+	}
+
+	Ast_Expression* Optimizer::MakeConstant(double value, uint32_t line) {
+		auto prime = parser->AstArena().New<Ast_PrimaryExpression>();
+		prime->line = line;
+		prime->num_const = value;
+		return prime;
+	}
+
+	bool Optimizer::IsConstant(Ast_Expression* expr, double* value) {
+		if (!expr || expr->type != AST_PRIMARY)
+			return false;
+		auto p = AST_CAST(Ast_PrimaryExpression, expr);
+		if (p->nested || p->ident || p->call)
+			return false;
+		if (value)
+			*value = p->num_const;
+		return true;
+	}
+
+	//Exact modes parse literals from their text, so a literal only takes part in folding when its double holds every digit
+	bool Optimizer::Known(Ast_Expression* expr, double* value) const {
+		if (!IsConstant(expr, value))
+			return false;
+		auto p = AST_CAST(Ast_PrimaryExpression, expr);
+		if (!exact || p->literal.empty())
+			return true;
+		return p->num_const == floor(p->num_const) && fabs(p->num_const) < 9007199254740992.0;
+	}
+
+	uint32_t Optimizer::CountNodes(Ast_Expression* expr) {
+		if (!expr)
+			return 0;
+
+		switch (expr->type) {
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			uint32_t nodes = 1 + CountNodes(p->nested);
+			if (p->call)
+				for (auto arg : p->call->args)
+					nodes += CountNodes(arg);
+			return nodes;
+		}
+		case AST_UNARY:
+			return 1 + CountNodes(AST_CAST(Ast_UnaryExpression, expr)->next);
+		case AST_BINARY: {
+			auto b = AST_CAST(Ast_BinaryExpression, expr);
+			return 1 + CountNodes(b->left) + CountNodes(b->right);
+		}
+		case AST_MATRIX: {
+			uint32_t nodes = 1;
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				nodes += CountNodes(element);
+			return nodes;
+		}
+		}
+		return 1;
+	}
+
+	void Optimizer::Log() {
+		printf("----Optimizer----\n");
+		printf("Nodes: %u -> %u (folded %u, simplified %u, collapsed %u)\n", stats.nodes_before, stats.nodes_after, stats.folded, stats.simplified, stats.collapsed);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "Parser.h"
+
+namespace MatLib {
+	struct OptimizerStatistics {
+		uint32_t nodes_before = 0;
+		uint32_t nodes_after = 0;
+		uint32_t folded = 0;
+		uint32_t simplified = 0;
+		uint32_t collapsed = 0;
+	};
+
+	class Optimizer {
+	public:
+		Optimizer() = default;
+		Optimizer(Parser* parser);
+
+		void Run();
+		Ast_Expression* Optimize(Ast_Expression* expr);
+
+		//Higher precision modes read constants as written, so they only let exact integer arithmetic be folded
+		void SetExact(bool exact) { this->exact = exact; }
+		bool IsExact() const { return exact; }
+
+		static uint32_t CountNodes(Ast_Expression* expr);
+		static bool IsConstant(Ast_Expression* expr, double* value = nullptr);
+
+		const OptimizerStatistics& Statistics() const { return stats; }
+		void Log();
+	private:
+		Parser* parser = nullptr;
+		OptimizerStatistics stats;
+		bool exact = false;
+	private:
+		Ast_Expression* OptimizeUnary(Ast_UnaryExpression* u);
+		Ast_Expression* OptimizeBinary(Ast_BinaryExpression* b);
+		Ast_Expression* MakeConstant(double value, uint32_t line);
+		bool Known(Ast_Expression* expr, double* value) const;
+		static bool FoldsExactly(int op, double left, double right);
+	};
+}
+
+#endif // !OPTIMIZER_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace MatLib {
+	inline size_t HardwareThreads() {
+		size_t threads = std::thread::hardware_concurrency();
+		return (threads > 0) ? threads : 1;
+	}
+
+	//Splits [0, count) into one contiguous range per thread and calls fn(begin, end, thread) on each
+	template <typename Fn>
+	void ParallelFor(size_t count, size_t threads, const Fn& fn) {
+		if (threads == 0)
+			threads = HardwareThreads();
+		if (threads > count)
+			threads = count;
+		if (threads <= 1) {
+			if (count > 0)
+				fn((size_t)0, count, (size_t)0);
+			return;
+		}
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+		size_t step = count / threads, extra = count % threads, begin = 0;
+		for (size_t t = 0; t < threads; t++) {
+			size_t end = begin + step + ((t < extra) ? 1 : 0);
+			if (t + 1 == threads)
+				fn(begin, end, t);
+			else
+				workers.emplace_back([&fn, begin, end, t]() { fn(begin, end, t); });
+			begin = end;
+		}
+
+		for (auto& worker : workers)
+			worker.join();
+	}
+}
+
+#endif // !PARALLEL_H
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "Parser.h"
+#include "Builtins.h"
 #include "Logger.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace MatLib {
 	Parser::Parser(Lexer* lexer) {
 		this->lexer = lexer;
@@ -16,14 +20,16 @@ namespace MatLib {
 			return AST_OPERATOR_MULTIPLICATIVE;
 		case Tok::T_SLASH:
 			return AST_OPERATOR_DIVISION;
+		case Tok::T_CARET:
+			return AST_OPERATOR_POWER;
 		}
 		return AST_OPERATOR_NONE;
 	}
 
 	Ast_Identifier* Parser::ParseId() {
 		auto id = AST_NEW(Ast_Identifier);
-		if (Peek()->type = Tok::T_IDENTIFIER)
-			id->id = Advance()->id;
+		if (Peek()->type == Tok::T_IDENTIFIER)
+			id->symbol = Advance()->symbol;
 		else
 			id = nullptr;
 		return id;
@@ -34,11 +40,18 @@ namespace MatLib {
 		switch (Peek()->type) {
 		case Tok::T_NUM_CONST: {
 			prime->num_const = Peek()->num_const;
+			std::string_view text = Peek()->text;
+			char* copy = static_cast<char*>(arena.Allocate(text.size(), 1));
+			std::memcpy(copy, text.data(), text.size());
+			prime->literal = std::string_view(copy, text.size());
 			Match(Tok::T_NUM_CONST);
 			break;
 		}
 		case Tok::T_IDENTIFIER: {
-			prime->ident = ParseId();
+			if (PeekOff(1) && PeekOff(1)->type == Tok::T_LPAR)
+				prime->call = ParseProcedureCall();
+			else
+				prime->ident = ParseId();
 			break;
 		}
 		case Tok::T_LPAR: {
@@ -48,21 +61,33 @@ namespace MatLib {
 			prime->nested = expr;
 			break;
 		}
-		default: {
-			AST_DELETE(prime);
+		case Tok::T_LBRACKET:
+			return ParseMatrix();
+		default:
 			return nullptr;
 		}
-		}
 		return prime;
 	}
 
 	Ast_Expression* Parser::ParseUnary() {
 		if (Match(Tok::T_MINUS)) {
 			Ast_Expression* right = ParseUnary();
-			return new Ast_UnaryExpression(right, AST_UNARY_MINUS);
+			return AST_NEW(Ast_UnaryExpression, right, AST_UNARY_MINUS);
 		}
 
-		return ParsePrimary();
+		return ParsePower();
+	}
+
+	//Right associative and tighter than unary minus, so -x^2 is -(x^2) and 2^-x is allowed
+	Ast_Expression* Parser::ParsePower() {
+		auto expr = ParsePrimary();
+
+		if (Match(Tok::T_CARET)) {
+			auto right = ParseUnary();
+			expr = AST_NEW(Ast_BinaryExpression, expr, AST_OPERATOR_POWER, right);
+		}
+
+		return expr;
 	}
 
 	Ast_Expression* Parser::ParseFactor() {
@@ -71,7 +96,7 @@ namespace MatLib {
 		while (Match(Tok::T_SLASH) || Match(Tok::T_STAR)) {
 			Token* op = Previous();
 			auto right = ParseUnary();
-			expr = new Ast_BinaryExpression(expr, TokenTypeToAstType(op), right);
+			expr = AST_NEW(Ast_BinaryExpression, expr, TokenTypeToAstType(op), right);
 		}
 
 		return expr;
@@ -83,15 +108,68 @@ namespace MatLib {
 		while (Match(Tok::T_MINUS) || Match(Tok::T_PLUS)) {
 			auto t = Previous();
 			auto right = ParseFactor();
-			expr = new Ast_BinaryExpression(expr, TokenTypeToAstType(t), right);
+			expr = AST_NEW(Ast_BinaryExpression, expr, TokenTypeToAstType(t), right);
 		}
 
 		return expr;
 	}
 
 	Ast_ProcedureCall* Parser::ParseProcedureCall() {
-		return nullptr;
+		auto call = AST_NEW(Ast_ProcedureCall);
+		call->id = ParseId();
+		Match(Tok::T_LPAR);
+		if (!Check(Tok::T_RPAR)) {
+			do {
+				auto arg = ParseExpression();
+				if (!arg)
+					break;
+				call->args.push_back(arg);
+			} while (Match(Tok::T_COMMA));
+		}
+		if (!Match(Tok::T_RPAR))
+			EMBER_LOG_ERROR("Expected ')' to close the call to '%.*s' on line %d.", (int)call->id->Name().size(), call->id->Name().data(), call->line);
+		return call;
+	}
+
+	Ast_Expression* Parser::ParseMatrix() {
+		auto matrix = AST_NEW(Ast_MatrixExpression);
+		Match(Tok::T_LBRACKET);
+		uint32_t cols = 0;
+		while (!Check(Tok::T_RBRACKET) && !AtEnd()) {
+			auto element = ParseExpression();
+			if (!element)
+				break;
+			matrix->elements.push_back(element);
+			cols++;
+			if (Match(Tok::T_COMMA))
+				continue;
+			if (matrix->rows == 0)
+				matrix->cols = cols;
+			else if (cols != matrix->cols)
+				EMBER_LOG_ERROR("Row %u of the matrix on line %d has %u elements, expected %u.", matrix->rows + 1, matrix->line, cols, matrix->cols);
+			matrix->rows++;
+			cols = 0;
+			if (!Match(Tok::T_SEMICOLON))
+				break;
+		}
+		if (!Match(Tok::T_RBRACKET))
+			EMBER_LOG_ERROR("Expected ']' to close the matrix on line %d.", matrix->line);
+		if (matrix->rows == 0 || matrix->elements.size() != (size_t)matrix->rows * matrix->cols) {
+			EMBER_LOG_ERROR("Matrix on line %d is empty or ragged.", matrix->line);
+			return nullptr;
+		}
+		return matrix;
+	}
 
+	//name(a, b, ...) = starts a definition, anything else with a call on the left is a relation
+	bool Parser::IsProcedureDefinition() {
+		int off = 2;
+		if (PeekOff(off) && PeekOff(off)->type == Tok::T_IDENTIFIER) {
+			off++;
+			while (PeekOff(off) && PeekOff(off)->type == Tok::T_COMMA && PeekOff(off + 1) && PeekOff(off + 1)->type == Tok::T_IDENTIFIER)
+				off += 2;
+		}
+		return PeekOff(off) && PeekOff(off)->type == Tok::T_RPAR && PeekOff(off + 1) && PeekOff(off + 1)->type == Tok::T_EQUAL;
 	}
 
 	Ast_Statement* Parser::ParseStatement() {
@@ -104,42 +182,248 @@ namespace MatLib {
 				assignment->expr = ParseExpression();
 				return assignment;
 			}
-			else if (PeekOff(1)->type == Tok::T_LPAR) {
+			else if (PeekOff(1)->type == Tok::T_LPAR && IsProcedureDefinition()) {
 				//Procedure
-
+				auto procedure = AST_NEW(Ast_Procedure);
+				procedure->id = ParseId();
+				Match(Tok::T_LPAR);
+				while (Check(Tok::T_IDENTIFIER)) {
+					procedure->args.push_back(ParseId());
+					Match(Tok::T_COMMA);
+				}
+				Match(Tok::T_RPAR);
+				Match(Tok::T_EQUAL);
+				procedure->expr = ParseExpression();
+				if (procedure->args.size() > PROCEDURE_MAX_ARGS) {
+					EMBER_LOG_ERROR("Procedure '%.*s' on line %d takes more than %u arguments.", (int)procedure->id->Name().size(), procedure->id->Name().data(), procedure->line, PROCEDURE_MAX_ARGS);
+					return nullptr;
+				}
+				return procedure;
 			}
-			else 
-				return nullptr;
 		}
-		else {
-			EMBER_LOG_ERROR("Expected an identifier for statement.");
-			Advance();
+
+		//Relation
+		uint32_t start = token_index;
+		auto left = ParseExpression();
+		if (left && Match(Tok::T_EQUAL)) {
+			auto relation = AST_NEW(Ast_Relation);
+			relation->expr = AST_NEW(Ast_BinaryExpression, left, AST_OPERATOR_SUB, ParseExpression());
+			return relation;
 		}
 
+		EMBER_LOG_ERROR("Expected an identifier for statement.");
+		if (token_index == start)
+			Advance();
 		return nullptr;
 	}
 
 	void Parser::Run() {
+		Begin();
+		ParseTokens(lexer->Tokens().data(), lexer->Tokens().size(), root->procedures);
+		Resolve();
+	}
+
+	//Drops every node and starts an empty script, statements are then added with ParseTokens
+	void Parser::Begin() {
+		Destroy();
+		tokens = nullptr;
+		token_count = 0;
 		token_index = 0;
-		root = AST_NEW(Ast_Script);
+		root = arena.New<Ast_Script>();
+	}
 
-		while (Peek()->type != Tok::T_EOF) {
+	//Parses a token range ending in T_EOF into the current arena without touching earlier statements
+	void Parser::ParseTokens(Token* tokens, size_t count, std::vector<Ast_Statement*>& statements) {
+		this->tokens = tokens;
+		token_count = (uint32_t)count;
+		token_index = 0;
+
+		while (!AtEnd() && Peek()->type != Tok::T_EOF) {
 			auto proc = ParseStatement();
 			if (proc)
-				root->procedures.push_back(proc);
+				statements.push_back(proc);
+		}
+	}
+
+	//Binds every name to a frame slot once, so evaluation indexes a flat environment instead of looking names up.
+	//Each assignment gets a fresh slot and later statements see the latest one, reserved names (the inputs) stay free.
+	//Procedure parameters are declared in their own scope and shadow everything, calls bind to the latest definition.
+	//Runs over the whole script rather than inside ParseTokens so lines re-parsed by the editor resolve like the rest.
+	//Nodes already resolved may be shared by hash consing, so with stale given they are never rewritten, a statement
+	//whose names now resolve differently is reported instead and has to be parsed again
+	void Parser::Resolve(std::vector<Ast_Statement*>* stale) {
+		if (!root)
+			return;
+
+		root->definitions.clear();
+		root->functions.clear();
+		bindings.assign(Interner::Global().Size(), Binding());
+		function_bindings.assign(Interner::Global().Size(), SLOT_NONE);
+		scopes.clear();
+		PushScope();
+		for (auto proc : root->procedures) {
+			if (proc->type == AST_PROCEDURE) {
+				//Declared before its body so a call to itself resolves, and is then flagged as recursive
+				auto procedure = AST_CAST(Ast_Procedure, proc);
+				procedure->recursive = false;
+				function_bindings[procedure->id->symbol] = (int32_t)root->functions.size();
+				root->functions.push_back(procedure);
+
+				resolving = procedure;
+				PushScope();
+				for (size_t i = 0; i < procedure->args.size(); i++)
+					procedure->args[i]->slot = Declare(procedure->args[i]->symbol, (int32_t)i, true);
+				if (!ResolveExpression(proc->expr, !stale))
+					stale->push_back(proc);
+				PopScope();
+				resolving = nullptr;
+				procedure->pure = !procedure->recursive && IsPure(procedure->expr);
+
+				if (procedure->recursive)
+					EMBER_LOG_ERROR("Procedure '%.*s' on line %d calls itself and can never return, its calls evaluate to NaN.", (int)procedure->id->Name().size(), procedure->id->Name().data(), procedure->line);
+				continue;
+			}
+
+			if (!ResolveExpression(proc->expr, !stale))
+				stale->push_back(proc);
+			if (proc->type != AST_ASSIGNMENT || !proc->id)
+				continue;
+
+			proc->id->slot = SLOT_NONE;
+			if (std::find(reserved.begin(), reserved.end(), proc->id->symbol) != reserved.end())
+				continue;
+			proc->id->slot = Declare(proc->id->symbol, (int32_t)root->definitions.size());
+			root->definitions.push_back(proc);
+		}
+		PopScope();
+		root->slots = (uint32_t)root->definitions.size();
+	}
+
+	void Parser::Reserve(std::string_view name) {
+		uint32_t symbol = Interner::Global().Intern(name);
+		if (std::find(reserved.begin(), reserved.end(), symbol) == reserved.end())
+			reserved.push_back(symbol);
+	}
+
+	void Parser::PushScope() {
+		scopes.emplace_back();
+	}
+
+	//Restores whatever the scope's declarations shadowed, newest first
+	void Parser::PopScope() {
+		auto& scope = scopes.back();
+		for (size_t i = scope.size(); i-- > 0;)
+			bindings[scope[i].first] = scope[i].second;
+		scopes.pop_back();
+	}
+
+	int32_t Parser::Declare(uint32_t symbol, int32_t slot, bool local) {
+		if (bindings.size() <= symbol)
+			bindings.resize(symbol + 1);
+		scopes.back().push_back({ symbol, bindings[symbol] });
+		bindings[symbol].slot = slot;
+		bindings[symbol].local = local;
+		return slot;
+	}
+
+	bool Parser::ResolveExpression(Ast_Expression* expr, bool overwrite) {
+		if (!expr)
+			return true;
+
+		switch (expr->type) {
+		case AST_UNARY:
+			return ResolveExpression(AST_CAST(Ast_UnaryExpression, expr)->next, overwrite);
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			bool resolved = true;
+			if (p->ident) {
+				Binding binding = (p->ident->symbol < bindings.size()) ? bindings[p->ident->symbol] : Binding();
+				if (p->ident->slot != SLOT_UNRESOLVED && (p->ident->slot != binding.slot || p->ident->local != binding.local) && !overwrite)
+					return false;
+				p->ident->slot = binding.slot;
+				p->ident->local = binding.local;
+			}
+			if (p->call) {
+				int32_t procedure = (p->call->id->symbol < function_bindings.size()) ? function_bindings[p->call->id->symbol] : SLOT_NONE;
+				if (p->call->procedure != SLOT_UNRESOLVED && p->call->procedure != procedure && !overwrite)
+					return false;
+				p->call->procedure = procedure;
+				p->call->builtin = (procedure < 0) ? Builtins::Find(p->call->id->symbol) : SLOT_NONE;
+				if (resolving && procedure >= 0 && root->functions[procedure] == resolving)
+					resolving->recursive = true;
+
+				//A built-in given the wrong arguments is unbound, so every evaluator treats it like a call to nothing
+				std::string_view name = p->call->id->Name();
+				size_t expected = (procedure >= 0) ? root->functions[procedure]->args.size() : (p->call->builtin >= 0) ? Builtins::Get(p->call->builtin).args : 0;
+				if (procedure < 0 && p->call->builtin < 0) {
+					EMBER_LOG_ERROR("Call to undefined procedure '%.*s' on line %d evaluates to NaN.", (int)name.size(), name.data(), p->call->line);
+				}
+				else if (p->call->args.size() != expected) {
+					EMBER_LOG_ERROR("'%.*s' on line %d takes %zu arguments but is given %zu, the call evaluates to NaN.", (int)name.size(), name.data(), p->call->line, expected, p->call->args.size());
+					p->call->builtin = SLOT_NONE;
+				}
+				for (auto arg : p->call->args)
+					resolved = ResolveExpression(arg, overwrite) && resolved;
+			}
+			return ResolveExpression(p->nested, overwrite) && resolved;
+		}
+		case AST_BINARY: {
+			bool left = ResolveExpression(AST_CAST(Ast_BinaryExpression, expr)->left, overwrite);
+			return ResolveExpression(AST_CAST(Ast_BinaryExpression, expr)->right, overwrite) && left;
+		}
+		case AST_MATRIX: {
+			bool resolved = true;
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				resolved = ResolveExpression(element, overwrite) && resolved;
+			return resolved;
+		}
+		}
+		return true;
+	}
+
+	//Built-ins and calls that resolved to nothing (those evaluate to zero) cannot make a body impure
+	bool Parser::IsPure(Ast_Expression* expr) {
+		if (!expr)
+			return true;
+
+		switch (expr->type) {
+		case AST_UNARY:
+			return IsPure(AST_CAST(Ast_UnaryExpression, expr)->next);
+		case AST_PRIMARY: {
+			auto p = AST_CAST(Ast_PrimaryExpression, expr);
+			if (p->ident && !p->ident->local)
+				return false;
+			if (p->call) {
+				Ast_Procedure* callee = root->Callee(p->call);
+				if (callee && !callee->pure)
+					return false;
+				for (auto arg : p->call->args)
+					if (!IsPure(arg))
+						return false;
+			}
+			return IsPure(p->nested);
 		}
+		case AST_BINARY:
+			return IsPure(AST_CAST(Ast_BinaryExpression, expr)->left) && IsPure(AST_CAST(Ast_BinaryExpression, expr)->right);
+		case AST_MATRIX:
+			for (auto element : AST_CAST(Ast_MatrixExpression, expr)->elements)
+				if (!IsPure(element))
+					return false;
+			return true;
+		}
+		return true;
 	}
 
 	Token* Parser::Peek() {
-		return (!AtEnd()) ? &lexer->Tokens()[token_index] : nullptr;
+		return (!AtEnd()) ? &tokens[token_index] : nullptr;
 	}
 
 	Token* Parser::PeekOff(int off) {
-		return (token_index + off < lexer->Tokens().size()) ? &lexer->Tokens()[token_index + off] : nullptr;
+		return (token_index + off < token_count) ? &tokens[token_index + off] : nullptr;
 	}
 
 	Token* Parser::Advance() {
-		return (!AtEnd()) ? &lexer->Tokens()[token_index++] : nullptr;
+		return (!AtEnd()) ? &tokens[token_index++] : nullptr;
 	}
 
 	bool Parser::Match(int type) {
@@ -156,11 +440,11 @@ namespace MatLib {
 	}
 
 	Token* Parser::Previous() {
-		return &lexer->Tokens()[token_index - 1];
+		return &tokens[token_index - 1];
 	}
 
 	bool Parser::AtEnd() {
-		return !(token_index < lexer->Tokens().size());
+		return !(token_index < token_count);
 	}
 
 	Ast* Parser::DefaultAst(Ast* ast) {
@@ -173,7 +457,7 @@ namespace MatLib {
 	}
 
 	void Parser::Destroy() {
-		delete root;
+		arena.Reset();
 		root = nullptr;
 	}
 
@@ -181,14 +465,23 @@ namespace MatLib {
 		if (root) {
 			for (auto& proc : root->procedures) {
 				switch (proc->type) {
-				case AST_ASSIGNMENT:
+				case AST_ASSIGNMENT: {
 					auto assign = AST_CAST(Ast_Assignment, proc);
-					printf("Assignment: %s\n", assign->id->id.c_str());
+					printf("Assignment: %.*s\n", (int)assign->id->Name().size(), assign->id->Name().data());
 					if (assign->expr) {
 						VisualizeExpression(assign->expr);
 					}
 					break;
 				}
+				case AST_RELATION:
+					printf("Relation:\n");
+					VisualizeExpression(proc->expr);
+					break;
+				case AST_PROCEDURE:
+					printf("Procedure: %.*s (%zu args)\n", (int)proc->id->Name().size(), proc->id->Name().data(), AST_CAST(Ast_Procedure, proc)->args.size());
+					VisualizeExpression(proc->expr);
+					break;
+				}
 			}
 		}
 	}
@@ -212,6 +505,11 @@ namespace MatLib {
 					printf("Nested: \n");
 					VisualizeExpression(p->nested, indent + 1);
 				}
+				else if (p->call) {
+					printf("Call: %.*s%s\n", (int)p->call->id->Name().size(), p->call->id->Name().data(), (p->call->builtin >= 0) ? " (built-in)" : "");
+					for (auto arg : p->call->args)
+						VisualizeExpression(arg, indent + 1);
+				}
 				else
 					printf("Primary: %f\n", p->num_const);
 				break;
@@ -224,6 +522,14 @@ namespace MatLib {
 				VisualizeExpression(b->right, indent + 1);
 				break;
 			}
+			case AST_MATRIX: {
+				auto m = AST_CAST(Ast_MatrixExpression, expr);
+				Ident(indent);
+				printf("Matrix: %ux%u\n", m->rows, m->cols);
+				for (auto element : m->elements)
+					VisualizeExpression(element, indent + 1);
+				break;
+			}
 			}
 		}
 	}
@@ -2,6 +2,10 @@
 #define PARSER_H
 
 #include "Lexer.h"
+#include "Arena.h"
+#include "Interner.h"
+
+#include <unordered_map>
 
 namespace MatLib {
 	struct Ast_Expression;
@@ -12,7 +16,9 @@ namespace MatLib {
 		AST_UNARY,
 		AST_PRIMARY,
 		AST_BINARY,
+		AST_MATRIX,
 		AST_ASSIGNMENT,
+		AST_RELATION,
 		AST_PROCEDURE,
 		AST_PROCEDURE_CALL,
 		AST_STATEMENT,
@@ -42,22 +48,35 @@ namespace MatLib {
 		AST_UNARY_NONE
 	};
 
+	//Every node lives in the parser's arena, so nodes never free their children
 	struct Ast {
 		uint32_t line = 0;
 		int type = 0;
 	};
 
+	constexpr int32_t SLOT_NONE = -1;
+	constexpr int32_t SLOT_UNRESOLVED = -2;
+	constexpr uint32_t PROCEDURE_MAX_ARGS = 8;
+
+	//slot is the frame slot the name resolved to, SLOT_NONE for inputs and names never assigned.
+	//Local names are procedure parameters and index the call frame rather than the script's environment
 	struct Ast_Identifier : public Ast {
 		Ast_Identifier() { type = AST_ID; }
-		std::string id = "";
+		uint32_t symbol = SYMBOL_NONE;
+		int32_t slot = SLOT_UNRESOLVED;
+		bool local = false;
+
+		std::string_view Name() const { return Interner::Global().Name(symbol); }
 	};
 
+	//builtin indexes the built-in function table when no procedure of that name is in scope
 	struct Ast_ProcedureCall : public Ast {
 		Ast_ProcedureCall() { type = AST_PROCEDURE_CALL; }
-		~Ast_ProcedureCall() { delete id; }
 
 		Ast_Identifier* id = nullptr;
-		std::vector<Ast_Expression> args;
+		std::vector<Ast_Expression*> args;
+		int32_t procedure = SLOT_UNRESOLVED;
+		int32_t builtin = SLOT_NONE;
 	};
 
 	struct Ast_Expression : public Ast {
@@ -66,9 +85,10 @@ namespace MatLib {
 
 	struct Ast_PrimaryExpression : public Ast_Expression {
 		Ast_PrimaryExpression() { type = AST_PRIMARY; }
-		~Ast_PrimaryExpression() { delete ident; delete call; }
 
 		double num_const = 0.0;
+		//The number as written, copied into the arena; empty for constants the optimizer or differentiator made
+		std::string_view literal;
 		Ast_Identifier* ident = nullptr;
 		Ast_ProcedureCall* call = nullptr;
 		Ast_Expression* nested = nullptr;
@@ -77,7 +97,6 @@ namespace MatLib {
 	struct Ast_BinaryExpression : public Ast_Expression {
 		Ast_BinaryExpression() { type = AST_BINARY; }
 		Ast_BinaryExpression(Ast_Expression* left, int op, Ast_Expression* right) : left(left), op(op), right(right) { type = AST_BINARY; }
-		~Ast_BinaryExpression() { delete left; delete right; }
 
 		int op = AST_OPERATOR_NONE;
 
@@ -99,9 +118,17 @@ namespace MatLib {
 		int op = AST_UNARY_NONE;
 	};
 
+	//[a, b; c, d] with commas between columns and semicolons between rows, elements are stored row by row
+	struct Ast_MatrixExpression : public Ast_Expression {
+		Ast_MatrixExpression() { type = AST_MATRIX; }
+
+		uint32_t rows = 0;
+		uint32_t cols = 0;
+		std::vector<Ast_Expression*> elements;
+	};
+
 	struct Ast_Statement : public Ast {
 		Ast_Statement() { type = AST_STATEMENT; }
-		~Ast_Statement() { delete expr; delete id; }
 
 		Ast_Identifier* id = nullptr;
 		Ast_Expression* expr = nullptr;
@@ -111,24 +138,41 @@ namespace MatLib {
 		Ast_Assignment() { type = AST_ASSIGNMENT; }
 	};
 
+	//lhs = rhs where lhs is not a lone identifier, stored as expr = lhs - rhs with no id
+	struct Ast_Relation : public Ast_Statement {
+		Ast_Relation() { type = AST_RELATION; }
+	};
+
+	//name(args) = expr, without conditionals a procedure that calls itself can never return.
+	//Pure procedures read only their parameters and call only pure procedures, so equal arguments give equal results
 	struct Ast_Procedure : public Ast_Statement {
 		Ast_Procedure() { type = AST_PROCEDURE; }
-		~Ast_Procedure() { for (size_t i = 0; i < args.size(); i++) delete args[i]; }
 
 		std::vector<Ast_Identifier*> args;
+		bool recursive = false;
+		bool pure = false;
 	};
 
 	struct Ast_Script : public Ast {
 		Ast_Script() { type = AST_SCRIPT; }
-		~Ast_Script() { for (size_t i = 0; i < procedures.size(); i++) delete procedures[i]; }
 
 		std::vector<Ast_Statement*> procedures;
+		std::vector<Ast_Statement*> definitions;
+		std::vector<Ast_Procedure*> functions;
+		uint32_t slots = 0;
+
+		//Null for calls that resolved to nothing, to a recursive procedure or with the wrong argument count, those
+		//evaluate to NaN
+		Ast_Procedure* Callee(Ast_ProcedureCall* call) const {
+			if (!call || call->procedure < 0 || (size_t)call->procedure >= functions.size())
+				return nullptr;
+			Ast_Procedure* callee = functions[call->procedure];
+			return (callee->recursive || callee->args.size() != call->args.size()) ? nullptr : callee;
+		}
 	};
 
-#define AST_NEW(type) \
-    static_cast<type*>(DefaultAst(new type))
-
-#define AST_DELETE(type) delete type
+#define AST_NEW(type, ...) \
+    static_cast<type*>(DefaultAst(arena.New<type>(__VA_ARGS__)))
 
 #define AST_CAST(type, base) static_cast<type*>(base)
 
@@ -140,6 +184,10 @@ namespace MatLib {
 		void Destroy();
 
 		void Run();
+		void Begin();
+		void ParseTokens(Token* tokens, size_t count, std::vector<Ast_Statement*>& statements);
+		void Resolve(std::vector<Ast_Statement*>* stale = nullptr);
+		void Reserve(std::string_view name);
 		void Visualize();
 		void VisualizeExpression(Ast_Expression* expr, int indent = 1);
 		void Ident(int indent);
@@ -153,20 +201,44 @@ namespace MatLib {
 		bool Match(int type);
 		bool Check(int type);
 		Ast_Script* Root() { return root; }
+		Arena& AstArena() { return arena; }
+		const ArenaStatistics& AllocationStatistics() const { return arena.Statistics(); }
 	private:
-		std::vector<std::unordered_map<Ast_Identifier, double>> symbols;
 		Lexer* lexer = nullptr;
 		Ast_Script* root = nullptr;
+		Arena arena;
+		Token* tokens = nullptr;
+		uint32_t token_count = 0;
 		uint32_t token_index = 0;
+
+		std::vector<uint32_t> reserved = { Interner::Global().Intern("x"), Interner::Global().Intern("y") };
+		struct Binding {
+			int32_t slot = SLOT_NONE;
+			bool local = false;
+		};
+
+		std::vector<Binding> bindings;
+		std::vector<std::vector<std::pair<uint32_t, Binding>>> scopes;
+		std::vector<int32_t> function_bindings;
+		Ast_Procedure* resolving = nullptr;
 	private:
 		Ast_Statement* ParseStatement();
 		Ast_Identifier* ParseId();
 		Ast_Expression* ParseExpression();
 		Ast_Expression* ParseUnary();
 		Ast_Expression* ParsePrimary();
+		Ast_Expression* ParsePower();
 		Ast_Expression* ParseFactor();
 		Ast_ProcedureCall* ParseProcedureCall();
+		Ast_Expression* ParseMatrix();
 		int TokenTypeToAstType(Token* token);
+
+		void PushScope();
+		void PopScope();
+		int32_t Declare(uint32_t symbol, int32_t slot, bool local = false);
+		bool IsProcedureDefinition();
+		bool ResolveExpression(Ast_Expression* expr, bool overwrite);
+		bool IsPure(Ast_Expression* expr);
 	};
 }
 
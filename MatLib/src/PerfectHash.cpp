@@ -0,0 +1,66 @@
+#include "PerfectHash.h"
+#include "Logger.h"
+
+#include <cstring>
+
+namespace MatLib {
+	PerfectHash::PerfectHash() : slots(1), seed(0), mask(0) { }
+
+	//Rebuilds the table with the new key, trying seeds before growing so the table stays within 4x the key count
+	bool PerfectHash::Insert(std::string_view key, int value) {
+		if (key.empty() || key.size() > PERFECT_HASH_KEY_LENGTH || value == 0) {
+			EMBER_LOG_ERROR("Perfect hash keys must be 1 to %zu characters with a non zero value.", PERFECT_HASH_KEY_LENGTH);
+			return false;
+		}
+
+		std::vector<Slot> keys;
+		for (auto& slot : slots) {
+			if (!slot.value)
+				continue;
+			if (slot.length == key.size() && memcmp(slot.text, key.data(), key.size()) == 0)
+				continue;
+			keys.push_back(slot);
+		}
+
+		Slot added;
+		memcpy(added.text, key.data(), key.size());
+		added.length = (uint8_t)key.size();
+		added.value = value;
+		keys.push_back(added);
+
+		for (size_t size = 8; ; size *= 2) {
+			if (size < keys.size() * 2)
+				continue;
+			for (uint32_t attempt = 1; attempt <= 256; attempt++) {
+				uint32_t candidate = attempt * 0x9E3779B9u;
+				std::vector<Slot> table(size);
+				bool placed = true;
+				for (auto& slot : keys) {
+					if (!Place(table, candidate, slot)) {
+						placed = false;
+						break;
+					}
+				}
+
+				if (placed) {
+					slots = std::move(table);
+					seed = candidate;
+					mask = (uint32_t)size - 1;
+					count = keys.size();
+					max_length = 0;
+					for (auto& slot : keys)
+						max_length = (slot.length > max_length) ? slot.length : max_length;
+					return true;
+				}
+			}
+		}
+	}
+
+	bool PerfectHash::Place(std::vector<Slot>& table, uint32_t table_seed, const Slot& slot) const {
+		Slot& target = table[Hash(std::string_view(slot.text, slot.length), table_seed) & (table.size() - 1)];
+		if (target.value)
+			return false;
+		target = slot;
+		return true;
+	}
+}
\ No newline at end of file
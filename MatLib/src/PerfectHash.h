@@ -0,0 +1,50 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace MatLib {
+	constexpr size_t PERFECT_HASH_KEY_LENGTH = 15;
+
+	//Maps short keys to token types with no collisions, the seed is searched again on every Insert so Find is one hash,
+	//one slot and one compare. Keys are stored inline in the slots, so lookups never touch the heap or chase pointers
+	class PerfectHash {
+	public:
+		PerfectHash();
+
+		bool Insert(std::string_view key, int value);
+		int Find(std::string_view key) const {
+			const Slot& slot = slots[Hash(key, seed) & mask];
+			return (slot.length == key.size() && slot.value && memcmp(slot.text, key.data(), key.size()) == 0) ? slot.value : 0;
+		}
+
+		size_t Size() const { return count; }
+		size_t MaxLength() const { return max_length; }
+	private:
+		struct Slot {
+			char text[PERFECT_HASH_KEY_LENGTH] = { 0 };
+			uint8_t length = 0;
+			int value = 0;
+		};
+
+		std::vector<Slot> slots;
+		uint32_t seed = 0;
+		uint32_t mask = 0;
+		size_t count = 0;
+		size_t max_length = 0;
+	private:
+		static uint32_t Hash(std::string_view key, uint32_t seed) {
+			uint32_t h = seed ^ (uint32_t)key.size();
+			for (char c : key)
+				h = (h ^ (uint8_t)c) * 16777619u;
+			return h ^ (h >> 15);
+		}
+
+		bool Place(std::vector<Slot>& table, uint32_t table_seed, const Slot& slot) const;
+	};
+}
+
+#endif // !PERFECT_HASH_H
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "Plotter.h"
+
+namespace MatLib {
+	static const glm::vec4 PLOT_COLORS[] = {
+		{ 0.95f, 0.35f, 0.3f, 1.0f },
+		{ 0.3f, 0.8f, 0.4f, 1.0f },
+		{ 0.95f, 0.8f, 0.3f, 1.0f },
+		{ 0.75f, 0.45f, 0.95f, 1.0f }
+	};
+
+	CurvePlotter::CurvePlotter(FunctionSolver* solver) {
+		this->solver = solver;
+		domain = DomainColoring(solver, &pool);
+	}
+
+	//Call after every compile so there is one sampler per assignment and relation
+	void CurvePlotter::Reset() {
+		samplers.clear();
+		implicits.clear();
+		domain.Reset();
+		if (!solver)
+			return;
+
+		for (size_t i = 0; i < solver->GetProgram().assignments.size(); i++) {
+			samplers.push_back(AdaptiveSampler(solver));
+			samplers.back().SetFunction(i);
+			samplers.back().SetView(view);
+		}
+
+		for (size_t i = 0; i < solver->GetProgram().relations.size(); i++) {
+			implicits.push_back(ImplicitSampler(solver, &pool));
+			implicits.back().SetRelation(i);
+			implicits.back().SetView(view);
+		}
+	}
+
+	//A new view resets every sampler, the same view keeps the refinement done so far
+	void CurvePlotter::SetView(const SamplerView& view) {
+		if (view == this->view)
+			return;
+		this->view = view;
+		for (auto& sampler : samplers)
+			sampler.SetView(view);
+		for (auto& implicit : implicits)
+			implicit.SetView(view);
+		domain.SetView(view);
+	}
+
+	void CurvePlotter::Update(uint32_t budget) {
+		uint32_t share = (budget && !samplers.empty()) ? (budget + (uint32_t)samplers.size() - 1) / (uint32_t)samplers.size() : 0;
+		for (auto& sampler : samplers)
+			sampler.Sample(share);
+		for (auto& implicit : implicits)
+			implicit.Sample();
+	}
+
+	void CurvePlotter::Draw(Ember::Renderer* renderer) {
+		Ember::Mesh mesh;
+		Ember::Vertex vertex;
+		vertex.texture_coordinates = { 0.0f, 0.0f };
+		vertex.texture_id = -1.0f;
+		vertex.material_id = 0.0f;
+
+		//Far off-screen values are pulled in so they survive the conversion to float
+		double margin = 4.0 * (view.y1 - view.y0);
+		auto clamp = [&](double y) { return (float)((y < view.y0 - margin) ? view.y0 - margin : (y > view.y1 + margin) ? view.y1 + margin : y); };
+
+		for (size_t i = 0; i < samplers.size(); i++) {
+			vertex.color = PLOT_COLORS[i % (sizeof(PLOT_COLORS) / sizeof(PLOT_COLORS[0]))];
+			samplers[i].ForEachSegment([&](const SamplePoint& a, const SamplePoint& b) {
+				vertex.position = { (float)a.x, clamp(a.y), 0.0f };
+				mesh.vertices.push_back(vertex);
+				vertex.position = { (float)b.x, clamp(b.y), 0.0f };
+				mesh.vertices.push_back(vertex);
+
+				if (mesh.vertices.size() >= PLOT_MESH_VERTICES)
+					Submit(renderer, mesh);
+			});
+		}
+
+		for (size_t i = 0; i < implicits.size(); i++) {
+			vertex.color = PLOT_COLORS[(samplers.size() + i) % (sizeof(PLOT_COLORS) / sizeof(PLOT_COLORS[0]))];
+			for (auto& segment : implicits[i].Segments()) {
+				vertex.position = { (float)segment.x0, (float)segment.y0, 0.0f };
+				mesh.vertices.push_back(vertex);
+				vertex.position = { (float)segment.x1, (float)segment.y1, 0.0f };
+				mesh.vertices.push_back(vertex);
+
+				if (mesh.vertices.size() >= PLOT_MESH_VERTICES)
+					Submit(renderer, mesh);
+			}
+		}
+
+		if (!mesh.vertices.empty())
+			Submit(renderer, mesh);
+	}
+
+	//Indices are relative to the batch, so a full batch is flushed before the mesh is indexed against it
+	void CurvePlotter::Submit(Ember::Renderer* renderer, Ember::Mesh& mesh) {
+		auto gd = renderer->GetGraphicsDevice();
+		if (gd->IndexOffset() + mesh.vertices.size() > Ember::MAX_INDEX_COUNT / 2) {
+			renderer->EndScene();
+			gd->Setup();
+		}
+
+		uint32_t base = gd->IndexOffset();
+		mesh.indices.clear();
+		for (uint32_t i = 0; i < mesh.vertices.size(); i++)
+			mesh.indices.push_back(base + i);
+
+		renderer->Submit(mesh);
+		mesh.vertices.clear();
+		mesh.indices.clear();
+	}
+
+	SamplerStatistics CurvePlotter::Statistics() const {
+		SamplerStatistics total;
+		for (auto& sampler : samplers) {
+			total.evaluations += sampler.Statistics().evaluations;
+			total.points += sampler.Statistics().points;
+			total.pending += sampler.Statistics().pending;
+			total.breaks += sampler.Statistics().breaks;
+		}
+		return total;
+	}
+
+	ImplicitStatistics CurvePlotter::ImplicitStats() const {
+		ImplicitStatistics total;
+		for (auto& implicit : implicits) {
+			total.cells += implicit.Statistics().cells;
+			total.culled += implicit.Statistics().culled;
+			total.leaves += implicit.Statistics().leaves;
+			total.segments += implicit.Statistics().segments;
+			total.evaluations += implicit.Statistics().evaluations;
+			total.milliseconds += implicit.Statistics().milliseconds;
+		}
+		return total;
+	}
+}
\ No newline at end of file
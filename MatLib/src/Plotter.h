@@ -0,0 +1,39 @@
+#ifndef PLOTTER_H
+#define PLOTTER_H
+
+#include "AdaptiveSampler.h"
+#include "ImplicitSampler.h"
+#include "DomainColoring.h"
+#include "Renderer.h"
+
+namespace MatLib {
+	constexpr uint32_t PLOT_MESH_VERTICES = 128;
+
+	class CurvePlotter {
+	public:
+		CurvePlotter() = default;
+		CurvePlotter(FunctionSolver* solver);
+
+		void Reset();
+		void SetView(const SamplerView& view);
+		void Update(uint32_t budget = 0);
+		void Draw(Ember::Renderer* renderer);
+
+		SamplerStatistics Statistics() const;
+		ImplicitStatistics ImplicitStats() const;
+		std::vector<AdaptiveSampler>& Samplers() { return samplers; }
+		std::vector<ImplicitSampler>& Implicits() { return implicits; }
+		DomainColoring& Domain() { return domain; }
+	private:
+		FunctionSolver* solver = nullptr;
+		SamplerView view;
+		ThreadPool pool;
+		std::vector<AdaptiveSampler> samplers;
+		std::vector<ImplicitSampler> implicits;
+		DomainColoring domain;
+	private:
+		void Submit(Ember::Renderer* renderer, Ember::Mesh& mesh);
+	};
+}
+
+#endif // !PLOTTER_H
\ No newline at end of file
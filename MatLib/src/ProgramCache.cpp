@@ -0,0 +1,91 @@
+#include "ProgramCache.h"
+
+namespace MatLib {
+	ProgramCache::ProgramCache(size_t budget) {
+		this->budget = budget;
+	}
+
+	uint64_t ProgramCache::Hash(std::string_view source, uint64_t options) {
+		uint64_t h = 0xcbf29ce484222325ull ^ options;
+		for (char c : source) {
+			h ^= (uint8_t)c;
+			h *= 0x100000001b3ull;
+		}
+		return h;
+	}
+
+	static size_t ChunkBytes(const Chunk& chunk) {
+		return sizeof(Chunk) + chunk.code.capacity() * sizeof(Instruction) + chunk.constants.capacity() * sizeof(double);
+	}
+
+	size_t ProgramCache::ProgramBytes(const Program& program) {
+		size_t bytes = sizeof(Program);
+		for (auto& assignment : program.assignments)
+			bytes += sizeof(CompiledAssignment) + assignment.id.capacity() + ChunkBytes(assignment.chunk);
+		for (auto& relation : program.relations)
+			bytes += sizeof(CompiledAssignment) + relation.id.capacity() + ChunkBytes(relation.chunk);
+		return bytes;
+	}
+
+	//A hit moves the entry to the front, so the back of the list is always the next to go
+	const Program* ProgramCache::Find(std::string_view source, uint64_t options) {
+		auto it = lookup.find(Hash(source, options));
+		if (it == lookup.end() || it->second->options != options || it->second->source != source) {
+			stats.misses++;
+			return nullptr;
+		}
+
+		entries.splice(entries.begin(), entries, it->second);
+		stats.hits++;
+		return &entries.front().program;
+	}
+
+	void ProgramCache::Insert(std::string_view source, uint64_t options, const Program& program) {
+		uint64_t hash = Hash(source, options);
+		auto it = lookup.find(hash);
+		if (it != lookup.end()) {
+			stats.bytes -= it->second->bytes;
+			entries.erase(it->second);
+			lookup.erase(it);
+		}
+
+		Entry entry;
+		entry.hash = hash;
+		entry.options = options;
+		entry.source = std::string(source);
+		entry.program = program;
+		entry.bytes = sizeof(Entry) + entry.source.capacity() + ProgramBytes(entry.program);
+		//Too large to ever fit, the entry it replaces is already gone so the count has to follow
+		if (entry.bytes > budget) {
+			stats.entries = entries.size();
+			return;
+		}
+
+		stats.bytes += entry.bytes;
+		entries.push_front(std::move(entry));
+		lookup[hash] = entries.begin();
+		Evict();
+	}
+
+	void ProgramCache::SetBudget(size_t budget) {
+		this->budget = budget;
+		Evict();
+	}
+
+	void ProgramCache::Clear() {
+		entries.clear();
+		lookup.clear();
+		stats.bytes = 0;
+		stats.entries = 0;
+	}
+
+	void ProgramCache::Evict() {
+		while (stats.bytes > budget && !entries.empty()) {
+			stats.bytes -= entries.back().bytes;
+			lookup.erase(entries.back().hash);
+			entries.pop_back();
+			stats.evictions++;
+		}
+		stats.entries = entries.size();
+	}
+}
\ No newline at end of file
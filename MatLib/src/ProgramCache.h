@@ -0,0 +1,64 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include "Compiler.h"
+
+#include <list>
+
+namespace MatLib {
+	constexpr size_t PROGRAM_CACHE_BUDGET = 4 * 1024 * 1024;
+
+	//Bits of the options word, anything that changes the program compiled from the same source belongs in it. The
+	//numeric mode goes in above PROGRAM_MODE_SHIFT
+	enum : uint64_t {
+		PROGRAM_DERIVATIVES = 1 << 0,
+		PROGRAM_EXACT = 1 << 1,
+		PROGRAM_ORDERED_PRODUCTS = 1 << 2,
+		PROGRAM_DOMAIN_COLORING = 1 << 3,
+	};
+
+	constexpr uint32_t PROGRAM_MODE_SHIFT = 8;
+
+	struct ProgramCacheStatistics {
+		uint32_t hits = 0;
+		uint32_t misses = 0;
+		uint32_t evictions = 0;
+		size_t entries = 0;
+		size_t bytes = 0;
+	};
+
+	//Least recently used map from source text to its compiled program. Entries are keyed by a hash of the source and the
+	//compile options, the source itself is kept to rule out collisions and counts against the budget with the bytecode
+	class ProgramCache {
+	public:
+		ProgramCache(size_t budget = PROGRAM_CACHE_BUDGET);
+
+		const Program* Find(std::string_view source, uint64_t options = 0);
+		void Insert(std::string_view source, uint64_t options, const Program& program);
+		void SetBudget(size_t budget);
+		void Clear();
+
+		static uint64_t Hash(std::string_view source, uint64_t options);
+		static size_t ProgramBytes(const Program& program);
+
+		size_t Budget() const { return budget; }
+		const ProgramCacheStatistics& Statistics() const { return stats; }
+	private:
+		struct Entry {
+			uint64_t hash = 0;
+			uint64_t options = 0;
+			std::string source;
+			Program program;
+			size_t bytes = 0;
+		};
+
+		size_t budget = PROGRAM_CACHE_BUDGET;
+		std::list<Entry> entries;
+		std::unordered_map<uint64_t, std::list<Entry>::iterator> lookup;
+		ProgramCacheStatistics stats;
+	private:
+		void Evict();
+	};
+}
+
+#endif // !PROGRAM_CACHE_H
\ No newline at end of file
@@ -0,0 +1,330 @@
+#include "Rational.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace MatLib {
+	static const Natural ONE = { 1 };
+
+	static bool IsOne(const Natural& a) {
+		return a.size() == 1 && a[0] == 1;
+	}
+
+	//x - y or x + y of two signed magnitudes, zero is never negative
+	static Natural SignedSum(const Natural& x, bool x_negative, const Natural& y, bool y_negative, bool& negative) {
+		Natural sum;
+		if (x_negative == y_negative) {
+			sum = Limbs::Add(x, y);
+			negative = x_negative;
+		}
+		else if (Limbs::Compare(x, y) >= 0) {
+			sum = Limbs::Sub(x, y);
+			negative = x_negative;
+		}
+		else {
+			sum = Limbs::Sub(y, x);
+			negative = y_negative;
+		}
+		if (sum.empty())
+			negative = false;
+		return sum;
+	}
+
+	//Same shortest round trip decimal as BigFloat, so the literal 0.1 is 1/10. Integers are read from their bits
+	Rational::Rational(double value) {
+		if (std::isnan(value) || std::isinf(value)) {
+			nan = true;
+			return;
+		}
+		if (value != floor(value)) {
+			char text[32];
+			for (int precision = 15; precision <= 17; precision++) {
+				snprintf(text, sizeof(text), "%.*g", precision, value);
+				if (strtod(text, nullptr) == value)
+					break;
+			}
+			*this = Parse(text);
+			return;
+		}
+		if (value == 0.0)
+			return;
+
+		int e = 0;
+		uint64_t bits = (uint64_t)ldexp(frexp(fabs(value), &e), 53);
+		e -= 53;
+		numerator = (e >= 0) ? Limbs::ShiftLeft(Limbs::FromUint64(bits), (size_t)e) : Limbs::FromUint64(bits >> -e);
+		negative = value < 0.0;
+	}
+
+	Rational Rational::NaN() {
+		Rational r;
+		r.nan = true;
+		return r;
+	}
+
+	void Rational::Reduce() {
+		if (numerator.empty()) {
+			denominator = ONE;
+			negative = false;
+			return;
+		}
+		Natural g = Limbs::Gcd(numerator, denominator);
+		if (!IsOne(g)) {
+			numerator = Limbs::Quotient(numerator, g);
+			denominator = Limbs::Quotient(denominator, g);
+		}
+	}
+
+	bool Rational::Oversized() const {
+		return Limbs::BitLength(numerator) > RATIONAL_MAX_BITS || Limbs::BitLength(denominator) > RATIONAL_MAX_BITS;
+	}
+
+	//Reads sign, digits, an optional fraction and an optional exponent, a '/' divides two such numbers
+	Rational Rational::Parse(std::string_view text) {
+		size_t slash = text.find('/');
+		if (slash != std::string_view::npos)
+			return Parse(text.substr(0, slash)) / Parse(text.substr(slash + 1));
+
+		size_t i = 0;
+		while (i < text.size() && (text[i] == ' ' || text[i] == '\t'))
+			i++;
+		bool minus = false;
+		if (i < text.size() && (text[i] == '-' || text[i] == '+'))
+			minus = text[i++] == '-';
+
+		Natural digits;
+		uint32_t chunk = 0, chunk_digits = 0;
+		int64_t scale = 0;
+		bool any = false, fraction = false;
+		static const uint32_t POWERS[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+		for (; i < text.size(); i++) {
+			char c = text[i];
+			if (c == '.' && !fraction) {
+				fraction = true;
+				continue;
+			}
+			if (c < '0' || c > '9')
+				break;
+			any = true;
+			chunk = chunk * 10 + (uint32_t)(c - '0');
+			if (++chunk_digits == 9) {
+				Limbs::MultiplySmall(digits, POWERS[9], chunk);
+				chunk = chunk_digits = 0;
+			}
+			if (fraction)
+				scale--;
+		}
+		if (!any)
+			return NaN();
+		Limbs::MultiplySmall(digits, POWERS[chunk_digits], chunk);
+
+		if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+			bool negative_exponent = false;
+			if (++i < text.size() && (text[i] == '-' || text[i] == '+'))
+				negative_exponent = text[i++] == '-';
+			int64_t e = 0;
+			for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++)
+				e = std::min<int64_t>(e * 10 + (text[i] - '0'), 1000000000);
+			scale += (negative_exponent) ? -e : e;
+		}
+
+		//10^n has more than 3.3n bits
+		uint64_t n = (uint64_t)((scale < 0) ? -scale : scale);
+		if (!digits.empty() && n * 3 > RATIONAL_MAX_BITS)
+			return NaN();
+		Natural power = ONE;
+		for (; n >= 9; n -= 9)
+			Limbs::MultiplySmall(power, POWERS[9]);
+		Limbs::MultiplySmall(power, POWERS[n]);
+
+		Rational r;
+		r.numerator = digits;
+		if (scale < 0)
+			r.denominator = power;
+		else
+			r.numerator = Limbs::Multiply(digits, power);
+		r.negative = minus;
+		r.Reduce();
+		return r;
+	}
+
+	//Both halves are scaled so the quotient keeps 64 bits, then rounded once into a double
+	double Rational::ToDouble() const {
+		if (nan)
+			return NAN;
+		if (numerator.empty())
+			return 0.0;
+		int64_t shift = 64 + (int64_t)Limbs::BitLength(denominator) - (int64_t)Limbs::BitLength(numerator);
+		Natural q, r;
+		if (shift >= 0)
+			Limbs::DivMod(Limbs::ShiftLeft(numerator, (size_t)shift), denominator, q, r);
+		else
+			Limbs::DivMod(numerator, Limbs::ShiftLeft(denominator, (size_t)-shift), q, r);
+		double v = 0.0;
+		for (size_t i = q.size(); i-- > 0;)
+			v = v * 4294967296.0 + (double)q[i];
+		shift = std::max<int64_t>(std::min<int64_t>(shift, 4096), -4096);
+		v = ldexp(v, (int)-shift);
+		return (negative) ? -v : v;
+	}
+
+	std::string Rational::ToString() const {
+		if (nan)
+			return "nan";
+		std::string text = (negative) ? "-" : "";
+		text += Limbs::ToDecimal(numerator);
+		if (!IsOne(denominator))
+			text += "/" + Limbs::ToDecimal(denominator);
+		return text;
+	}
+
+	Rational operator-(const Rational& a) {
+		Rational r = a;
+		if (!r.numerator.empty())
+			r.negative = !r.negative;
+		return r;
+	}
+
+	//Knuth's addition: with g = gcd(b, d), a/b + c/d = (a(d/g) + c(b/g)) / ((b/g) d) and only gcd(t, g) can remain
+	//in the numerator t, so the full size gcd is never taken. A running sum such as 1 + 1/2 + ... + 1/n adds a
+	//single limb denominator each step, which keeps every gcd and quotient a short division
+	Rational Rational::Add(const Rational& a, const Rational& b, bool subtract) {
+		if (a.nan || b.nan)
+			return NaN();
+		bool b_negative = b.negative != subtract && !b.numerator.empty();
+
+		Rational r;
+		if (IsOne(a.denominator) && IsOne(b.denominator)) {
+			r.numerator = SignedSum(a.numerator, a.negative, b.numerator, b_negative, r.negative);
+			return (r.Oversized()) ? NaN() : r;
+		}
+
+		Natural g = Limbs::Gcd(a.denominator, b.denominator);
+		if (IsOne(g)) {
+			r.numerator = SignedSum(Limbs::Multiply(a.numerator, b.denominator), a.negative, Limbs::Multiply(b.numerator, a.denominator), b_negative, r.negative);
+			r.denominator = (r.numerator.empty()) ? ONE : Limbs::Multiply(a.denominator, b.denominator);
+			return (r.Oversized()) ? NaN() : r;
+		}
+
+		Natural a_scale = Limbs::Quotient(a.denominator, g), b_scale = Limbs::Quotient(b.denominator, g);
+		Natural t = SignedSum(Limbs::Multiply(a.numerator, b_scale), a.negative, Limbs::Multiply(b.numerator, a_scale), b_negative, r.negative);
+		if (t.empty())
+			return r;
+		Natural h = Limbs::Gcd(t, g);
+		r.numerator = Limbs::Quotient(t, h);
+		r.denominator = Limbs::Multiply(a_scale, Limbs::Quotient(b.denominator, h));
+		return (r.Oversized()) ? NaN() : r;
+	}
+
+	Rational operator+(const Rational& a, const Rational& b) {
+		return Rational::Add(a, b, false);
+	}
+
+	Rational operator-(const Rational& a, const Rational& b) {
+		return Rational::Add(a, b, true);
+	}
+
+	//Cross cancelling first keeps both products in lowest terms with smaller operands
+	Rational operator*(const Rational& a, const Rational& b) {
+		if (a.nan || b.nan)
+			return Rational::NaN();
+		Rational r;
+		if (a.numerator.empty() || b.numerator.empty())
+			return r;
+
+		Natural g = Limbs::Gcd(a.numerator, b.denominator), h = Limbs::Gcd(b.numerator, a.denominator);
+		r.numerator = Limbs::Multiply(Limbs::Quotient(a.numerator, g), Limbs::Quotient(b.numerator, h));
+		r.denominator = Limbs::Multiply(Limbs::Quotient(a.denominator, h), Limbs::Quotient(b.denominator, g));
+		r.negative = a.negative != b.negative;
+		return (r.Oversized()) ? Rational::NaN() : r;
+	}
+
+	Rational operator/(const Rational& a, const Rational& b) {
+		if (b.nan || b.numerator.empty())
+			return Rational::NaN();
+		Rational reciprocal = b;
+		reciprocal.numerator.swap(reciprocal.denominator);
+		return a * reciprocal;
+	}
+
+	int Compare(const Rational& a, const Rational& b) {
+		if (a.nan || b.nan)
+			return 0;
+		if (a.negative != b.negative)
+			return (a.negative) ? -1 : 1;
+		int c = Limbs::Compare(Limbs::Multiply(a.numerator, b.denominator), Limbs::Multiply(b.numerator, a.denominator));
+		return (a.negative) ? -c : c;
+	}
+
+	//Powers of a fraction in lowest terms stay in lowest terms, so nothing is reduced on the way
+	Rational Rational::IntegerPower(const Rational& base, uint64_t n) {
+		if ((double)Limbs::BitLength(base.numerator) * n > RATIONAL_MAX_BITS || (double)Limbs::BitLength(base.denominator) * n > RATIONAL_MAX_BITS)
+			return NaN();
+		Rational result, square = base;
+		result.numerator = ONE;
+		for (; n; n >>= 1) {
+			if (n & 1)
+				result = result * square;
+			if (n > 1)
+				square = square * square;
+		}
+		return result;
+	}
+
+	//Exact only when numerator and denominator are both perfect squares
+	Rational Sqrt(const Rational& x) {
+		if (x.nan || x.negative)
+			return Rational::NaN();
+		Rational r;
+		r.numerator = Limbs::SquareRoot(x.numerator);
+		r.denominator = Limbs::SquareRoot(x.denominator);
+		if (Limbs::Compare(Limbs::Multiply(r.numerator, r.numerator), x.numerator) != 0 || Limbs::Compare(Limbs::Multiply(r.denominator, r.denominator), x.denominator) != 0)
+			return Rational::NaN();
+		return r;
+	}
+
+	//Integer exponents and halves of them, any other exponent has an irrational result for almost every base
+	Rational Power(const Rational& a, const Rational& b) {
+		if (a.nan || b.nan)
+			return Rational::NaN();
+		if (b.numerator.empty())
+			return Rational(1.0);
+		if (IsOne(a.numerator) && IsOne(a.denominator) && !a.negative)
+			return a;
+		if (a.numerator.empty())
+			return (b.negative) ? Rational::NaN() : a;
+		if (b.numerator.size() > 2)
+			return Rational::NaN();
+
+		Rational base = a;
+		if (b.denominator.size() == 1 && b.denominator[0] == 2)
+			base = Sqrt(a);
+		else if (!b.IsInteger())
+			return Rational::NaN();
+		if (base.nan)
+			return base;
+
+		uint64_t n = (b.numerator.size() == 1) ? b.numerator[0] : ((uint64_t)b.numerator[1] << 32) | b.numerator[0];
+		Rational result = Rational::IntegerPower(base, n);
+		return (b.negative) ? Rational(1.0) / result : result;
+	}
+
+	//The transcendental functions are rational only at the points below
+	Rational Exp(const Rational& x) {
+		return (x.IsZero()) ? Rational(1.0) : Rational::NaN();
+	}
+
+	Rational Log(const Rational& x) {
+		return (!x.IsNegative() && x.IsInteger() && x.Numerator() == Natural{ 1 }) ? Rational() : Rational::NaN();
+	}
+
+	Rational Sin(const Rational& x) {
+		return (x.IsZero()) ? Rational() : Rational::NaN();
+	}
+
+	Rational Cos(const Rational& x) {
+		return (x.IsZero()) ? Rational(1.0) : Rational::NaN();
+	}
+}
\ No newline at end of file
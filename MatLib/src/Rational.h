@@ -0,0 +1,63 @@
+#ifndef RATIONAL_H
+#define RATIONAL_H
+
+#include "Limbs.h"
+
+#include <string>
+#include <string_view>
+
+namespace MatLib {
+	//Results with a numerator or denominator longer than this are NaN rather than an unbounded allocation
+	constexpr size_t RATIONAL_MAX_BITS = 1 << 24;
+
+	//sign * numerator / denominator in lowest terms with a positive denominator, zero is 0/1.
+	//Only results that are rational and exact are kept, sqrt(2), log(2) or division by zero are NaN
+	class Rational {
+	public:
+		Rational() = default;
+		Rational(double value);
+
+		static Rational Parse(std::string_view text);
+		static Rational NaN();
+
+		bool IsZero() const { return !nan && numerator.empty(); }
+		bool IsNaN() const { return nan; }
+		bool IsNegative() const { return negative; }
+		bool IsInteger() const { return !nan && denominator.size() == 1 && denominator[0] == 1; }
+		const Natural& Numerator() const { return numerator; }
+		const Natural& Denominator() const { return denominator; }
+		double ToDouble() const;
+		std::string ToString() const;
+
+		friend Rational operator-(const Rational& a);
+		friend Rational operator+(const Rational& a, const Rational& b);
+		friend Rational operator-(const Rational& a, const Rational& b);
+		friend Rational operator*(const Rational& a, const Rational& b);
+		friend Rational operator/(const Rational& a, const Rational& b);
+		friend int Compare(const Rational& a, const Rational& b);
+
+		friend Rational Sqrt(const Rational& x);
+		friend Rational Power(const Rational& a, const Rational& b);
+	private:
+		Natural numerator;
+		Natural denominator = { 1 };
+		bool negative = false;
+		bool nan = false;
+	private:
+		void Reduce();
+		bool Oversized() const;
+
+		static Rational Add(const Rational& a, const Rational& b, bool subtract);
+		static Rational IntegerPower(const Rational& base, uint64_t n);
+	};
+
+	Rational Sqrt(const Rational& x);
+	Rational Exp(const Rational& x);
+	Rational Log(const Rational& x);
+	Rational Sin(const Rational& x);
+	Rational Cos(const Rational& x);
+	Rational Power(const Rational& a, const Rational& b);
+	inline Rational Pow(const Rational& a, const Rational& b) { return Power(a, b); }
+}
+
+#endif // !RATIONAL_H
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "SparseMatrix.h"
+
+#include <algorithm>
+
+namespace MatLib {
+	//Two counting passes, first by column then by row, leave every row's columns ascending without a comparison sort.
+	//Duplicates are then next to each other and are summed in place
+	SparseMatrix SparseMatrix::FromTriplets(uint32_t rows, uint32_t cols, const std::vector<Triplet>& triplets) {
+		SparseMatrix m(rows, cols);
+		std::vector<size_t> by_column((size_t)cols + 1, 0);
+		size_t count = 0;
+		for (auto& t : triplets) {
+			if (t.row < rows && t.col < cols) {
+				by_column[t.col + 1]++;
+				m.offsets[t.row + 1]++;
+				count++;
+			}
+		}
+		for (uint32_t j = 0; j < cols; j++)
+			by_column[j + 1] += by_column[j];
+		for (uint32_t i = 0; i < rows; i++)
+			m.offsets[i + 1] += m.offsets[i];
+
+		std::vector<Triplet> sorted(count);
+		for (auto& t : triplets)
+			if (t.row < rows && t.col < cols)
+				sorted[by_column[t.col]++] = t;
+
+		std::vector<size_t> next(m.offsets.begin(), m.offsets.end() - 1);
+		m.columns.resize(count);
+		m.values.resize(count);
+		for (auto& t : sorted) {
+			size_t k = next[t.row]++;
+			m.columns[k] = t.col;
+			m.values[k] = t.value;
+		}
+
+		size_t out = 0;
+		for (uint32_t i = 0; i < rows; i++) {
+			size_t begin = m.offsets[i], end = m.offsets[i + 1];
+			m.offsets[i] = out;
+			for (size_t k = begin; k < end; k++) {
+				if (out > m.offsets[i] && m.columns[out - 1] == m.columns[k])
+					m.values[out - 1] += m.values[k];
+				else {
+					m.columns[out] = m.columns[k];
+					m.values[out] = m.values[k];
+					out++;
+				}
+			}
+		}
+		m.offsets[rows] = out;
+		m.columns.resize(out);
+		m.values.resize(out);
+		m.columns.shrink_to_fit();
+		m.values.shrink_to_fit();
+		return m;
+	}
+
+	double SparseMatrix::At(uint32_t row, uint32_t col) const {
+		if (row >= rows)
+			return 0.0;
+		auto begin = columns.begin() + offsets[row], end = columns.begin() + offsets[row + 1];
+		auto it = std::lower_bound(begin, end, col);
+		return (it != end && *it == col) ? values[it - columns.begin()] : 0.0;
+	}
+
+	void SparseMatrix::Diagonal(double* out) const {
+		for (uint32_t i = 0; i < rows; i++)
+			out[i] = At(i, i);
+	}
+
+	void SparseMatrix::Multiply(const double* x, double* y, ThreadPool* pool) const {
+		if (!pool)
+			pool = &ThreadPool::Shared();
+
+		auto multiply = [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++) {
+				double sum = 0.0;
+				for (size_t k = offsets[i]; k < offsets[i + 1]; k++)
+					sum += values[k] * x[columns[k]];
+				y[i] = sum;
+			}
+		};
+
+		size_t jobs = std::min(values.size() / SPARSE_JOB_ENTRIES, (size_t)rows);
+		if (jobs <= 1 || pool->Threads() == 1) {
+			multiply(0, rows);
+			return;
+		}
+
+		//Job j starts at the first row holding entry j * entries / jobs
+		pool->Run(jobs, [&](size_t job, size_t /*thread*/) {
+			auto first = std::lower_bound(offsets.begin(), offsets.end() - 1, values.size() * job / jobs) - offsets.begin();
+			auto last = (job + 1 == jobs) ? (ptrdiff_t)rows : std::lower_bound(offsets.begin(), offsets.end() - 1, values.size() * (job + 1) / jobs) - offsets.begin();
+			multiply(first, last);
+		});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef SPARSE_MATRIX_H
+#define SPARSE_MATRIX_H
+
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace MatLib {
+	//Rows per parallel product job are chosen so every job covers about this many stored entries
+	constexpr size_t SPARSE_JOB_ENTRIES = 16384;
+
+	struct Triplet {
+		uint32_t row = 0;
+		uint32_t col = 0;
+		double value = 0.0;
+	};
+
+	//Compressed sparse rows: the entries of row i are values[offsets[i]] up to values[offsets[i + 1]], with columns
+	//ascending and no duplicates. Storage is one offset per row plus a column and a value per entry
+	class SparseMatrix {
+	public:
+		SparseMatrix() = default;
+		SparseMatrix(uint32_t rows, uint32_t cols) : rows(rows), cols(cols), offsets((size_t)rows + 1, 0) { }
+
+		//Duplicate positions are summed, triplets outside the shape are dropped
+		static SparseMatrix FromTriplets(uint32_t rows, uint32_t cols, const std::vector<Triplet>& triplets);
+
+		uint32_t Rows() const { return rows; }
+		uint32_t Cols() const { return cols; }
+		size_t NonZeros() const { return values.size(); }
+		size_t Bytes() const { return offsets.size() * sizeof(size_t) + columns.size() * sizeof(uint32_t) + values.size() * sizeof(double); }
+		const std::vector<size_t>& Offsets() const { return offsets; }
+		const std::vector<uint32_t>& Columns() const { return columns; }
+		const std::vector<double>& Values() const { return values; }
+		//The pattern is fixed once built, only the values may change
+		std::vector<double>& Values() { return values; }
+
+		//The stored entry at (row, col), zero when there is none
+		double At(uint32_t row, uint32_t col) const;
+		void Diagonal(double* out) const;
+
+		//y = A x on the pool (ThreadPool::Shared when null), rows are split into jobs of about equal entries so a
+		//dense band costs no more than its share. x and y must not overlap
+		void Multiply(const double* x, double* y, ThreadPool* pool = nullptr) const;
+	private:
+		uint32_t rows = 0;
+		uint32_t cols = 0;
+		std::vector<size_t> offsets;
+		std::vector<uint32_t> columns;
+		std::vector<double> values;
+	};
+
+	//Collects entries in any order, Build sorts them with two counting passes, by column and then by row, so building
+	//is linear in the entries rather than a full sort
+	class SparseBuilder {
+	public:
+		SparseBuilder() = default;
+		SparseBuilder(uint32_t rows, uint32_t cols) : rows(rows), cols(cols) { }
+
+		void Reserve(size_t entries) { triplets.reserve(entries); }
+		void Add(uint32_t row, uint32_t col, double value) { triplets.push_back({ row, col, value }); }
+		size_t Size() const { return triplets.size(); }
+		void Clear() { triplets.clear(); }
+
+		SparseMatrix Build() const { return SparseMatrix::FromTriplets(rows, cols, triplets); }
+	private:
+		uint32_t rows = 0;
+		uint32_t cols = 0;
+		std::vector<Triplet> triplets;
+	};
+}
+
+#endif // !SPARSE_MATRIX_H
\ No newline at end of file
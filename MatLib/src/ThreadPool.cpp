@@ -0,0 +1,76 @@
+#include "ThreadPool.h"
+#include "Parallel.h"
+
+namespace MatLib {
+	ThreadPool::ThreadPool(size_t threads) {
+		if (threads == 0)
+			threads = HardwareThreads();
+		for (size_t t = 1; t < threads; t++)
+			workers.emplace_back([this, t]() { Work(t); });
+	}
+
+	ThreadPool& ThreadPool::Shared() {
+		static ThreadPool pool;
+		return pool;
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	void ThreadPool::Dispatch(size_t count, const std::function<void(size_t, size_t)>& job) {
+		if (count == 0)
+			return;
+		if (workers.empty() || count == 1) {
+			for (size_t i = 0; i < count; i++)
+				job(i, 0);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			this->job = &job;
+			this->count = count;
+			next = 0;
+			active = workers.size();
+			generation++;
+		}
+		wake.notify_all();
+
+		Drain(0);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this]() { return active == 0; });
+		this->job = nullptr;
+	}
+
+	void ThreadPool::Work(size_t thread) {
+		uint64_t seen = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&]() { return stopping || generation != seen; });
+				if (stopping)
+					return;
+				seen = generation;
+			}
+
+			Drain(thread);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--active == 0)
+				done.notify_one();
+		}
+	}
+
+	void ThreadPool::Drain(size_t thread) {
+		for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+			(*job)(i, thread);
+	}
+}
\ No newline at end of file
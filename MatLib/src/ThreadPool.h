@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MatLib {
+	//Persistent workers for jobs that run every frame, the calling thread takes part as thread 0
+	class ThreadPool {
+	public:
+		ThreadPool(size_t threads = 0);
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		size_t Threads() const { return workers.size() + 1; }
+
+		//One pool per process for the numeric kernels (GEMM, sparse products), started on first use
+		static ThreadPool& Shared();
+
+		//Calls fn(index, thread) for every index in [0, count), indices are handed out one at a time so uneven jobs balance
+		template <typename Fn>
+		void Run(size_t count, const Fn& fn) {
+			Dispatch(count, [&fn](size_t index, size_t thread) { fn(index, thread); });
+		}
+	private:
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable done;
+
+		const std::function<void(size_t, size_t)>* job = nullptr;
+		std::atomic<size_t> next{ 0 };
+		size_t count = 0;
+		size_t active = 0;
+		uint64_t generation = 0;
+		bool stopping = false;
+	private:
+		void Dispatch(size_t count, const std::function<void(size_t, size_t)>& job);
+		void Work(size_t thread);
+		void Drain(size_t thread);
+	};
+}
+
+#endif // !THREAD_POOL_H
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "VirtualMachine.h"
+
+#include <cmath>
+
+namespace MatLib {
+	static inline bool MemoFind(MemoTable* memo, const double* args, uint32_t count, double& value) {
+		return memo && memo->Find(args, count, value);
+	}
+
+	static inline void MemoInsert(MemoTable* memo, const double* args, uint32_t count, double value) {
+		if (memo)
+			memo->Insert(args, count, value);
+	}
+
+	template <typename T>
+	static inline bool MemoFind(MemoTable*, const T*, uint32_t, T&) {
+		return false;
+	}
+
+	template <typename T>
+	static inline void MemoInsert(MemoTable*, const T*, uint32_t, const T&) { }
+
+	//Same dispatch loop for every numeric mode, the stacks, environment and call frames are sized by the caller.
+	//A call leaves its arguments on the value stack as the callee's frame and only saves the return address
+	template <typename T>
+	static T Execute(const Chunk& chunk, const T* inputs, T* base, T* tp, T* env, CallFrame* frames, MemoTable* memos) {
+		const Instruction* code = chunk.code.data();
+		const Instruction* ip = code;
+		const double* constants = chunk.constants.data();
+		T* sp = base;
+		T* fp = base;
+		CallFrame* cp = frames;
+
+		for (;;) {
+			switch (ip->op) {
+			case OP_CONST:
+				*sp++ = T(constants[ip->operand]);
+				break;
+			case OP_INPUT:
+				*sp++ = inputs[ip->operand];
+				break;
+			case OP_NEGATE:
+				sp[-1] = -sp[-1];
+				break;
+			case OP_ADD:
+				sp--;
+				sp[-1] = sp[-1] + sp[0];
+				break;
+			case OP_SUB:
+				sp--;
+				sp[-1] = sp[-1] - sp[0];
+				break;
+			case OP_MUL:
+				sp--;
+				sp[-1] = sp[-1] * sp[0];
+				break;
+			case OP_DIV:
+				sp--;
+				sp[-1] = sp[-1] / sp[0];
+				break;
+			case OP_POW:
+				sp--;
+				sp[-1] = Pow(sp[-1], sp[0]);
+				break;
+			case OP_LOAD_TEMP:
+				*sp++ = tp[ip->operand];
+				break;
+			case OP_STORE_TEMP:
+				tp[ip->operand] = sp[-1];
+				break;
+			case OP_LOAD_VAR:
+				*sp++ = env[ip->operand];
+				break;
+			case OP_STORE_VAR:
+				env[ip->operand] = *--sp;
+				break;
+			case OP_POP_TEMP:
+				tp[ip->operand] = *--sp;
+				break;
+			case OP_LOAD_ARG:
+				*sp++ = fp[ip->operand];
+				break;
+			case OP_CALL:
+				cp->ip = ip;
+				cp->fp = (uint32_t)(fp - base);
+				cp->memo = nullptr;
+				cp++;
+				fp = sp - ip->count;
+				ip = code + ip->operand;
+				continue;
+			case OP_CALL_MEMO: {
+				const MemoSite& site = chunk.memo_sites[ip->operand];
+				MemoTable* memo = (memos) ? &memos[site.memo] : nullptr;
+				T* args = sp - ip->count;
+				if (MemoFind(memo, args, ip->count, args[0])) {
+					sp = args + 1;
+					break;
+				}
+				cp->ip = ip;
+				cp->fp = (uint32_t)(fp - base);
+				cp->count = ip->count;
+				cp->memo = memo;
+				cp++;
+				fp = args;
+				ip = code + site.entry;
+				continue;
+			}
+			case OP_CALL_BUILTIN:
+				sp -= ip->count;
+				sp[0] = Builtins::Apply<T>(ip->operand, sp);
+				sp++;
+				break;
+			case OP_RET: {
+				T result = sp[-1];
+				MemoInsert(cp[-1].memo, fp, cp[-1].count, result);
+				sp = fp;
+				*sp++ = result;
+				cp--;
+				fp = base + cp->fp;
+				ip = cp->ip;
+				break;
+			}
+			case OP_RETURN:
+				return (sp > base) ? sp[-1] : T(0.0);
+			default:
+				return T(0.0);
+			}
+			ip++;
+		}
+	}
+
+	double VirtualMachine::Run(const Chunk& chunk, double x, double y) {
+		if (stack.size() < chunk.max_stack)
+			stack.resize(chunk.max_stack);
+		if (temps.size() < chunk.temps)
+			temps.resize(chunk.temps);
+		if (environment.size() < chunk.slots)
+			environment.resize(chunk.slots);
+		if (frames.size() < chunk.frames)
+			frames.resize(chunk.frames);
+		if (chunk.memos) {
+			if (memo_program != chunk.program) {
+				ClearMemos();
+				memo_program = chunk.program;
+			}
+			if (memos.size() < chunk.memos)
+				memos.resize(chunk.memos);
+			for (auto& site : chunk.memo_sites)
+				memos[site.memo].Reserve();
+		}
+		double inputs[COMPILER_INPUTS] = { x, y };
+		return Execute<double>(chunk, inputs, stack.data(), temps.data(), environment.data(), frames.data(), memos.data());
+	}
+
+	Interval VirtualMachine::RunInterval(const Chunk& chunk, const Interval& x, const Interval& y) {
+		if (interval_stack.size() < chunk.max_stack)
+			interval_stack.resize(chunk.max_stack);
+		if (interval_temps.size() < chunk.temps)
+			interval_temps.resize(chunk.temps);
+		if (interval_environment.size() < chunk.slots)
+			interval_environment.resize(chunk.slots);
+		if (frames.size() < chunk.frames)
+			frames.resize(chunk.frames);
+		Interval inputs[COMPILER_INPUTS] = { x, y };
+		return Execute<Interval>(chunk, inputs, interval_stack.data(), interval_temps.data(), interval_environment.data(), frames.data(), nullptr);
+	}
+
+	void VirtualMachine::ClearMemos() {
+		for (auto& memo : memos)
+			memo.Clear();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef VIRTUAL_MACHINE_H
+#define VIRTUAL_MACHINE_H
+
+#include "Compiler.h"
+#include "Builtins.h"
+#include "MemoTable.h"
+
+namespace MatLib {
+	struct CallFrame {
+		const Instruction* ip = nullptr;
+		uint32_t fp = 0;
+		uint32_t count = 0;
+		MemoTable* memo = nullptr;
+	};
+
+	class VirtualMachine {
+	public:
+		VirtualMachine() = default;
+
+		double Run(const Chunk& chunk, double x = 0.0, double y = 0.0);
+		Interval RunInterval(const Chunk& chunk, const Interval& x, const Interval& y = Interval(0.0));
+
+		//Tables are per machine, so threads never share one. Only the double mode reads and fills them
+		const std::vector<MemoTable>& Memos() const { return memos; }
+		void ClearMemos();
+	private:
+		std::vector<double> stack;
+		std::vector<double> temps;
+		std::vector<Interval> interval_stack;
+		std::vector<Interval> interval_temps;
+		std::vector<double> environment;
+		std::vector<Interval> interval_environment;
+		std::vector<CallFrame> frames;
+		std::vector<MemoTable> memos;
+		uint64_t memo_program = 0;
+	};
+}
+
+#endif // !VIRTUAL_MACHINE_H
\ No newline at end of file
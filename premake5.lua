@@ -50,6 +50,12 @@ project "MatLib"
 	filter "system:windows"
 		systemversion "latest"
 
+	filter "toolset:msc*"
+		buildoptions "/fp:precise"
+
+	filter "toolset:gcc or toolset:clang"
+		buildoptions "-ffp-contract=off"
+
 	filter "configurations:Debug"
 		defines "EMBER_DEBUG"
 		runtime "Debug"